@@ -0,0 +1,37 @@
+#include "allocationcount.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Zastąpione są tylko operator new(size_t) i operator delete - domyślne wersje tablicowe i nothrow
+// idą według standardu przez nie. Wersje z align_val_t (typy alignas > 16) zostają domyślne i nie są liczone.
+
+namespace
+{
+    std::atomic<uint64_t> allocationCount {0};
+}
+
+uint64_t heapAllocationCount()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if(void* memory = std::malloc(size != 0 ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,9 @@
+#ifndef ALLOCATIONCOUNT_H
+#define ALLOCATIONCOUNT_H
+#include <cstdint>
+
+// Liczba wywołań globalnego operator new od startu procesu, ze wszystkich wątków.
+// Do sprawdzania, że ramka w stanie ustalonym niczego nie alokuje (--check-allocations).
+uint64_t heapAllocationCount();
+
+#endif // ALLOCATIONCOUNT_H
@@ -0,0 +1,324 @@
+#include "benchmark.h"
+#include "commandlog.h"
+#include "engine.h"
+#include "log.h"
+#include "mathlib.h"
+#include "scene.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+
+SampleStatistics computeStatistics(std::vector<double> samples)
+{
+    SampleStatistics statistics;
+    if(samples.empty())
+    {
+        return statistics;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    statistics.count = samples.size();
+    statistics.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    statistics.median = samples[samples.size() / 2];
+    statistics.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    statistics.max = samples.back();
+    return statistics;
+}
+
+void logStatistics(std::string_view label, std::string_view unit, const SampleStatistics& statistics)
+{
+    logger::info(label, ": ", statistics.count, " samples, mean ", std::fixed, std::setprecision(2), statistics.mean, " ", unit,
+                 ", median ", statistics.median, " ", unit, ", p99 ", statistics.p99, " ", unit, ", max ", statistics.max, " ", unit);
+}
+
+void runRenderBenchmark(uint32_t frameCount)
+{
+    const uint32_t warmupFrames = std::min<uint32_t>(frameCount / 10, 100); // pierwsze ramki płacą za leniwą inicjalizację sterownika
+
+    SampleStatistics results[2];
+    const Profile profiles[2] = {Profile::Release, Profile::Debug};
+
+    for(int i = 0; i < 2; i++)
+    {
+        EngineSettings settings;
+        settings.profile = profiles[i];
+        settings.vsync = false; // z v-sync render() mierzyłby głównie czekanie na vblank
+
+        Engine engine(settings);
+        std::vector<double> renderTimes = engine.benchmarkRender(frameCount + warmupFrames);
+        renderTimes.erase(renderTimes.begin(), renderTimes.begin() + std::min<size_t>(warmupFrames, renderTimes.size()));
+
+        results[i] = computeStatistics(std::move(renderTimes));
+        logStatistics(std::string("render() ") + profileName(profiles[i]), "us", results[i]);
+        const DrawQueueStats drawStats = engine.drawStats();
+        logger::info("last frame: ", drawStats.draws, " queued draws, ", drawStats.drawCalls, " draw calls (", drawStats.mergedDraws, " merged), ",
+                     drawStats.pipelineBinds, " pipeline binds, ", drawStats.vertexBufferBinds, " vertex buffer binds, ",
+                     drawStats.indexBufferBinds, " index buffer binds, ", drawStats.elidedBinds, " elided");
+    }
+
+    if(results[0].mean > 0)
+    {
+        logger::info("render() debug profile overhead: ", std::fixed, std::setprecision(2), results[1].mean - results[0].mean,
+                     " us per frame (", (results[1].mean / results[0].mean - 1.0) * 100.0, "%)");
+    }
+}
+
+bool runAllocationCheck(uint32_t frameCount)
+{
+    // pierwsze ramki mają prawo alokować: bufory rosną do rozmiaru sceny, cache command bufferów się zapełnia
+    constexpr uint32_t warmupFrames = 100;
+    bool passed = true;
+
+    for(const bool cacheCommandBuffers : {false, true})
+    {
+        EngineSettings settings;
+        settings.vsync = false;
+        settings.cacheCommandBuffers = cacheCommandBuffers;
+
+        Engine engine(settings);
+        Scene& scene = engine.scene();
+        constexpr int gridSize = 16;
+        for(int i = 0; i < gridSize * gridSize; i++)
+        {
+            LocalTransform transform;
+            transform.position = {(i % gridSize - gridSize / 2) * 2.0f, 0.0f, (i / gridSize - gridSize / 2) * 2.0f};
+            scene.createInstance(transform);
+        }
+        scene.camera().position = {0.0f, 20.0f, 40.0f};
+
+        // jedna instancja rusza się co drugą setkę ramek, więc sprawdzane są i ramki ze zmianami, i statyczne (z cache)
+        const Entity moving = scene.createInstance();
+        const auto update = [&scene, moving](uint32_t frame)
+        {
+            if(frame / 100 % 2 == 0)
+            {
+                LocalTransform transform;
+                transform.position = {std::sin(frame * 0.05f) * 10.0f, 2.0f, 0.0f};
+                scene.setLocalTransform(moving, transform);
+            }
+        };
+
+        const std::vector<uint64_t> allocations = engine.countFrameAllocations(warmupFrames + frameCount, update);
+        uint64_t total = 0;
+        size_t allocatingFrames = 0;
+        for(size_t frame = std::min<size_t>(warmupFrames, allocations.size()); frame < allocations.size(); frame++)
+        {
+            total += allocations[frame];
+            allocatingFrames += allocations[frame] != 0;
+        }
+
+        const char* mode = cacheCommandBuffers ? "with cached command buffers" : "without cached command buffers";
+        if(total != 0)
+        {
+            logger::error("render() ", mode, ": ", total, " heap allocations in ", allocatingFrames, " of ", frameCount, " steady-state frames");
+            passed = false;
+        }
+        else
+        {
+            logger::info("render() ", mode, ": no heap allocations in ", frameCount, " steady-state frames");
+        }
+    }
+    return passed;
+}
+
+void runParticleBenchmark(uint32_t frameCount, uint32_t maxParticleCount)
+{
+    const uint32_t warmupFrames = std::min<uint32_t>(frameCount / 10, 100);
+
+    // od 1/16 do pełnej liczby - przy małych liczbach widać stały koszt dispatchu, przy dużych przepustowość pamięci
+    for(uint32_t particleCount = std::max(maxParticleCount / 16, 1u); ; particleCount = std::min(particleCount * 4, maxParticleCount))
+    {
+        EngineSettings settings;
+        settings.profile = Profile::Release;
+        settings.vsync = false;
+        settings.particleCount = particleCount;
+
+        Engine engine(settings);
+        std::vector<double> simulationTimes = engine.benchmarkParticles(frameCount + warmupFrames);
+        simulationTimes.erase(simulationTimes.begin(), simulationTimes.begin() + std::min<size_t>(warmupFrames, simulationTimes.size()));
+        if(simulationTimes.empty())
+        {
+            logger::warning("particles: no GPU timestamps on this queue, cannot measure the simulation");
+            return;
+        }
+
+        const SampleStatistics statistics = computeStatistics(std::move(simulationTimes));
+        logStatistics("particle simulation " + std::to_string(particleCount), "ms", statistics);
+        logger::info("particles: ", particleCount, " in ", std::fixed, std::setprecision(3), statistics.median, " ms, ",
+                     std::setprecision(0), particleCount / statistics.median, " particles/ms");
+
+        if(particleCount == maxParticleCount)
+        {
+            break;
+        }
+    }
+}
+
+void runReplay(const std::string& path, EngineSettings settings, bool realtime)
+{
+    CommandLog log(path);
+    log.applySettings(settings);
+    if(!realtime)
+    {
+        settings.vsync = false; // inaczej mierzylibyśmy vblank
+    }
+    logger::info("replaying ", log.frameCount(), " frames from ", path, realtime ? " at the recorded cadence" : " as fast as possible");
+
+    Engine engine(settings);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<double> renderTimes = engine.replay(log, realtime);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    logStatistics(std::string("replay render() ") + profileName(settings.profile), "us", computeStatistics(std::move(renderTimes)));
+    logger::info("replay took ", std::fixed, std::setprecision(3), seconds, " s");
+}
+
+void runSceneBenchmark(uint32_t frameCount, uint32_t staticCount, uint32_t movingCount)
+{
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    Scene scene;
+    std::vector<Entity> moving;
+    moving.reserve(movingCount);
+
+    const uint32_t side = static_cast<uint32_t>(std::cbrt(double(staticCount))) + 1;
+    for(uint32_t i = 0; i < staticCount; i++)
+    {
+        LocalTransform transform;
+        transform.position = {float(i % side), float(i / side % side), float(i / (side * side))};
+        scene.createInstance(transform);
+    }
+    for(uint32_t i = 0; i < movingCount; i++)
+    {
+        moving.push_back(scene.createInstance());
+    }
+
+    // pierwsza klatka przelicza wszystko - to jest punkt odniesienia dla kosztu pełnego przejścia
+    auto start = std::chrono::steady_clock::now();
+    scene.updateTransforms();
+    const double fullUpdate = Microseconds(std::chrono::steady_clock::now() - start).count();
+    logger::info("scene: ", staticCount, " static + ", movingCount, " moving instances, full update ", std::fixed, std::setprecision(2),
+                 fullUpdate, " us, ", scene.changedInstances().size(), " records changed");
+    scene.clearChanges();
+
+    std::vector<double> updateTimes;
+    updateTimes.reserve(frameCount);
+    size_t changedRecords = 0;
+
+    for(uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < movingCount; i++)
+        {
+            LocalTransform transform;
+            transform.position = {std::sin(frame * 0.01f + i), std::cos(frame * 0.01f + i), -float(i)};
+            scene.setLocalTransform(moving[i], transform);
+        }
+        scene.updateTransforms();
+        updateTimes.push_back(Microseconds(std::chrono::steady_clock::now() - start).count());
+
+        changedRecords += scene.changedInstances().size();
+        scene.clearChanges();
+    }
+
+    logStatistics("scene update", "us", computeStatistics(std::move(updateTimes)));
+    logger::info("scene: ", frameCount > 0 ? changedRecords / frameCount : 0, " records changed per frame");
+}
+
+namespace
+{
+    // najlepszy z kilku przebiegów - szum planisty i częstotliwości zegara wypaczają średnią
+    double bestOf(int runs, const std::function<void()>& body)
+    {
+        double best = 0;
+        for(int run = 0; run < runs; run++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            body();
+            const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best = run == 0 ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    }
+
+    void logComparison(std::string_view label, double scalarMilliseconds, double simdMilliseconds, uint32_t count, double maxError)
+    {
+        logger::info(label, ": scalar ", std::fixed, std::setprecision(3), scalarMilliseconds * 1e6 / count, " ns, simd ",
+                     simdMilliseconds * 1e6 / count, " ns per item, speedup ", scalarMilliseconds / simdMilliseconds, "x, max error ", maxError);
+    }
+}
+
+void runMathBenchmark(uint32_t iterations)
+{
+    constexpr int runs = 5;
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+
+    /*------ mnożenie macierzy -----*/
+    std::vector<Matrix4> matrices(iterations);
+    for(auto& matrix : matrices)
+    {
+        matrix = composeTransform({distribution(random), distribution(random), distribution(random)},
+                                  fromAxisAngle(normalize(Vector3{distribution(random), distribution(random), 1.0f}), distribution(random)),
+                                  {1.0f, 1.0f, 1.0f});
+    }
+    const Matrix4 parent = composeTransform({1.0f, 2.0f, 3.0f}, fromAxisAngle({0.0f, 1.0f, 0.0f}, 0.5f), {2.0f, 2.0f, 2.0f});
+    std::vector<Matrix4> scalarProducts(iterations);
+    std::vector<Matrix4> simdProducts(iterations);
+
+    const double scalarMultiply = bestOf(runs, [&]{ for(uint32_t i = 0; i < iterations; i++) scalarProducts[i] = scalar::multiply(parent, matrices[i]); });
+    const double simdMultiply = bestOf(runs, [&]{ for(uint32_t i = 0; i < iterations; i++) simdProducts[i] = multiply(parent, matrices[i]); });
+
+    double maxError = 0;
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        for(int k = 0; k < 16; k++)
+        {
+            maxError = std::max<double>(maxError, std::fabs(scalarProducts[i].data()[k] - simdProducts[i].data()[k]));
+        }
+    }
+    logComparison("mat4 multiply", scalarMultiply, simdMultiply, iterations, maxError);
+
+    /*--- transformacja punktów ----*/
+    std::vector<Vector3> points(iterations);
+    for(auto& point : points)
+    {
+        point = {distribution(random), distribution(random), distribution(random)};
+    }
+    std::vector<Vector3> scalarPoints(iterations);
+    std::vector<Vector3> simdPoints(iterations);
+
+    const double scalarTransform = bestOf(runs, [&]{ scalar::transformPoints(parent, points.data(), scalarPoints.data(), iterations); });
+    const double simdTransform = bestOf(runs, [&]{ transformPoints(parent, points.data(), simdPoints.data(), iterations); });
+
+    maxError = 0;
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        maxError = std::max<double>(maxError, length(scalarPoints[i] - simdPoints[i]));
+    }
+    logComparison("transform points", scalarTransform, simdTransform, iterations, maxError);
+
+    /*------- sfery z frustum ------*/
+    Plane planes[6];
+    extractFrustumPlanes(multiply(perspective(1.0f, 16.0f / 9.0f, 0.1f, 100.0f), lookAt({0.0f, 0.0f, 20.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f})), planes);
+
+    std::vector<Sphere> spheres(iterations);
+    for(auto& sphere : spheres)
+    {
+        sphere = {distribution(random) * 3.0f, distribution(random) * 3.0f, distribution(random) * 3.0f, std::fabs(distribution(random)) * 0.1f};
+    }
+    std::vector<uint8_t> scalarVisible(iterations);
+    std::vector<uint8_t> simdVisible(iterations);
+
+    const double scalarCull = bestOf(runs, [&]{ scalar::cullSpheres(planes, spheres.data(), iterations, scalarVisible.data()); });
+    const double simdCull = bestOf(runs, [&]{ cullSpheres(planes, spheres.data(), iterations, simdVisible.data()); });
+
+    const size_t mismatches = std::inner_product(scalarVisible.begin(), scalarVisible.end(), simdVisible.begin(), size_t(0),
+                                                 std::plus<size_t>(), std::not_equal_to<uint8_t>());
+    logComparison("cull spheres", scalarCull, simdCull, iterations, double(mismatches));
+}
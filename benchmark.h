@@ -0,0 +1,39 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include "settings.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct SampleStatistics
+{
+    size_t count = 0;
+    double mean = 0;
+    double median = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+SampleStatistics computeStatistics(std::vector<double> samples);
+void logStatistics(std::string_view label, std::string_view unit, const SampleStatistics& statistics);
+
+// uruchamia silnik kolejno w profilu release i debug (bez v-sync) i porównuje czas render()
+void runRenderBenchmark(uint32_t frameCount);
+
+// po rozgrzewce liczy alokacje na stercie w render() (z cache command bufferów i bez) - false, jeśli jakakolwiek ramka alokowała
+bool runAllocationCheck(uint32_t frameCount);
+
+// symulacja cząsteczek na GPU dla kilku liczb cząsteczek aż do maxParticleCount - czas dispatchu z timestampów i przepustowość
+void runParticleBenchmark(uint32_t frameCount, uint32_t maxParticleCount);
+
+// powtórka nagrania z --record: obciążenie z pliku, profil z settings; bez realtime ramki idą bez przerw i bez v-sync
+void runReplay(const std::string& path, EngineSettings settings, bool realtime);
+
+// mnożenie macierzy, transformacja punktów i test sfer z frustum: wersja skalarna kontra SIMD
+void runMathBenchmark(uint32_t iterations);
+
+// sama scena, bez GPU: staticCount nieruchomych instancji i movingCount poruszanych co klatkę
+void runSceneBenchmark(uint32_t frameCount, uint32_t staticCount = 1000000, uint32_t movingCount = 1000);
+
+#endif // BENCHMARK_H
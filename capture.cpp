@@ -0,0 +1,271 @@
+#include "capture.h"
+#include "log.h"
+#include "trace.h"
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CAPTURE_SSE2 1
+#endif
+
+namespace
+{
+    constexpr size_t fileBufferSize = 8 << 20; // duże, sekwencyjne zapisy zamiast tysięcy małych
+
+    bool isBgra(VkFormat format)
+    {
+        return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+
+    bool isRgba(VkFormat format)
+    {
+        return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+    }
+
+    // zamienia bajty 0 i 2 każdego piksela, czyli BGRA <-> RGBA
+    void swizzleBgraToRgba(uint8_t* pixels, size_t pixelCount)
+    {
+        size_t i = 0;
+#ifdef CAPTURE_SSE2
+        const __m128i keep = _mm_set1_epi32(0xFF00FF00);
+        const __m128i low = _mm_set1_epi32(0x000000FF);
+        const __m128i high = _mm_set1_epi32(0x00FF0000);
+        for(; i + 4 <= pixelCount; i += 4)
+        {
+            __m128i* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+            const __m128i v = _mm_loadu_si128(p);
+            const __m128i swapped = _mm_or_si128(_mm_and_si128(v, keep),
+                                    _mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 16), high),
+                                                 _mm_and_si128(_mm_srli_epi32(v, 16), low)));
+            _mm_storeu_si128(p, swapped);
+        }
+#endif
+        for(; i < pixelCount; i++)
+        {
+            std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+        }
+    }
+
+    // BT.601, zakres ograniczony (16-235) - tego domyślnie oczekują odtwarzacze Y4M
+    void rgbaToYuv444(const uint8_t* rgba, size_t pixelCount, uint8_t* y, uint8_t* u, uint8_t* v)
+    {
+        for(size_t i = 0; i < pixelCount; i++)
+        {
+            const int r = rgba[i * 4];
+            const int g = rgba[i * 4 + 1];
+            const int b = rgba[i * 4 + 2];
+            y[i] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            u[i] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            v[i] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+const char* captureFormatName(CaptureFormat format)
+{
+    return format == CaptureFormat::Raw ? "raw rgba" : "y4m";
+}
+
+const char* capturePolicyName(CapturePolicy policy)
+{
+    return policy == CapturePolicy::Block ? "block" : "drop newest";
+}
+
+FrameCapture::FrameCapture(const CaptureSettings& settings)
+    : mSettings(settings)
+{
+    if(mSettings.queueDepth == 0)
+    {
+        mSettings.queueDepth = 1;
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    stop();
+}
+
+void FrameCapture::start(const ReadbackFrame& frame)
+{
+    mStarted = true;
+
+    if(!isBgra(frame.format) && !isRgba(frame.format))
+    {
+        logger::error("capture: unsupported swapchain format ", frame.format);
+        mFailed = true;
+        return;
+    }
+
+    mFile = std::fopen(mSettings.path.c_str(), "wb");
+    if(mFile == nullptr)
+    {
+        logger::error("capture: failed to open ", mSettings.path);
+        mFailed = true;
+        return;
+    }
+    std::setvbuf(mFile, nullptr, _IOFBF, fileBufferSize);
+
+    mWidth = frame.width;
+    mHeight = frame.height;
+    mSwizzle = isBgra(frame.format);
+
+    // cała pamięć zajmowana od razu - w trakcie nagrywania nie ma już alokacji
+    const size_t frameSize = size_t(mWidth) * mHeight * 4;
+    mSlots.assign(mSettings.queueDepth, std::vector<uint8_t>(frameSize));
+    mFreeSlots.reserve(mSettings.queueDepth);
+    for(uint32_t i = 0; i < mSettings.queueDepth; i++)
+    {
+        mFreeSlots.push_back(i);
+    }
+
+    if(mSettings.format == CaptureFormat::Y4M)
+    {
+        mPlanes.resize(size_t(mWidth) * mHeight * 3);
+        std::fprintf(mFile, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", mWidth, mHeight, mSettings.frameRate);
+    }
+
+    logger::info("capture: ", mWidth, "x", mHeight, " ", captureFormatName(mSettings.format), " -> ", mSettings.path,
+                 ", queue ", mSettings.queueDepth, ", policy: ", capturePolicyName(mSettings.policy));
+
+    mWriter = std::thread(&FrameCapture::writerLoop, this);
+}
+
+void FrameCapture::push(const ReadbackFrame& frame)
+{
+    if(!mStarted)
+    {
+        start(frame);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mStatistics.received++;
+
+    if(mFailed || mStopping || frame.width != mWidth || frame.height != mHeight)
+    {
+        mStatistics.dropped++;
+        return;
+    }
+
+    if(mFreeSlots.empty())
+    {
+        if(mSettings.policy == CapturePolicy::DropNewest)
+        {
+            mStatistics.dropped++;
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        mSlotFreed.wait(lock, [this]{ return !mFreeSlots.empty(); });
+        mStatistics.blockedMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const uint32_t slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    lock.unlock();
+
+    // slot należy teraz tylko do nas - kopiujemy bez blokady
+    uint8_t* destination = mSlots[slot].data();
+    const size_t rowSize = size_t(mWidth) * 4;
+    if(frame.rowPitch == rowSize)
+    {
+        std::memcpy(destination, frame.pixels, rowSize * mHeight);
+    }
+    else
+    {
+        for(uint32_t row = 0; row < mHeight; row++)
+        {
+            std::memcpy(destination + row * rowSize, frame.pixels + size_t(row) * frame.rowPitch, rowSize);
+        }
+    }
+
+    lock.lock();
+    mReadySlots.push_back(slot);
+    lock.unlock();
+    mFrameReady.notify_one();
+}
+
+void FrameCapture::writerLoop()
+{
+    trace::setThreadName("capture writer");
+    while(true)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mFrameReady.wait(lock, [this]{ return !mReadySlots.empty() || mStopping; });
+        if(mReadySlots.empty())
+        {
+            break; // mStopping i kolejka pusta
+        }
+
+        const uint32_t slot = mReadySlots.front();
+        mReadySlots.pop_front();
+        lock.unlock();
+
+        writeFrame(mSlots[slot]);
+
+        lock.lock();
+        mFreeSlots.push_back(slot);
+        mStatistics.written++;
+        lock.unlock();
+        mSlotFreed.notify_one();
+    }
+}
+
+void FrameCapture::writeFrame(std::vector<uint8_t>& pixels)
+{
+    TRACE_SCOPE("write frame");
+    const size_t pixelCount = size_t(mWidth) * mHeight;
+    if(mSwizzle)
+    {
+        swizzleBgraToRgba(pixels.data(), pixelCount);
+    }
+
+    if(mSettings.format == CaptureFormat::Raw)
+    {
+        std::fwrite(pixels.data(), 1, pixels.size(), mFile);
+        return;
+    }
+
+    uint8_t* y = mPlanes.data();
+    rgbaToYuv444(pixels.data(), pixelCount, y, y + pixelCount, y + 2 * pixelCount);
+
+    std::fputs("FRAME\n", mFile);
+    std::fwrite(mPlanes.data(), 1, mPlanes.size(), mFile);
+}
+
+void FrameCapture::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(mStopping)
+        {
+            return;
+        }
+        mStopping = true;
+    }
+    mFrameReady.notify_one();
+
+    if(mWriter.joinable())
+    {
+        mWriter.join();
+    }
+    if(mFile != nullptr)
+    {
+        std::fclose(mFile);
+        mFile = nullptr;
+    }
+
+    if(mStarted)
+    {
+        const CaptureStatistics stats = statistics();
+        logger::info("capture: ", stats.written, " frames written, ", stats.dropped, " dropped of ", stats.received,
+                     ", render blocked ", stats.blockedMilliseconds, " ms (policy: ", capturePolicyName(mSettings.policy), ")");
+    }
+}
+
+CaptureStatistics FrameCapture::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStatistics;
+}
@@ -0,0 +1,86 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+#include "readback.h"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat
+{
+    Raw, // ciąg klatek RGBA8 bez nagłówka, np. ffmpeg -f rawvideo -pix_fmt rgba -s WxH
+    Y4M  // YUV4MPEG2, 4:4:4 BT.601
+};
+
+enum class CapturePolicy
+{
+    Block,     // render czeka na wolny slot - nic nie ginie, ale czasy ramek są zafałszowane
+    DropNewest // klatka bez wolnego slotu jest pomijana - render nigdy nie czeka
+};
+
+struct CaptureSettings
+{
+    std::string path;
+    CaptureFormat format = CaptureFormat::Y4M;
+    CapturePolicy policy = CapturePolicy::DropNewest;
+    uint32_t queueDepth = 8; // tyle klatek może czekać na zapis
+    uint32_t interval = 1;   // co która ramka
+    uint32_t frameRate = 60; // tylko do nagłówka Y4M
+};
+
+struct CaptureStatistics
+{
+    uint64_t received = 0;
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+    double blockedMilliseconds = 0; // łączny czas, przez który render czekał (tylko Block)
+};
+
+const char* captureFormatName(CaptureFormat format);
+const char* capturePolicyName(CapturePolicy policy);
+
+// Strumieniowy zapis klatek z readbacku. push() tylko kopiuje piksele do wcześniej zaalokowanego slotu,
+// konwersja formatu i zapis na dysk odbywają się w osobnym wątku.
+class FrameCapture
+{
+public:
+    explicit FrameCapture(const CaptureSettings& settings);
+    ~FrameCapture();
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    void push(const ReadbackFrame& frame); // z callbacku readbacku, wątek renderu
+    void stop();                            // dopisuje kolejkę do końca, zamyka plik i wypisuje statystyki
+    CaptureStatistics statistics() const;
+
+private:
+    void start(const ReadbackFrame& frame); // przy pierwszej klatce - dopiero wtedy znamy rozmiar i format
+    void writerLoop();
+    void writeFrame(std::vector<uint8_t>& pixels);
+
+    CaptureSettings mSettings;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    bool mSwizzle = false; // BGRA -> RGBA
+    bool mStarted = false;
+    bool mFailed = false;
+
+    std::vector<std::vector<uint8_t>> mSlots;
+    std::vector<uint32_t> mFreeSlots;
+    std::deque<uint32_t> mReadySlots;
+    std::vector<uint8_t> mPlanes; // bufor wyjściowy Y4M, używany tylko przez wątek zapisu
+
+    mutable std::mutex mMutex;
+    std::condition_variable mSlotFreed;
+    std::condition_variable mFrameReady;
+    bool mStopping = false;
+    CaptureStatistics mStatistics;
+
+    std::FILE* mFile = nullptr;
+    std::thread mWriter;
+};
+
+#endif // CAPTURE_H
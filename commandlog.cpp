@@ -0,0 +1,364 @@
+#include "commandlog.h"
+#include "log.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // kursor po zmapowanym pliku - każdy odczyt sprawdza, czy mieści się w pliku
+    class Reader
+    {
+    public:
+        Reader(const uint8_t* data, size_t size, size_t offset, const std::string& path) : mData(data), mSize(size), mOffset(offset), mPath(path) {}
+
+        template<typename T>
+        T read()
+        {
+            if(mSize - mOffset < sizeof(T))
+            {
+                throw std::runtime_error(mPath + " is truncated");
+            }
+            T value;
+            std::memcpy(&value, mData + mOffset, sizeof(T));
+            mOffset += sizeof(T);
+            return value;
+        }
+
+        std::string readString()
+        {
+            const uint32_t length = read<uint32_t>();
+            if(mSize - mOffset < length)
+            {
+                throw std::runtime_error(mPath + " is truncated");
+            }
+            std::string value(reinterpret_cast<const char*>(mData + mOffset), length);
+            mOffset += length;
+            return value;
+        }
+
+        Entity readEntity()
+        {
+            Entity entity;
+            entity.index = read<uint32_t>();
+            entity.generation = read<uint32_t>();
+            return entity;
+        }
+
+        Vector3 readVector3()
+        {
+            const float x = read<float>();
+            const float y = read<float>();
+            const float z = read<float>();
+            return {x, y, z};
+        }
+
+        LocalTransform readTransform()
+        {
+            LocalTransform transform;
+            transform.position = readVector3();
+            transform.rotation.x = read<float>();
+            transform.rotation.y = read<float>();
+            transform.rotation.z = read<float>();
+            transform.rotation.w = read<float>();
+            transform.scale = readVector3();
+            return transform;
+        }
+
+        Camera readCamera()
+        {
+            Camera camera;
+            camera.position = readVector3();
+            camera.target = readVector3();
+            camera.fovY = read<float>();
+            camera.nearPlane = read<float>();
+            camera.farPlane = read<float>();
+            return camera;
+        }
+
+        bool atEnd() const { return mOffset == mSize; }
+        size_t offset() const { return mOffset; }
+
+    private:
+        const uint8_t* mData;
+        size_t mSize;
+        size_t mOffset;
+        const std::string& mPath;
+    };
+
+    uint64_t entityKey(Entity entity)
+    {
+        return (uint64_t(entity.index) << 32) | entity.generation;
+    }
+}
+
+/*---------- recorder ----------*/
+
+CommandRecorder::CommandRecorder(const std::string& path, const EngineSettings& settings)
+    : mPath(path)
+{
+    mFile = std::fopen(path.c_str(), "wb");
+    if(mFile == nullptr)
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+
+    write(commandLogMagic);
+    write(commandLogVersion);
+    write(static_cast<uint32_t>(settings.vertexLayout));
+    write(uint8_t(settings.occlusionCulling));
+    write(uint8_t(settings.cacheCommandBuffers));
+    write(settings.outputCount);
+    write(settings.memoryBudget);
+    write(settings.particleCount);
+    write(settings.textureUploadBudget);
+    write(settings.dynamicResolutionTarget);
+    writeString(settings.meshPath);
+    write(static_cast<uint32_t>(settings.texturePaths.size()));
+    for(const std::string& texturePath : settings.texturePaths)
+    {
+        writeString(texturePath);
+    }
+
+    mStart = std::chrono::steady_clock::now();
+    logger::info("recording scene commands to ", path);
+}
+
+CommandRecorder::~CommandRecorder()
+{
+    if(std::fclose(mFile) != 0)
+    {
+        logger::error("failed to write ", mPath);
+        return;
+    }
+    logger::info("recorded ", mFrameCount, " frames to ", mPath);
+}
+
+void CommandRecorder::writeString(const std::string& value)
+{
+    write(static_cast<uint32_t>(value.size()));
+    std::fwrite(value.data(), 1, value.size(), mFile);
+}
+
+void CommandRecorder::writeEntity(Entity entity)
+{
+    write(entity.index);
+    write(entity.generation);
+}
+
+void CommandRecorder::writeTransform(const LocalTransform& transform)
+{
+    // pola osobno - Vector3 ma w pamięci 16 bajtów
+    const float values[10] = {transform.position.x, transform.position.y, transform.position.z,
+                              transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w,
+                              transform.scale.x, transform.scale.y, transform.scale.z};
+    write(values);
+}
+
+void CommandRecorder::createNode(Entity entity, Entity parent, const LocalTransform& transform)
+{
+    write(SceneCommand::CreateNode);
+    writeEntity(entity);
+    writeEntity(parent);
+    writeTransform(transform);
+}
+
+void CommandRecorder::createInstance(Entity entity, Entity parent, const LocalTransform& transform)
+{
+    write(SceneCommand::CreateInstance);
+    writeEntity(entity);
+    writeEntity(parent);
+    writeTransform(transform);
+}
+
+void CommandRecorder::destroy(Entity entity)
+{
+    write(SceneCommand::Destroy);
+    writeEntity(entity);
+}
+
+void CommandRecorder::setParent(Entity entity, Entity parent)
+{
+    write(SceneCommand::SetParent);
+    writeEntity(entity);
+    writeEntity(parent);
+}
+
+void CommandRecorder::setLocalTransform(Entity entity, const LocalTransform& transform)
+{
+    write(SceneCommand::SetLocalTransform);
+    writeEntity(entity);
+    writeTransform(transform);
+}
+
+void CommandRecorder::frame(const Camera& camera)
+{
+    const uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count();
+    write(SceneCommand::Frame);
+    write(time);
+    const float values[9] = {camera.position.x, camera.position.y, camera.position.z, camera.target.x, camera.target.y, camera.target.z,
+                             camera.fovY, camera.nearPlane, camera.farPlane};
+    write(values);
+    mFrameCount++;
+}
+
+/*------------ log -------------*/
+
+CommandLog::CommandLog(const std::string& path)
+    : mPath(path), mFile(path)
+{
+    Reader reader(mFile.data(), mFile.size(), 0, mPath);
+    if(mFile.size() < 2 * sizeof(uint32_t) || reader.read<uint32_t>() != commandLogMagic)
+    {
+        throw std::runtime_error(path + " is not a command log");
+    }
+    const uint32_t version = reader.read<uint32_t>();
+    if(version != commandLogVersion)
+    {
+        throw std::runtime_error(path + " has command log version " + std::to_string(version) + ", expected " + std::to_string(commandLogVersion));
+    }
+
+    const uint32_t vertexLayout = reader.read<uint32_t>();
+    if(vertexLayout > static_cast<uint32_t>(VertexLayoutType::CompactHalf))
+    {
+        throw std::runtime_error(path + " has an unknown vertex layout");
+    }
+    mSettings.vertexLayout = static_cast<VertexLayoutType>(vertexLayout);
+    mSettings.occlusionCulling = reader.read<uint8_t>() != 0;
+    mSettings.cacheCommandBuffers = reader.read<uint8_t>() != 0;
+    mSettings.outputCount = reader.read<uint32_t>();
+    mSettings.memoryBudget = reader.read<uint32_t>();
+    mSettings.particleCount = reader.read<uint32_t>();
+    mSettings.textureUploadBudget = reader.read<uint32_t>();
+    mSettings.dynamicResolutionTarget = reader.read<float>();
+    mSettings.meshPath = reader.readString();
+    const uint32_t textureCount = reader.read<uint32_t>();
+    for(uint32_t i = 0; i < textureCount; i++)
+    {
+        mSettings.texturePaths.push_back(reader.readString());
+    }
+
+    // cały strumień raz na starcie - powtórka nie może paść w połowie pomiaru
+    size_t firstCommand = reader.offset();
+    uint64_t firstFrameTime = 0;
+    while(!reader.atEnd())
+    {
+        const size_t commandOffset = reader.offset();
+        switch(reader.read<SceneCommand>())
+        {
+        case SceneCommand::CreateNode:
+        case SceneCommand::CreateInstance:
+            reader.readEntity();
+            reader.readEntity();
+            reader.readTransform();
+            break;
+        case SceneCommand::Destroy:
+            reader.readEntity();
+            break;
+        case SceneCommand::SetParent:
+            reader.readEntity();
+            reader.readEntity();
+            break;
+        case SceneCommand::SetLocalTransform:
+            reader.readEntity();
+            reader.readTransform();
+            break;
+        case SceneCommand::Frame:
+        {
+            Frame frame;
+            frame.firstCommand = firstCommand;
+            frame.frameCommand = commandOffset;
+            frame.time = reader.read<uint64_t>();
+            frame.camera = reader.readCamera();
+            if(mFrames.empty())
+            {
+                firstFrameTime = frame.time;
+            }
+            frame.time -= firstFrameTime;
+            mFrames.push_back(frame);
+            firstCommand = reader.offset();
+            break;
+        }
+        default:
+            throw std::runtime_error(path + " has an unknown command at offset " + std::to_string(commandOffset));
+        }
+    }
+    // operacje po ostatniej ramce nigdy nie zostały narysowane - pomijamy je
+}
+
+void CommandLog::applySettings(EngineSettings& settings) const
+{
+    settings.vertexLayout = mSettings.vertexLayout;
+    settings.occlusionCulling = mSettings.occlusionCulling;
+    settings.cacheCommandBuffers = mSettings.cacheCommandBuffers;
+    settings.outputCount = mSettings.outputCount;
+    settings.memoryBudget = mSettings.memoryBudget;
+    settings.particleCount = mSettings.particleCount;
+    settings.textureUploadBudget = mSettings.textureUploadBudget;
+    settings.dynamicResolutionTarget = mSettings.dynamicResolutionTarget;
+    settings.meshPath = mSettings.meshPath;
+    settings.texturePaths = mSettings.texturePaths;
+}
+
+Entity CommandLog::liveEntity(Entity recorded) const
+{
+    const auto it = mEntities.find(entityKey(recorded));
+    return it != mEntities.end() ? it->second : Entity{};
+}
+
+void CommandLog::apply(size_t frameIndex, Scene& scene)
+{
+    const Frame& frame = mFrames[frameIndex];
+    Reader reader(mFile.data(), frame.frameCommand, frame.firstCommand, mPath);
+    while(!reader.atEnd())
+    {
+        // encja spoza nagrania (np. nagrywanie włączone po zbudowaniu sceny) - operacja jest pomijana, rodzic staje się korzeniem
+        const SceneCommand command = reader.read<SceneCommand>();
+        switch(command)
+        {
+        case SceneCommand::CreateNode:
+        case SceneCommand::CreateInstance:
+        {
+            const bool instance = command == SceneCommand::CreateInstance;
+            const Entity recorded = reader.readEntity();
+            const Entity parent = liveEntity(reader.readEntity());
+            const LocalTransform transform = reader.readTransform();
+            mEntities[entityKey(recorded)] = instance ? scene.createInstance(transform, parent) : scene.createNode(transform, parent);
+            break;
+        }
+        case SceneCommand::Destroy:
+        {
+            const Entity recorded = reader.readEntity();
+            const Entity entity = liveEntity(recorded);
+            if(entity.valid())
+            {
+                scene.destroy(entity); // poddrzewo zostaje w mapie, ale nagranie już się do niego nie odwoła
+                mEntities.erase(entityKey(recorded));
+            }
+            break;
+        }
+        case SceneCommand::SetParent:
+        {
+            const Entity entity = liveEntity(reader.readEntity());
+            const Entity parent = liveEntity(reader.readEntity());
+            if(entity.valid())
+            {
+                scene.setParent(entity, parent);
+            }
+            break;
+        }
+        case SceneCommand::SetLocalTransform:
+        {
+            const Entity entity = liveEntity(reader.readEntity());
+            const LocalTransform transform = reader.readTransform();
+            if(entity.valid())
+            {
+                scene.setLocalTransform(entity, transform);
+            }
+            break;
+        }
+        default:
+            break; // Frame nie występuje przed frameCommand
+        }
+    }
+    scene.camera() = frame.camera;
+}
@@ -0,0 +1,90 @@
+#ifndef COMMANDLOG_H
+#define COMMANDLOG_H
+#include "mappedfile.h"
+#include "scene.h"
+#include "settings.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Nagranie sesji do powtarzalnych porównań wydajności: ustawienia silnika, od których zależy obciążenie
+// (siatka, tekstury, cząsteczki, wyjścia...), a potem operacje na scenie podzielone na ramki.
+// Ramka to znacznik czasu i kamera - rekordy instancji, LOD-y i draw'y silnik wylicza z tego sam,
+// więc powtórka przechodzi przez dokładnie ten sam render() co nagranie. Little endian, bez wyrównania.
+constexpr uint32_t commandLogMagic = 0x474c4356; // "VCLG"
+constexpr uint32_t commandLogVersion = 1;
+
+enum class SceneCommand : uint8_t
+{
+    CreateNode,        // encja, rodzic, transformacja
+    CreateInstance,    // encja, rodzic, transformacja
+    Destroy,           // encja
+    SetParent,         // encja, rodzic
+    SetLocalTransform, // encja, transformacja
+    Frame              // ns od początku nagrania, kamera - wszystko wcześniej trafia przed tę ramkę
+};
+
+// Zapis przez bufor stdio - w render() jest tylko jeden rekord ramki, operacje na scenie idą z Scene.
+class CommandRecorder
+{
+public:
+    CommandRecorder(const std::string& path, const EngineSettings& settings); // rzuca, jeśli pliku nie da się otworzyć
+    ~CommandRecorder();
+    CommandRecorder(const CommandRecorder&) = delete;
+    CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+    void createNode(Entity entity, Entity parent, const LocalTransform& transform);
+    void createInstance(Entity entity, Entity parent, const LocalTransform& transform);
+    void destroy(Entity entity);
+    void setParent(Entity entity, Entity parent);
+    void setLocalTransform(Entity entity, const LocalTransform& transform);
+    void frame(const Camera& camera);
+
+    uint64_t frameCount() const { return mFrameCount; }
+
+private:
+    template<typename T>
+    void write(const T& value) { std::fwrite(&value, sizeof(T), 1, mFile); }
+    void writeString(const std::string& value);
+    void writeEntity(Entity entity);
+    void writeTransform(const LocalTransform& transform);
+
+    std::string mPath;
+    std::FILE* mFile = nullptr;
+    std::chrono::steady_clock::time_point mStart;
+    uint64_t mFrameCount = 0;
+};
+
+// Nagranie zmapowane w całości; konstruktor sprawdza cały strumień i indeksuje ramki, apply() już nie waliduje.
+class CommandLog
+{
+public:
+    explicit CommandLog(const std::string& path); // rzuca przy złym magic/wersji albo uciętym strumieniu
+
+    void applySettings(EngineSettings& settings) const; // tylko pola obciążenia - profil i v-sync zostają z wywołującego
+    size_t frameCount() const { return mFrames.size(); }
+    uint64_t frameTime(size_t frame) const { return mFrames[frame].time; } // ns od pierwszej ramki
+    void apply(size_t frame, Scene& scene); // operacje sprzed ramki i jej kamera; ramki po kolei od 0
+
+private:
+    struct Frame
+    {
+        size_t firstCommand = 0; // offset pierwszej operacji po poprzedniej ramce
+        size_t frameCommand = 0; // offset rekordu samej ramki
+        uint64_t time = 0;
+        Camera camera;
+    };
+
+    Entity liveEntity(Entity recorded) const; // encje z nagrania -> encje tej sceny
+
+    std::string mPath;
+    MappedFile mFile;
+    EngineSettings mSettings;
+    std::vector<Frame> mFrames;
+    std::unordered_map<uint64_t, Entity> mEntities;
+};
+
+#endif // COMMANDLOG_H
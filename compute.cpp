@@ -0,0 +1,105 @@
+#include "compute.h"
+#include <stdexcept>
+
+void checkVkResult(VkResult res, const char* errorMsg)
+{
+    if(res != VK_SUCCESS)
+    {
+        throw std::runtime_error(errorMsg);
+    }
+}
+
+ShaderModuleHandle createShaderModule(VkDevice device, const std::vector<uint32_t>& code)
+{
+    VkShaderModuleCreateInfo shaderModuleCreateInfo {};
+    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO; //reprezentuje skompilowany shader
+    shaderModuleCreateInfo.pNext = NULL;
+    shaderModuleCreateInfo.flags = 0;
+    shaderModuleCreateInfo.codeSize = code.size() * sizeof(uint32_t);
+    shaderModuleCreateInfo.pCode = code.data();
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    checkVkResult(vkCreateShaderModule(device, &shaderModuleCreateInfo, NULL, &shaderModule), "failed to create shader module");
+    return ShaderModuleHandle(device, shaderModule);
+}
+
+PipelineHandle createComputePipeline(VkDevice device, VkPipelineLayout layout, const std::vector<uint32_t>& code, VkPipelineCache cache)
+{
+    const ShaderModuleHandle module = createShaderModule(device, code);
+
+    VkComputePipelineCreateInfo pipelineCreateInfo {};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.pNext = NULL;
+    pipelineCreateInfo.flags = 0;
+    pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineCreateInfo.stage.module = module;
+    pipelineCreateInfo.stage.pName = "main";
+    pipelineCreateInfo.layout = layout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    checkVkResult(vkCreateComputePipelines(device, cache, 1, &pipelineCreateInfo, NULL, &pipeline), "failed to create compute pipeline");
+    return PipelineHandle(device, pipeline);
+}
+
+DescriptorSetLayoutHandle createComputeSetLayout(VkDevice device, const std::vector<VkDescriptorType>& types)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings(types.size());
+    for(uint32_t i = 0; i < types.size(); i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = types[i];
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = NULL;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo {};
+    setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutCreateInfo.pNext = NULL;
+    setLayoutCreateInfo.flags = 0;
+    setLayoutCreateInfo.bindingCount = bindings.size();
+    setLayoutCreateInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    checkVkResult(vkCreateDescriptorSetLayout(device, &setLayoutCreateInfo, NULL, &setLayout), "failed to create descriptor set layout");
+    return DescriptorSetLayoutHandle(device, setLayout);
+}
+
+PipelineLayoutHandle createComputePipelineLayout(VkDevice device, VkDescriptorSetLayout setLayout, uint32_t pushConstantSize)
+{
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = NULL;
+    pipelineLayoutCreateInfo.flags = 0;
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &setLayout;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    checkVkResult(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, NULL, &pipelineLayout), "failed to create compute pipeline layout");
+    return PipelineLayoutHandle(device, pipelineLayout);
+}
+
+VkWriteDescriptorSet writeDescriptor(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                                     const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer)
+{
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = type;
+    write.pImageInfo = image;
+    write.pBufferInfo = buffer;
+    write.pTexelBufferView = NULL;
+    return write;
+}
@@ -0,0 +1,27 @@
+#ifndef COMPUTE_H
+#define COMPUTE_H
+#include "vkhandle.h"
+#include <cstdint>
+#include <vector>
+
+// Wspólne kawałki przebiegów compute (culling, piramida głębi, cząsteczki). Każdy system ma własne
+// layouty i pule deskryptorów - tu jest tylko to, co wszędzie wygląda tak samo. Błędy rzucają std::runtime_error.
+
+void checkVkResult(VkResult res, const char* errorMsg); // std::runtime_error(errorMsg) dla wszystkiego poza VK_SUCCESS
+// moduł potrzebny tylko do stworzenia pipeline'u - także graficznego
+ShaderModuleHandle createShaderModule(VkDevice device, const std::vector<uint32_t>& code);
+
+PipelineHandle createComputePipeline(VkDevice device, VkPipelineLayout layout, const std::vector<uint32_t>& code, VkPipelineCache cache = VK_NULL_HANDLE);
+// binding i = types[i], widoczne tylko w compute
+DescriptorSetLayoutHandle createComputeSetLayout(VkDevice device, const std::vector<VkDescriptorType>& types);
+PipelineLayoutHandle createComputePipelineLayout(VkDevice device, VkDescriptorSetLayout setLayout, uint32_t pushConstantSize);
+
+VkWriteDescriptorSet writeDescriptor(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                                     const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer);
+
+inline uint32_t groupCount(uint32_t count, uint32_t groupSize)
+{
+    return (count + groupSize - 1) / groupSize;
+}
+
+#endif // COMPUTE_H
@@ -0,0 +1,89 @@
+#include "debug.h"
+#include "log.h"
+#include <stdexcept>
+
+namespace
+{
+    VKAPI_ATTR VkBool32 VKAPI_CALL messengerCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT,
+                                                     const VkDebugUtilsMessengerCallbackDataEXT* callbackData, void*)
+    {
+        const char* idName = callbackData->pMessageIdName != NULL ? callbackData->pMessageIdName : "";
+
+        if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+        {
+            logger::error("vulkan: ", idName, " ", callbackData->pMessage);
+        }
+        else if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+        {
+            logger::warning("vulkan: ", idName, " ", callbackData->pMessage);
+        }
+        else if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+        {
+            logger::info("vulkan: ", callbackData->pMessage);
+        }
+        else
+        {
+            logger::debug("vulkan: ", callbackData->pMessage);
+        }
+        return VK_FALSE; // wywołanie, które wygenerowało komunikat, nie jest przerywane
+    }
+}
+
+VkDebugUtilsMessengerCreateInfoEXT DebugUtils::messengerCreateInfo()
+{
+    VkDebugUtilsMessengerCreateInfoEXT messengerCreateInfo {};
+    messengerCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    messengerCreateInfo.pNext = NULL;
+    messengerCreateInfo.flags = 0;
+    messengerCreateInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    messengerCreateInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    messengerCreateInfo.pfnUserCallback = messengerCallback;
+    messengerCreateInfo.pUserData = NULL;
+    return messengerCreateInfo;
+}
+
+DebugUtils::~DebugUtils()
+{
+    if(mMessenger != VK_NULL_HANDLE)
+    {
+        mDestroyMessenger(mInstance, mMessenger, NULL);
+    }
+}
+
+void DebugUtils::create(VkInstance instance)
+{
+    mInstance = instance;
+
+    // funkcje rozszerzenia nie są eksportowane przez loader - trzeba je pobrać
+    auto createMessenger = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT"));
+    mDestroyMessenger = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT"));
+    mSetObjectName = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT"));
+
+    if(createMessenger == nullptr || mDestroyMessenger == nullptr)
+    {
+        throw std::runtime_error("failed to load debug utils functions");
+    }
+
+    const VkDebugUtilsMessengerCreateInfoEXT messengerCreateInfo = DebugUtils::messengerCreateInfo();
+    VkResult res = createMessenger(instance, &messengerCreateInfo, NULL, &mMessenger);
+    if(res != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create debug utils messenger");
+    }
+}
+
+bool DebugUtils::isEnabled() const
+{
+    return mMessenger != VK_NULL_HANDLE;
+}
+
+void DebugUtils::setObjectName(VkDevice device, VkObjectType objectType, uint64_t handle, const char* name) const
+{
+    VkDebugUtilsObjectNameInfoEXT nameInfo {};
+    nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+    nameInfo.pNext = NULL;
+    nameInfo.objectType = objectType;
+    nameInfo.objectHandle = handle;
+    nameInfo.pObjectName = name;
+    mSetObjectName(device, &nameInfo);
+}
@@ -0,0 +1,41 @@
+#ifndef DEBUG_H
+#define DEBUG_H
+#include "window.h"
+#include <vulkan.h>
+#include <cstdint>
+#include <string>
+
+// VK_EXT_debug_utils: messenger przekierowujący komunikaty warstw do loggera i nazwy obiektów.
+// Bez rozszerzenia (profil release) wszystkie metody są no-opami.
+class DebugUtils
+{
+public:
+    static VkDebugUtilsMessengerCreateInfoEXT messengerCreateInfo(); // też do pNext instancji, żeby łapać vkCreateInstance
+
+    DebugUtils() = default;
+    ~DebugUtils(); // musi zostać zniszczony przed instancją
+    DebugUtils(const DebugUtils&) = delete;
+    DebugUtils& operator=(const DebugUtils&) = delete;
+
+    void create(VkInstance instance);
+    bool isEnabled() const;
+
+    template<typename T>
+    void setObjectName(VkDevice device, VkObjectType objectType, T handle, const std::string& name) const
+    {
+        if(mSetObjectName != nullptr)
+        {
+            setObjectName(device, objectType, (uint64_t)handle, name.c_str());
+        }
+    }
+
+private:
+    void setObjectName(VkDevice device, VkObjectType objectType, uint64_t handle, const char* name) const;
+
+    VkInstance mInstance = VK_NULL_HANDLE;
+    VkDebugUtilsMessengerEXT mMessenger = VK_NULL_HANDLE;
+    PFN_vkDestroyDebugUtilsMessengerEXT mDestroyMessenger = nullptr;
+    PFN_vkSetDebugUtilsObjectNameEXT mSetObjectName = nullptr;
+};
+
+#endif // DEBUG_H
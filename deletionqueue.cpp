@@ -0,0 +1,29 @@
+#include "deletionqueue.h"
+
+void DeletionQueue::resize(uint32_t frameSlots)
+{
+    mSlots.resize(frameSlots);
+}
+
+void DeletionQueue::collect(uint32_t frameSlot)
+{
+    mSlots[frameSlot].clear();
+}
+
+void DeletionQueue::flush()
+{
+    for(auto& slot : mSlots)
+    {
+        slot.clear();
+    }
+}
+
+size_t DeletionQueue::pendingCount() const
+{
+    size_t count = 0;
+    for(const auto& slot : mSlots)
+    {
+        count += slot.size();
+    }
+    return count;
+}
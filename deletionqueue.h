@@ -0,0 +1,41 @@
+#ifndef DELETIONQUEUE_H
+#define DELETIONQUEUE_H
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Obiekty wycofane w ramce N żyją, dopóki fence slotu N nie zostanie znowu odczekany (czyli do ramki N + framesInFlight).
+// Kolejka jest jedna, więc wtedy wszystkie ramki, które mogły ich używać, są już skończone - bez vkDeviceWaitIdle.
+class DeletionQueue
+{
+public:
+    void resize(uint32_t frameSlots);
+
+    template<typename T>
+    void retire(uint32_t frameSlot, T handle) // uchwyty są tylko przenoszalne - wołać z std::move
+    {
+        mSlots[frameSlot].push_back(std::make_unique<Retired<T>>(std::move(handle)));
+    }
+
+    void collect(uint32_t frameSlot); // po odczekaniu fence'a slotu
+    void flush();                     // po vkDeviceWaitIdle
+    size_t pendingCount() const;
+
+private:
+    struct RetiredBase
+    {
+        virtual ~RetiredBase() = default;
+    };
+
+    template<typename T>
+    struct Retired : RetiredBase
+    {
+        explicit Retired(T&& handle) : handle(std::move(handle)) {}
+        T handle; // destruktor uchwytu niszczy obiekt vulkana
+    };
+
+    std::vector<std::vector<std::unique_ptr<RetiredBase>>> mSlots;
+};
+
+#endif // DELETIONQUEUE_H
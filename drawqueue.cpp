@@ -0,0 +1,229 @@
+#include "drawqueue.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t meshShift = DrawQueue::depthBits;
+    constexpr uint32_t materialShift = meshShift + DrawQueue::fieldBits;
+    constexpr uint32_t pipelineShift = materialShift + DrawQueue::fieldBits;
+    constexpr uint32_t passShift = pipelineShift + DrawQueue::fieldBits;
+    static_assert(passShift + 4 == 64, "sort key layout");
+
+    uint32_t field(uint64_t key, uint32_t shift)
+    {
+        return uint32_t(key >> shift) & DrawQueue::none;
+    }
+}
+
+uint64_t DrawQueue::makeKey(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    constexpr uint32_t maxDepth = (1u << depthBits) - 1;
+    uint32_t quantizedDepth = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+    if(pass == DrawPass::Transparent)
+    {
+        quantizedDepth = maxDepth - quantizedDepth;
+    }
+    return (uint64_t(pass) << passShift) | (uint64_t(pipeline & none) << pipelineShift) | (uint64_t(material & none) << materialShift) |
+           (uint64_t(mesh & none) << meshShift) | quantizedDepth;
+}
+
+void DrawQueue::reset()
+{
+    mPipelines.clear();
+    mMeshes.clear();
+    mDraws.clear();
+    mKeys.clear();
+}
+
+uint32_t DrawQueue::addPipeline(const DrawPipeline& pipeline)
+{
+    mPipelines.push_back(pipeline);
+    return static_cast<uint32_t>(mPipelines.size() - 1);
+}
+
+uint32_t DrawQueue::addMesh(const DrawMesh& mesh)
+{
+    mMeshes.push_back(mesh);
+    return static_cast<uint32_t>(mMeshes.size() - 1);
+}
+
+void DrawQueue::push(uint64_t key, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance, uint32_t instanceCount)
+{
+    Draw draw;
+    draw.indexCount = indexCount;
+    draw.firstIndex = firstIndex;
+    draw.vertexOffset = vertexOffset;
+    draw.firstInstance = firstInstance;
+    draw.instanceCount = instanceCount;
+    mDraws.push_back(draw);
+    mKeys.push_back(key);
+}
+
+void DrawQueue::push(uint64_t key, DrawCallback callback, const void* context)
+{
+    Draw draw;
+    draw.callback = callback;
+    draw.context = context;
+    mDraws.push_back(draw);
+    mKeys.push_back(key);
+}
+
+void DrawQueue::sort()
+{
+    const size_t count = mKeys.size();
+    mOrder.resize(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        mOrder[i] = static_cast<uint32_t>(i);
+    }
+    mKeysScratch.resize(count);
+    mOrderScratch.resize(count);
+
+    // LSD po bajcie; bajt, który jest taki sam we wszystkich kluczach (zwykle większość), nie wymaga przejścia
+    for(uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::array<uint32_t, 256> offsets {};
+        for(uint64_t key : mKeys)
+        {
+            offsets[(key >> shift) & 0xff]++;
+        }
+        if(offsets[(mKeys[0] >> shift) & 0xff] == count)
+        {
+            continue;
+        }
+
+        uint32_t sum = 0;
+        for(uint32_t& offset : offsets)
+        {
+            const uint32_t bucketSize = offset;
+            offset = sum;
+            sum += bucketSize;
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            const uint32_t target = offsets[(mKeys[i] >> shift) & 0xff]++;
+            mKeysScratch[target] = mKeys[i];
+            mOrderScratch[target] = mOrder[i];
+        }
+        mKeys.swap(mKeysScratch);
+        mOrder.swap(mOrderScratch);
+    }
+}
+
+void DrawQueue::forgetState()
+{
+    mBoundPipeline = none;
+    mBoundMaterial = none;
+    mBoundMesh = none;
+    mBoundIndexBuffer = VK_NULL_HANDLE;
+}
+
+void DrawQueue::bind(VkCommandBuffer cmdBuff, uint64_t key)
+{
+    const uint32_t pipelineIndex = field(key, pipelineShift);
+    if(pipelineIndex != none)
+    {
+        if(pipelineIndex != mBoundPipeline)
+        {
+            const DrawPipeline& pipeline = mPipelines[pipelineIndex];
+            vkCmdBindPipeline(cmdBuff, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+            if(pipeline.pushConstantSize > 0)
+            {
+                vkCmdPushConstants(cmdBuff, pipeline.layout, pipeline.pushConstantStages, 0, pipeline.pushConstantSize, pipeline.pushConstants.data());
+            }
+            mBoundPipeline = pipelineIndex;
+            mStats.pipelineBinds++;
+        }
+        else
+        {
+            mStats.elidedBinds++;
+        }
+    }
+
+    // materiały nie mają jeszcze własnego stanu (deskryptorów) - liczymy tylko zmiany
+    const uint32_t material = field(key, materialShift);
+    if(material != mBoundMaterial)
+    {
+        mBoundMaterial = material;
+        mStats.materialChanges++;
+    }
+
+    const uint32_t meshIndex = field(key, meshShift);
+    if(meshIndex != none)
+    {
+        if(meshIndex != mBoundMesh)
+        {
+            const DrawMesh& mesh = mMeshes[meshIndex];
+            vkCmdBindVertexBuffers(cmdBuff, 0, mesh.vertexBufferCount, mesh.vertexBuffers.data(), mesh.offsets.data());
+            mBoundMesh = meshIndex;
+            mStats.vertexBufferBinds++;
+
+            // siatki mogą dzielić bufor indeksów
+            if(mesh.indexBuffer != mBoundIndexBuffer || mesh.indexType != mBoundIndexType)
+            {
+                vkCmdBindIndexBuffer(cmdBuff, mesh.indexBuffer, 0, mesh.indexType);
+                mBoundIndexBuffer = mesh.indexBuffer;
+                mBoundIndexType = mesh.indexType;
+                mStats.indexBufferBinds++;
+            }
+            else
+            {
+                mStats.elidedBinds++;
+            }
+        }
+        else
+        {
+            mStats.elidedBinds += 2;
+        }
+    }
+}
+
+void DrawQueue::submit(VkCommandBuffer cmdBuff)
+{
+    if(mDraws.empty())
+    {
+        return;
+    }
+    mStats.draws += static_cast<uint32_t>(mDraws.size());
+    sort();
+    forgetState(); // nic nie wiadomo o tym, co było nagrane przed submit()
+
+    const uint64_t stateMask = ~((uint64_t(1) << depthBits) - 1); // wszystko poza głębią
+    for(size_t i = 0; i < mOrder.size();)
+    {
+        const uint64_t key = mKeys[i];
+        Draw draw = mDraws[mOrder[i]];
+        i++;
+
+        bind(cmdBuff, key);
+        if(draw.callback != nullptr)
+        {
+            draw.callback(cmdBuff, draw.context);
+            mStats.drawCalls++;
+            forgetState();
+            continue;
+        }
+
+        // ten sam stan i zakres indeksów, instancje zaraz za poprzednimi - jeden draw na wszystkie
+        while(i < mOrder.size())
+        {
+            const Draw& next = mDraws[mOrder[i]];
+            const bool compatible = next.callback == nullptr && (mKeys[i] & stateMask) == (key & stateMask) && next.indexCount == draw.indexCount &&
+                                    next.firstIndex == draw.firstIndex && next.vertexOffset == draw.vertexOffset &&
+                                    next.firstInstance == draw.firstInstance + draw.instanceCount;
+            if(!compatible)
+            {
+                break;
+            }
+            draw.instanceCount += next.instanceCount;
+            mStats.mergedDraws++;
+            i++;
+        }
+
+        vkCmdDrawIndexed(cmdBuff, draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
+        mStats.drawCalls++;
+    }
+
+    mDraws.clear();
+    mKeys.clear();
+}
@@ -0,0 +1,112 @@
+#ifndef DRAWQUEUE_H
+#define DRAWQUEUE_H
+#include <vulkan.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Kolejność w kluczu = priorytet sortowania: najpierw przebieg, potem pipeline, materiał, siatka, na końcu głębia.
+enum class DrawPass : uint8_t
+{
+    Opaque,     // głębia rosnąco - bliższe najpierw, wczesny test głębi odrzuca resztę
+    Transparent // głębia malejąco - mieszanie od najdalszych
+};
+
+// Pipeline z push constantami - po każdym bindzie queue wysyła je od nowa.
+struct DrawPipeline
+{
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkShaderStageFlags pushConstantStages = 0;
+    uint32_t pushConstantSize = 0;
+    std::array<uint8_t, 128> pushConstants {}; // minimum maxPushConstantsSize ze specyfikacji
+};
+
+// Bufory wierzchołków (od bindingu 0) i indeksów jednej siatki.
+struct DrawMesh
+{
+    static constexpr uint32_t maxVertexBuffers = 2;
+    std::array<VkBuffer, maxVertexBuffers> vertexBuffers {};
+    std::array<VkDeviceSize, maxVertexBuffers> offsets {};
+    uint32_t vertexBufferCount = 0;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+};
+
+// Własne nagranie draw'a (indirect, inny pipeline...) - queue binduje pipeline i siatkę z klucza, jeśli są,
+// a po wywołaniu zapomina cały stan, bo callback mógł go zmienić.
+using DrawCallback = void (*)(VkCommandBuffer cmdBuff, const void* context);
+
+struct DrawQueueStats
+{
+    uint32_t draws = 0;          // wpisy w kolejce
+    uint32_t drawCalls = 0;      // vkCmdDraw* i callbacki po połączeniu
+    uint32_t mergedDraws = 0;    // wpisy dołączone do poprzedniego jako dalsze instancje
+    uint32_t pipelineBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    uint32_t materialChanges = 0;
+    uint32_t elidedBinds = 0;    // bindy pominięte, bo stan już był ustawiony
+};
+
+// Kolejka draw'ów jednego renderpassu. Każdy wpis ma 64-bitowy klucz, przed nagraniem klucze są sortowane
+// radix sortem (stabilnym - równe klucze zostają w kolejności dodania), sąsiednie draw'y tej samej siatki
+// z ciągłymi instancjami łączą się w jeden instancjonowany, a bindy powtarzające stan są pomijane.
+// Pipeline'y i siatki są rejestrowane od nowa po każdym reset() - indeksy trafiają do kluczy.
+class DrawQueue
+{
+public:
+    static constexpr uint32_t fieldBits = 12;
+    static constexpr uint32_t none = (1u << fieldBits) - 1; // brak pipeline'u/siatki - tylko dla callbacków
+    static constexpr uint32_t depthBits = 24;
+
+    // depth w 0..1 (np. odległość / far); dla Transparent odwracana
+    static uint64_t makeKey(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth = 0.0f);
+
+    void reset(); // pojemności zostają - w render() bez alokacji po rozgrzewce
+    uint32_t addPipeline(const DrawPipeline& pipeline);
+    uint32_t addMesh(const DrawMesh& mesh);
+
+    void push(uint64_t key, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance, uint32_t instanceCount);
+    void push(uint64_t key, DrawCallback callback, const void* context); // context musi żyć do submit()
+
+    void submit(VkCommandBuffer cmdBuff); // sortuje i nagrywa; kolejka jest potem pusta, rejestracje zostają
+
+    const DrawQueueStats& stats() const { return mStats; } // suma od resetStats()
+    void resetStats() { mStats = {}; }
+
+private:
+    struct Draw
+    {
+        uint32_t indexCount = 0;
+        uint32_t firstIndex = 0;
+        int32_t vertexOffset = 0;
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+        DrawCallback callback = nullptr;
+        const void* context = nullptr;
+    };
+
+    void sort(); // mKeys/mOrder rosnąco po kluczu
+    void bind(VkCommandBuffer cmdBuff, uint64_t key);
+    void forgetState();
+
+    std::vector<DrawPipeline> mPipelines;
+    std::vector<DrawMesh> mMeshes;
+    std::vector<Draw> mDraws;
+    std::vector<uint64_t> mKeys;
+    std::vector<uint32_t> mOrder; // indeksy do mDraws w kolejności kluczy
+    std::vector<uint64_t> mKeysScratch;
+    std::vector<uint32_t> mOrderScratch;
+
+    // stan command buffera w trakcie submit()
+    uint32_t mBoundPipeline = none;
+    uint32_t mBoundMaterial = none;
+    uint32_t mBoundMesh = none;
+    VkBuffer mBoundIndexBuffer = VK_NULL_HANDLE;
+    VkIndexType mBoundIndexType = VK_INDEX_TYPE_UINT32;
+
+    DrawQueueStats mStats;
+};
+
+#endif // DRAWQUEUE_H
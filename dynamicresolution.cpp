@@ -0,0 +1,92 @@
+#include "dynamicresolution.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+bool DynamicResolution::create(VkDevice device, uint32_t frameSlots, uint32_t timestampValidBits, float timestampPeriod, float targetMilliseconds)
+{
+    if(timestampValidBits == 0 || targetMilliseconds <= 0.0f)
+    {
+        return false;
+    }
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo {};
+    queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCreateInfo.pNext = NULL;
+    queryPoolCreateInfo.flags = 0;
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = frameSlots * 2;
+
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    if(vkCreateQueryPool(device, &queryPoolCreateInfo, NULL, &queryPool) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    mDevice = device;
+    mQueryPool = QueryPoolHandle(device, queryPool);
+    mQueriesWritten.assign(frameSlots, false);
+    mTimestampMask = timestampValidBits >= 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+    mTimestampPeriod = timestampPeriod;
+    mTargetMilliseconds = targetMilliseconds;
+    return true;
+}
+
+void DynamicResolution::collect(uint32_t frameSlot)
+{
+    if(!isEnabled() || !mQueriesWritten[frameSlot])
+    {
+        return;
+    }
+
+    std::array<uint64_t, 4> results = {}; // para (wartość, dostępność) na znacznik
+    const VkResult res = vkGetQueryPoolResults(mDevice, mQueryPool, frameSlot * 2, 2, sizeof(results), results.data(), 2 * sizeof(uint64_t),
+                                               VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if((res != VK_SUCCESS && res != VK_NOT_READY) || results[1] == 0 || results[3] == 0)
+    {
+        return;
+    }
+    mGpuMilliseconds = double((results[2] - results[0]) & mTimestampMask) * mTimestampPeriod * 1e-6;
+    if(mGpuMilliseconds <= 0)
+    {
+        return;
+    }
+
+    // koszt rośnie mniej więcej z liczbą pikseli, czyli z kwadratem skali boku
+    const float wanted = mSmoothedScale * std::sqrt(float(mTargetMilliseconds * headroom / mGpuMilliseconds));
+    const float target = std::clamp(wanted, minScale, 1.0f);
+    mSmoothedScale += (target - mSmoothedScale) * (target < mSmoothedScale ? 0.5f : 0.1f);
+    mScale = std::clamp(std::round(mSmoothedScale / scaleStep) * scaleStep, minScale, 1.0f);
+}
+
+void DynamicResolution::beginFrame(VkCommandBuffer cmdBuff, uint32_t frameSlot)
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+    mRecordingSlot = frameSlot;
+    vkCmdResetQueryPool(cmdBuff, mQueryPool, frameSlot * 2, 2);
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, frameSlot * 2);
+}
+
+void DynamicResolution::endFrame(VkCommandBuffer cmdBuff)
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mQueryPool, mRecordingSlot * 2 + 1);
+    mQueriesWritten[mRecordingSlot] = true;
+}
+
+VkExtent2D DynamicResolution::renderExtent(uint32_t width, uint32_t height) const
+{
+    // wielokrotność 8 pikseli - mniej różnych rozmiarów i pełne kafelki rasteryzera
+    const auto scaled = [this](uint32_t size)
+    {
+        const uint32_t value = static_cast<uint32_t>(std::lround(size * mScale)) / 8 * 8;
+        return std::clamp(value, std::min(size, 8u), size);
+    };
+    return {scaled(width), scaled(height)};
+}
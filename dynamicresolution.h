@@ -0,0 +1,44 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+#include "vkhandle.h"
+#include <cstdint>
+#include <vector>
+
+// Dynamiczna rozdzielczość: scena renderuje się do obrazu poza ekranem w rozmiarze output * scale(),
+// a blit skaluje go do obrazu swapchaina. Skalę ustawia czas GPU całej ramki (znaczniki czasu na początku
+// i końcu command buffera) względem budżetu - ramki odczytanej po fence, czyli sprzed mFramesInFlight.
+// W dół szybko, bo spadek klatek widać od razu, w górę powoli, żeby nie skakać przy granicy budżetu.
+class DynamicResolution
+{
+public:
+    static constexpr float minScale = 0.5f;  // na boku - poniżej obraz jest już za rozmyty
+    static constexpr float headroom = 0.9f;  // celujemy w 90% budżetu, reszta na wahania między ramkami
+    static constexpr float scaleStep = 1.0f / 32.0f; // skala zmienia się skokowo - każda zmiana unieważnia nagrane bufory
+
+    // false - kolejka nie ma znaczników czasu, rozdzielczość zostaje stała
+    bool create(VkDevice device, uint32_t frameSlots, uint32_t timestampValidBits, float timestampPeriod, float targetMilliseconds);
+    bool isEnabled() const { return mQueryPool != VK_NULL_HANDLE; }
+
+    void collect(uint32_t frameSlot); // po vkWaitForFences slotu - aktualizuje skalę
+    void beginFrame(VkCommandBuffer cmdBuff, uint32_t frameSlot); // zaraz po vkBeginCommandBuffer
+    void endFrame(VkCommandBuffer cmdBuff);                       // tuż przed vkEndCommandBuffer
+
+    float scale() const { return mScale; }
+    VkExtent2D renderExtent(uint32_t width, uint32_t height) const; // 1.0 bez dynamicznej rozdzielczości
+    double gpuMilliseconds() const { return mGpuMilliseconds; } // ostatni pomiar
+
+private:
+    VkDevice mDevice = VK_NULL_HANDLE;
+    QueryPoolHandle mQueryPool; // para znaczników na slot
+    std::vector<bool> mQueriesWritten;
+    uint32_t mRecordingSlot = 0;
+    uint64_t mTimestampMask = 0;
+    double mTimestampPeriod = 1.0; // ns na tick
+    float mTargetMilliseconds = 0;
+
+    float mSmoothedScale = 1.0f; // ciągła wartość regulatora
+    float mScale = 1.0f;         // zaokrąglona do scaleStep
+    double mGpuMilliseconds = 0;
+};
+
+#endif // DYNAMICRESOLUTION_H
@@ -0,0 +1,181 @@
+#include "ecs.h"
+#include <atomic>
+#include <cstring>
+
+uint32_t ecs_detail::nextComponentId()
+{
+    static std::atomic<uint32_t> next {0};
+    const uint32_t id = next++;
+    if(id >= maxComponentTypes)
+    {
+        throw std::runtime_error("too many component types");
+    }
+    return id;
+}
+
+Archetype::Archetype(uint64_t mask, const std::vector<ComponentInfo>& components)
+    : mMask(mask)
+{
+    mColumnIndex.fill(-1);
+    for(const auto& component : components)
+    {
+        mColumnIndex[component.id] = static_cast<int8_t>(mColumns.size());
+        mColumns.push_back({component.id, component.size, {}});
+    }
+}
+
+void* Archetype::column(uint32_t id)
+{
+    const int8_t index = mColumnIndex[id];
+    return index >= 0 && !mColumns[index].blocks.empty() ? mColumns[index].data() : nullptr;
+}
+
+uint32_t Archetype::push(Entity entity)
+{
+    const uint32_t row = static_cast<uint32_t>(mEntities.size());
+    mEntities.push_back(entity);
+    for(auto& column : mColumns)
+    {
+        column.resize(mEntities.size());
+    }
+    return row;
+}
+
+Entity Archetype::removeSwap(uint32_t row)
+{
+    const uint32_t last = static_cast<uint32_t>(mEntities.size() - 1);
+    Entity moved;
+
+    if(row != last)
+    {
+        for(auto& column : mColumns)
+        {
+            std::memcpy(column.data() + size_t(row) * column.size, column.data() + size_t(last) * column.size, column.size);
+        }
+        mEntities[row] = mEntities[last];
+        moved = mEntities[row];
+    }
+
+    mEntities.pop_back();
+    for(auto& column : mColumns)
+    {
+        column.resize(mEntities.size());
+    }
+    return moved;
+}
+
+void Archetype::copyRow(uint32_t row, Archetype& target, uint32_t targetRow) const
+{
+    for(const auto& column : mColumns)
+    {
+        const int8_t targetIndex = target.mColumnIndex[column.id];
+        if(targetIndex >= 0)
+        {
+            std::memcpy(target.mColumns[targetIndex].data() + size_t(targetRow) * column.size,
+                        column.data() + size_t(row) * column.size, column.size);
+        }
+    }
+}
+
+Registry::Registry()
+{
+    mArchetypes.push_back(std::make_unique<Archetype>(0, std::vector<Archetype::ComponentInfo>{}));
+    mArchetypeByMask[0] = 0;
+}
+
+Entity Registry::create()
+{
+    Entity entity;
+    if(!mFreeIndices.empty())
+    {
+        entity.index = mFreeIndices.back();
+        mFreeIndices.pop_back();
+    }
+    else
+    {
+        entity.index = static_cast<uint32_t>(mRecords.size());
+        mRecords.emplace_back();
+    }
+
+    Record& record = mRecords[entity.index];
+    entity.generation = record.generation;
+    record.alive = true;
+    record.archetype = 0;
+    record.row = mArchetypes[0]->push(entity);
+    return entity;
+}
+
+void Registry::destroy(Entity entity)
+{
+    const Record& record = recordOf(entity);
+    removeRow(record.archetype, record.row);
+
+    Record& freed = mRecords[entity.index];
+    freed.alive = false;
+    freed.generation++;
+    mFreeIndices.push_back(entity.index);
+}
+
+bool Registry::alive(Entity entity) const
+{
+    return entity.index < mRecords.size() && mRecords[entity.index].alive && mRecords[entity.index].generation == entity.generation;
+}
+
+const Registry::Record& Registry::recordOf(Entity entity) const
+{
+    if(!alive(entity))
+    {
+        throw std::runtime_error("entity is not alive");
+    }
+    return mRecords[entity.index];
+}
+
+void Registry::registerComponent(uint32_t id, size_t size)
+{
+    mComponentSizes[id] = static_cast<uint32_t>(size);
+}
+
+uint32_t Registry::findArchetype(uint64_t mask)
+{
+    const auto found = mArchetypeByMask.find(mask);
+    if(found != mArchetypeByMask.end())
+    {
+        return found->second;
+    }
+
+    std::vector<Archetype::ComponentInfo> components;
+    for(uint32_t id = 0; id < maxComponentTypes; id++)
+    {
+        if(mask & (uint64_t(1) << id))
+        {
+            components.push_back({id, mComponentSizes[id]});
+        }
+    }
+
+    const uint32_t index = static_cast<uint32_t>(mArchetypes.size());
+    mArchetypes.push_back(std::make_unique<Archetype>(mask, components));
+    mArchetypeByMask[mask] = index;
+    return index;
+}
+
+void Registry::moveTo(Entity entity, uint64_t mask)
+{
+    const uint32_t target = findArchetype(mask);
+    Record& record = mRecords[entity.index];
+
+    const uint32_t targetRow = mArchetypes[target]->push(entity);
+    mArchetypes[record.archetype]->copyRow(record.row, *mArchetypes[target], targetRow);
+    removeRow(record.archetype, record.row);
+
+    record.archetype = target;
+    record.row = targetRow;
+}
+
+void Registry::removeRow(uint32_t archetype, uint32_t row)
+{
+    const Entity moved = mArchetypes[archetype]->removeSwap(row);
+    if(moved.valid())
+    {
+        mRecords[moved.index].row = row;
+    }
+}
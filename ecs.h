@@ -0,0 +1,215 @@
+#ifndef ECS_H
+#define ECS_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+struct Entity
+{
+    static constexpr uint32_t invalidIndex = 0xffffffff;
+
+    uint32_t index = invalidIndex;
+    uint32_t generation = 0; // rośnie przy każdym zwolnieniu indeksu - stare uchwyty przestają być ważne
+
+    bool valid() const { return index != invalidIndex; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+constexpr uint32_t maxComponentTypes = 64; // maska archetypu to jeden uint64_t
+constexpr size_t componentAlignment = 16;   // typy z mathlib.h (wyrównanie SSE) mogą być komponentami
+
+namespace ecs_detail
+{
+    uint32_t nextComponentId();
+}
+
+template<typename T>
+uint32_t componentId()
+{
+    static const uint32_t id = ecs_detail::nextComponentId();
+    return id;
+}
+
+template<typename T>
+uint64_t componentBit()
+{
+    return uint64_t(1) << componentId<T>();
+}
+
+// Wszystkie encje z tym samym zestawem komponentów. Każdy komponent ma własną, ciągłą kolumnę (SoA),
+// więc system iterujący po jednym komponencie czyta tylko jego bajty.
+class Archetype
+{
+public:
+    struct ComponentInfo
+    {
+        uint32_t id = 0;
+        uint32_t size = 0;
+    };
+
+    Archetype(uint64_t mask, const std::vector<ComponentInfo>& components);
+
+    uint64_t mask() const { return mMask; }
+    size_t size() const { return mEntities.size(); }
+    const std::vector<Entity>& entities() const { return mEntities; }
+
+    template<typename T>
+    T* column() // nullptr, jeśli archetyp nie ma tego komponentu; ważne do następnej zmiany struktury
+    {
+        return static_cast<T*>(column(componentId<T>()));
+    }
+
+    void* column(uint32_t id);
+    uint32_t push(Entity entity);       // nowy wiersz z wyzerowanymi komponentami
+    Entity removeSwap(uint32_t row);    // zwraca encję przeniesioną na miejsce usuniętej (albo nieważną)
+    void copyRow(uint32_t row, Archetype& target, uint32_t targetRow) const; // wspólne komponenty
+
+private:
+    struct alignas(componentAlignment) Block
+    {
+        unsigned char bytes[componentAlignment];
+    };
+
+    struct Column
+    {
+        uint32_t id = 0;
+        uint32_t size = 0;
+        std::vector<Block> blocks; // pamięć wyrównana do componentAlignment
+
+        unsigned char* data() { return blocks.front().bytes; }
+        const unsigned char* data() const { return blocks.front().bytes; }
+        void resize(size_t rows) { blocks.resize((rows * size + componentAlignment - 1) / componentAlignment); }
+    };
+
+    uint64_t mMask = 0;
+    std::vector<Column> mColumns;
+    std::array<int8_t, maxComponentTypes> mColumnIndex;
+    std::vector<Entity> mEntities;
+};
+
+// Komponenty muszą być trywialnie kopiowalne - przenoszenie encji między archetypami to memcpy wiersza.
+// W trakcie each() nie wolno dodawać/usuwać komponentów ani encji.
+class Registry
+{
+public:
+    Registry();
+
+    Entity create();
+    template<typename... Ts>
+    Entity create(const Ts&... components) // od razu w docelowym archetypie, bez przenoszenia po każdym add()
+    {
+        (checkComponent<Ts>(), ...);
+        const Entity entity = create();
+        moveTo(entity, (uint64_t(0) | ... | componentBit<Ts>()));
+        ((*get<Ts>(entity) = components), ...);
+        return entity;
+    }
+    void destroy(Entity entity);
+    bool alive(Entity entity) const;
+    size_t size() const { return mRecords.size() - mFreeIndices.size(); }
+
+    template<typename T>
+    T& add(Entity entity, const T& value = T{})
+    {
+        checkComponent<T>();
+        const Record& record = recordOf(entity);
+        if((mArchetypes[record.archetype]->mask() & componentBit<T>()) == 0)
+        {
+            moveTo(entity, mArchetypes[record.archetype]->mask() | componentBit<T>());
+        }
+
+        T& component = mArchetypes[record.archetype]->column<T>()[record.row];
+        component = value;
+        return component;
+    }
+
+    template<typename T>
+    void remove(Entity entity)
+    {
+        const Record& record = recordOf(entity);
+        if((mArchetypes[record.archetype]->mask() & componentBit<T>()) != 0)
+        {
+            moveTo(entity, mArchetypes[record.archetype]->mask() & ~componentBit<T>());
+        }
+    }
+
+    template<typename T>
+    T* get(Entity entity)
+    {
+        const Record& record = recordOf(entity);
+        T* column = mArchetypes[record.archetype]->column<T>();
+        return column != nullptr ? column + record.row : nullptr;
+    }
+
+    template<typename T>
+    bool has(Entity entity) const
+    {
+        const Record& record = recordOf(entity);
+        return (mArchetypes[record.archetype]->mask() & componentBit<T>()) != 0;
+    }
+
+    // f(Entity, Ts&...) dla każdej encji, która ma wszystkie Ts - archetyp po archetypie, kolumny czytane liniowo
+    template<typename... Ts, typename F>
+    void each(F&& f)
+    {
+        eachChunk<Ts...>([&f](size_t count, const Entity* entities, Ts*... columns)
+        {
+            for(size_t row = 0; row < count; row++)
+            {
+                f(entities[row], columns[row]...);
+            }
+        });
+    }
+
+    // f(count, entities, Ts*...) raz na archetyp - dla systemów, które chcą przetwarzać kolumny wsadowo
+    template<typename... Ts, typename F>
+    void eachChunk(F&& f)
+    {
+        const uint64_t required = (uint64_t(0) | ... | componentBit<Ts>());
+        for(auto& archetype : mArchetypes)
+        {
+            if((archetype->mask() & required) == required && archetype->size() > 0)
+            {
+                f(archetype->size(), archetype->entities().data(), archetype->template column<Ts>()...);
+            }
+        }
+    }
+
+private:
+    struct Record
+    {
+        uint32_t archetype = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+        bool alive = false;
+    };
+
+    template<typename T>
+    void checkComponent()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "components are moved between archetypes with memcpy");
+        static_assert(alignof(T) <= componentAlignment, "component columns are only 16-byte aligned");
+        registerComponent(componentId<T>(), sizeof(T));
+    }
+
+    const Record& recordOf(Entity entity) const;
+    void registerComponent(uint32_t id, size_t size);
+    uint32_t findArchetype(uint64_t mask);
+    void moveTo(Entity entity, uint64_t mask);
+    void removeRow(uint32_t archetype, uint32_t row);
+
+    std::vector<Record> mRecords;
+    std::vector<uint32_t> mFreeIndices;
+    std::vector<std::unique_ptr<Archetype>> mArchetypes; // [0] - encje bez komponentów
+    std::unordered_map<uint64_t, uint32_t> mArchetypeByMask;
+    std::array<uint32_t, maxComponentTypes> mComponentSizes {};
+};
+
+#endif // ECS_H
@@ -1,73 +1,206 @@
 #include "engine.h"
+#include "allocationcount.h"
+#include "compute.h"
+#include "startup.h"
+#include "trace.h"
+#include "log.h"
+#include "meshfile.h"
+#include "upload.h"
+#include <chrono>
 #include <fstream>
+#include <algorithm>
 #include <array>
 #include <iostream>
+#include <numeric>
+#include <thread>
 #include <vector>
 #include <cstring>
+#if defined(ENGINE_SPIRV_VALIDATION)
+#include <spirv-tools/libspirv.h>
+#endif
 
-Engine::Engine() : mWindow(this, mWindowWidth, mWindowHeight)
-{
-    createInstance();
-    createDevice();
-    createSurface();
-    createSwapchain();
-    createDepthImage();
-    createCommandBuffer();
-    createFence();
-    createSemaphores();
-    createRenderPass();
-    createFrameBuffer();
-    createPipeline();
-}
-
-Engine::~Engine()
+namespace
 {
-    vkDeviceWaitIdle(mDevice);
-
-    vkDestroyPipeline(mDevice, mPipeline, NULL);
-    vkDestroyPipelineLayout(mDevice, mPipelineLayout, NULL);
-    for(auto framebuffer : mFramebuffers)
+    std::vector<uint32_t> readShaderFile(const char* path)
     {
-        vkDestroyFramebuffer(mDevice, framebuffer, NULL);
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if(!file)
+        {
+            throw std::runtime_error("shader file does not exist");
+        }
+        const size_t size = file.tellg();
+        if (size == 0)
+        {
+            throw std::runtime_error("shader file empty");
+        }
+        file.seekg(0);
+        std::vector<uint32_t> code((size - 1) / 4 + 1);
+        file.read(reinterpret_cast<char*>(code.data()), size);
+        // tylko nagłówek SPIR-V: magic, wersja, generator, bound, schema - odrzuca ucięty albo obcy plik, treści nie sprawdza
+        constexpr uint32_t spirvMagic = 0x07230203;
+        if(!file || size % 4 != 0 || size < 5 * sizeof(uint32_t) || code[0] != spirvMagic || code[3] == 0 || code[4] != 0)
+        {
+            throw std::runtime_error(std::string(path) + " does not have a SPIR-V header");
+        }
+        return code;
     }
-    vkDestroyRenderPass(mDevice, mRenderPass, NULL);
-    for(auto queueSubmitSemaphore : mQueueSubmitSemaphores)
+
+    // Nieprawidłowy SPIR-V w vkCreateShaderModule to niezdefiniowane zachowanie sterownika, a przy przeładowaniu
+    // kompilator może jeszcze pisać plik. Z SPIRV-Tools cały moduł przechodzi przez walidator, bez nich
+    // zostaje tylko sprawdzenie nagłówka z readShaderFile - uszkodzona treść trafi wtedy do sterownika.
+    void validateShader(const std::vector<uint32_t>& code, const char* path)
     {
-        vkDestroySemaphore(mDevice, queueSubmitSemaphore, NULL);
+#if defined(ENGINE_SPIRV_VALIDATION)
+        const spv_context context = spvContextCreate(SPV_ENV_VULKAN_1_3); // apiVersion instancji
+        const spv_const_binary_t binary = {code.data(), code.size()};
+        spv_diagnostic diagnostic = nullptr;
+        const spv_result_t result = spvValidate(context, &binary, &diagnostic);
+        std::string error = std::string(path) + " failed SPIR-V validation";
+        if(diagnostic != nullptr && diagnostic->error != nullptr)
+        {
+            error += std::string(": ") + diagnostic->error;
+        }
+        spvDiagnosticDestroy(diagnostic);
+        spvContextDestroy(context);
+        if(result != SPV_SUCCESS)
+        {
+            throw std::runtime_error(error);
+        }
+#else
+        (void)code;
+        (void)path;
+#endif
     }
-    for(auto acquireSemaphore : mAcquireSemaphores)
+
+    std::vector<uint32_t> loadShader(const char* path) // readShaderFile + walidacja, zanim kod trafi do vkCreateShaderModule
     {
-        vkDestroySemaphore(mDevice, acquireSemaphore, NULL);
+        std::vector<uint32_t> code = readShaderFile(path);
+        validateShader(code, path);
+        return code;
     }
-    for(auto queueSubmitFence : mQueueSubmitFences)
+
+    // pipeline'y, które da się przebudować w locie, i pliki, od których zależą
+    struct ReloadablePipeline
+    {
+        const char* name;
+        std::array<const char*, 2> shaders; // nullptr - brak drugiego etapu
+    };
+
+    constexpr std::array<ReloadablePipeline, 3> reloadablePipelines = {{
+        {"main", {"vs.spv", "fs.spv"}},
+        {"particle simulation", {"particles.spv", nullptr}},
+        {"particle draw", {"particle_vs.spv", "particle_fs.spv"}},
+    }};
+
+    constexpr const char* pipelineCachePath = "pipeline_cache.bin";
+
+    // push constanty vs.vert - układ std140
+    struct DrawConstants
+    {
+        Matrix4 viewProjection;
+        Vector4 positionScale;  // dekwantyzacja pozycji siatki
+        Vector4 positionOffset;
+    };
+
+    std::vector<MeshVertex> createCubeVertices() // sześcian o boku 1, każda ściana w innym kolorze, bez indeksów
     {
-        vkDestroyFence(mDevice, queueSubmitFence, NULL);
+        const std::array<Vector4, 6> colors = {{{1, 0, 0, 1}, {0, 1, 0, 1}, {0, 0, 1, 1}, {1, 1, 0, 1}, {1, 0, 1, 1}, {0, 1, 1, 1}}};
+        const std::array<std::array<float, 2>, 6> corners = {{{-1, -1}, {1, -1}, {1, 1}, {-1, -1}, {1, 1}, {-1, 1}}};
+
+        std::vector<MeshVertex> vertices;
+        for(int face = 0; face < 6; face++)
+        {
+            const int axis = face / 2;           // oś normalnej ściany
+            const float side = face % 2 ? 0.5f : -0.5f;
+            for(const auto& corner : corners)
+            {
+                MeshVertex vertex;
+                vertex.position[axis] = side;
+                vertex.position[(axis + 1) % 3] = corner[0] * 0.5f;
+                vertex.position[(axis + 2) % 3] = corner[1] * 0.5f;
+                vertex.normal = Vector3{};
+                vertex.normal[axis] = side * 2.0f;
+                vertex.color = colors[face];
+                vertices.push_back(vertex);
+            }
+        }
+        return vertices;
     }
-    vkDestroyCommandPool(mDevice, mCommandPool, NULL);
-    for(auto deviceMemory : mDeviceMemory)
+
+    // callbacki kolejki draw'ów - draw'y, które nie są zwykłym zakresem instancji
+    void drawVisibleInstances(VkCommandBuffer cmdBuff, const void* context)
     {
-        vkFreeMemory(mDevice, deviceMemory, NULL);
+        static_cast<const OcclusionCuller*>(context)->draw(cmdBuff, 1); // podmienia binding 1 na skompaktowane widoczne instancje
     }
-    for(auto depthImageView : mDepthImageViews)
+
+    struct ParticleDraw
     {
-        vkDestroyImageView(mDevice, depthImageView, NULL);
+        const ParticleSystem* particles;
+        Matrix4 viewProjection;
+        const Camera* camera;
+    };
+
+    void drawParticles(VkCommandBuffer cmdBuff, const void* context)
+    {
+        const ParticleDraw* draw = static_cast<const ParticleDraw*>(context);
+        draw->particles->draw(cmdBuff, draw->viewProjection, *draw->camera);
     }
-    for(auto depthImage : mDepthImages)
+}
+
+Engine::Engine(const EngineSettings& settings) : mSettings(settings), mVertexLayout(VertexLayout::create(settings.vertexLayout))
+{
+    mDeletionQueue.resize(mFramesInFlight);
+    mFrameArena.resize(mFramesInFlight, frameArenaBytes);
+    mCachedFrames.resize(mFramesInFlight);
+    for(uint32_t i = 0; i < std::max(settings.outputCount, 1u); i++)
     {
-        vkDestroyImage(mDevice, depthImage, NULL);
+        mOutputs.push_back(std::make_unique<Output>());
+        mOutputs.back()->name = "output " + std::to_string(i);
     }
-    for(auto imageView : mImageViews)
+
+    // każdy krok czeka tylko na to, czego naprawdę używa - reszta leci równolegle
+    StartupGraph startup;
+    startup.addStep("window", {}, [this]{ createWindows(); }); // okno ma własny wątek z pompą wiadomości
+    startup.addStep("instance", {}, [this]{ createInstance(); });
+    startup.addStep("device", {"instance"}, [this]{ createDevice(); });
+    startup.addStep("shaders", {}, [this]{ loadShaders(); });
+    startup.addStep("surface", {"window", "device"}, [this]{ for(auto& output : mOutputs) createSurface(*output); });
+    startup.addStep("swapchain", {"surface"}, [this]{ for(auto& output : mOutputs) createSwapchain(*output); });
+    startup.addStep("depth image", {"swapchain"}, [this]{ for(auto& output : mOutputs) createDepthImage(*output); });
+    startup.addStep("color image", {"swapchain"}, [this]{ for(auto& output : mOutputs) createColorImage(*output); });
+    startup.addStep("command buffer", {"device"}, [this]{ createCommandBuffer(); });
+    startup.addStep("fence", {"device"}, [this]{ createFence(); });
+    startup.addStep("semaphores", {"device"}, [this]{ createSemaphores(); });
+    startup.addStep("renderpass", {"surface"}, [this]{ createRenderPass(); }); // potrzebuje tylko formatu
+    startup.addStep("framebuffer", {"renderpass", "depth image", "color image"}, [this]{ for(auto& output : mOutputs) createFrameBuffer(*output); });
+    startup.addStep("pipeline layout", {"device"}, [this]{ createPipelineLayout(); });
+    startup.addStep("geometry", {"device"}, [this]{ createGeometry(); });
+    startup.addStep("pipeline", {"renderpass", "pipeline layout", "shaders", "geometry"}, [this]{ mPipeline = createPipeline(mVertexShaderCode, mFragmentShaderCode); });
+    startup.addStep("occlusion", {"device", "depth image", "shaders"}, [this]{ for(auto& output : mOutputs) createOcclusionCulling(*output); });
+    startup.addStep("particles", {"renderpass", "shaders"}, [this]{ createParticles(); });
+    startup.addStep("textures", {"device"}, [this]{ createTextureStreamer(); }); // tylko otwiera pliki w tle, nie czeka na dane
+    startup.run();
+    startup.report();
+    logMemoryStats();
+
+    if(mSettings.watchShaders)
     {
-        vkDestroyImageView(mDevice, imageView, NULL);
+        mShaderWatcher.start("shaders", [this](const std::vector<std::string>& fileNames){ rebuildPipelines(fileNames); });
     }
-    vkDestroySwapchainKHR(mDevice, mSwapchain, NULL);
-    vkDestroySurfaceKHR(mInstance, mSurface, NULL);
-    vkDestroyDevice(mDevice, NULL);
-    vkDestroyInstance(mInstance, NULL);
+}
+
+Engine::~Engine()
+{
+    mShaderWatcher.stop(); // przebudowa w tle używa renderpassu, layoutów i cząsteczek
+    vkDeviceWaitIdle(mDevice);
+    savePipelineCache();
+    mReadback.flush();
+    mDeletionQueue.flush();
+    // reszta obiektów niszczy się sama, w odwrotnej kolejności deklaracji w engine.h
 }
 
 
-void Engine::assertVkSuccess(VkResult res, std::string_view errorMsg)
+void Engine::assertVkSuccess(VkResult res, std::string_view errorMsg) const
 {
     if(res != VK_SUCCESS)
     {
@@ -77,12 +210,11 @@ void Engine::assertVkSuccess(VkResult res, std::string_view errorMsg)
 
 void Engine::createInstance()
 {
-    const std::vector<const char*> requiredLayerNames =
-    {
-        "VK_LAYER_KHRONOS_validation"
-    };
+    const bool debugProfile = mSettings.profile == Profile::Debug;
 
-    const std::vector<const char*> requiredExtensionNames =
+    std::vector<const char*> requiredLayerNames; // w release żadnych warstw
+
+    std::vector<const char*> requiredExtensionNames =
     {
         VK_KHR_SURFACE_EXTENSION_NAME,
         VK_PLATFORM_SURFACE_EXTENSION_NAME
@@ -96,12 +228,18 @@ void Engine::createInstance()
     res = vkEnumerateInstanceLayerProperties(&propertyCount, layerProperties.data());
     assertVkSuccess(res, "failed to enumerate instance properties");
 
-    for(const auto& layerName : requiredLayerNames)
+    res = vkEnumerateInstanceExtensionProperties(NULL, &propertyCount, NULL);
+    assertVkSuccess(res, "failed to enumerate extension properties");
+    std::vector<VkExtensionProperties> extensionProperties(propertyCount);
+    res = vkEnumerateInstanceExtensionProperties(NULL, &propertyCount, extensionProperties.data());
+    assertVkSuccess(res, "failed to enumerate extension properties");
+
+    for(const auto& extensionName : requiredExtensionNames)
     {
         bool found = false;
-        for(const auto& lp : layerProperties)
+        for(const auto& ep : extensionProperties)
         {
-            if(std::strcmp(lp.layerName, layerName) == 0)
+            if(std::strcmp(ep.extensionName, extensionName) == 0)
             {
                 found = true;
                 break;
@@ -109,33 +247,53 @@ void Engine::createInstance()
         }
         if(!found)
         {
-            throw std::runtime_error("required layer not supported");
+            throw std::runtime_error("required extension not supported");
         }
     }
 
-    res = vkEnumerateInstanceExtensionProperties(NULL, &propertyCount, NULL);
-    assertVkSuccess(res, "failed to enumerate extension properties");
-    std::vector<VkExtensionProperties> extensionProperties(propertyCount);
-    res = vkEnumerateInstanceExtensionProperties(NULL, &propertyCount, extensionProperties.data());
-    assertVkSuccess(res, "failed to enumerate extension properties");
+    bool debugUtilsSupported = false;
 
-    for(const auto& extensionName : requiredExtensionNames)
+    if(debugProfile)
     {
-        bool found = false;
+        // brak SDK to nie powód, żeby silnik nie wystartował - tylko ostrzegamy
+        bool validationSupported = false;
+        for(const auto& lp : layerProperties)
+        {
+            if(std::strcmp(lp.layerName, "VK_LAYER_KHRONOS_validation") == 0)
+            {
+                validationSupported = true;
+                break;
+            }
+        }
+        if(validationSupported)
+        {
+            requiredLayerNames.push_back("VK_LAYER_KHRONOS_validation");
+        }
+        else
+        {
+            logger::warning("VK_LAYER_KHRONOS_validation not installed, running debug profile without validation");
+        }
+
         for(const auto& ep : extensionProperties)
         {
-            if(std::strcmp(ep.extensionName, extensionName) == 0)
+            if(std::strcmp(ep.extensionName, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) == 0)
             {
-                found = true;
+                debugUtilsSupported = true;
                 break;
             }
         }
-        if(!found)
+        if(debugUtilsSupported)
         {
-            throw std::runtime_error("required extension not supported");
+            requiredExtensionNames.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+        else
+        {
+            logger::warning(VK_EXT_DEBUG_UTILS_EXTENSION_NAME, " not supported, validation messages go to the default output");
         }
     }
 
+    const VkDebugUtilsMessengerCreateInfoEXT messengerCreateInfo = DebugUtils::messengerCreateInfo();
+
     VkApplicationInfo appInfo{};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pNext = NULL;
@@ -147,7 +305,7 @@ void Engine::createInstance()
 
     VkInstanceCreateInfo instanceCreateInfo{};
     instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    instanceCreateInfo.pNext = NULL;
+    instanceCreateInfo.pNext = debugUtilsSupported ? &messengerCreateInfo : NULL; // komunikaty z vkCreateInstance/vkDestroyInstance
     instanceCreateInfo.flags = 0;
     instanceCreateInfo.pApplicationInfo = &appInfo;
     instanceCreateInfo.enabledLayerCount = static_cast<uint32_t>(requiredLayerNames.size());
@@ -155,32 +313,17 @@ void Engine::createInstance()
     instanceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(requiredExtensionNames.size());
     instanceCreateInfo.ppEnabledExtensionNames = requiredExtensionNames.data();
 
-    res = vkCreateInstance(&instanceCreateInfo, NULL, &mInstance);
+    VkInstance instance = VK_NULL_HANDLE;
+    res = vkCreateInstance(&instanceCreateInfo, NULL, &instance);
     assertVkSuccess(res, "failed to create instance");
-}
+    mInstance = InstanceHandle(instance);
 
-uint32_t Engine::findMemoryProperties(uint32_t memoryTypeBitsRequirement, VkMemoryPropertyFlags requiredProperties)
-{
-    const uint32_t memoryCount = mDeviceMemoryProperties.memoryTypeCount;
-
-    for(uint32_t memoryIndex = 0; memoryIndex < memoryCount; memoryIndex++)
+    if(debugUtilsSupported)
     {
-        const uint32_t memoryTypeBits = (1 << memoryIndex);
-        const bool isRequiredMemoryType = memoryTypeBitsRequirement & memoryTypeBits;
-
-        if(isRequiredMemoryType)
-        {
-            const VkMemoryPropertyFlags properties = mDeviceMemoryProperties.memoryTypes[memoryIndex].propertyFlags;
-            const bool hasRequiredProperties = (properties & requiredProperties) == requiredProperties;
-
-            if(isRequiredMemoryType && hasRequiredProperties)
-            {
-                return memoryIndex;
-            }
-        }
+        mDebugUtils.create(mInstance);
     }
 
-    throw std::runtime_error("failed to find memory type");
+    logger::info("profile: ", profileName(mSettings.profile), ", layers: ", requiredLayerNames.size(), ", debug utils: ", debugUtilsSupported ? "on" : "off");
 }
 
 void Engine::createDevice()
@@ -234,7 +377,9 @@ void Engine::createDevice()
 
     for(mQueueFamilyIndex = 0; mQueueFamilyIndex < queueFamilyProperties.size(); mQueueFamilyIndex++)
     {
-        if((queueFamilyProperties[mQueueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT) == VK_QUEUE_GRAPHICS_BIT)
+        // culling i cząsteczki idą compute'em w tym samym command bufferze - specyfikacja gwarantuje rodzinę z oboma
+        const VkQueueFlags requiredFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+        if((queueFamilyProperties[mQueueFamilyIndex].queueFlags & requiredFlags) == requiredFlags)
         {
             mQueueFamilyProperties = queueFamilyProperties[mQueueFamilyIndex];
             break;
@@ -259,7 +404,7 @@ void Engine::createDevice()
     res = vkEnumerateDeviceExtensionProperties(mPhysicalDevice, NULL, &propertyCount, extensionProperties.data());
     assertVkSuccess(res, "failed to enumerate device properties");
 
-    const std::vector<const char*> requiredExtensionNames =
+    std::vector<const char*> requiredExtensionNames =
     {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
@@ -281,6 +426,30 @@ void Engine::createDevice()
         }
     }
 
+    // budżet ze sterownika jest opcjonalny - bez niego alokator liczy tylko własne alokacje
+    bool memoryBudgetExtension = false;
+    for(const auto& ep : extensionProperties)
+    {
+        if(std::strcmp(ep.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+        {
+            memoryBudgetExtension = true;
+            requiredExtensionNames.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            break;
+        }
+    }
+
+    // czasy GPU w trace'ie - tylko gdy śledzenie jest włączone od startu
+    bool calibratedTimestampsExtension = false;
+    for(const auto& ep : extensionProperties)
+    {
+        if(trace::isEnabled() && std::strcmp(ep.extensionName, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0)
+        {
+            calibratedTimestampsExtension = true;
+            requiredExtensionNames.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+            break;
+        }
+    }
+
     VkPhysicalDeviceFeatures physicalDeviceFeatures;
     vkGetPhysicalDeviceFeatures(mPhysicalDevice, &physicalDeviceFeatures);
 
@@ -296,71 +465,122 @@ void Engine::createDevice()
     deviceCreateInfo.ppEnabledExtensionNames = requiredExtensionNames.data();
     deviceCreateInfo.pEnabledFeatures = NULL;  //na razie nie włączam żadnego, jak będą potrzebne to tu wrócę
 
-    res = vkCreateDevice(mPhysicalDevice, &deviceCreateInfo, NULL, &mDevice);
+    VkDevice device = VK_NULL_HANDLE;
+    res = vkCreateDevice(mPhysicalDevice, &deviceCreateInfo, NULL, &device);
     assertVkSuccess(res,"failed to create device");
+    mDevice = DeviceHandle(device);
 
     vkGetDeviceQueue(mDevice, mQueueFamilyIndex, 0, &mQueue);
+    mAllocator.init(mPhysicalDevice, device, memoryBudgetExtension, VkDeviceSize(mSettings.memoryBudget) << 20);
+    if(trace::isEnabled() && !(calibratedTimestampsExtension && mGpuTrace.create(mInstance, mPhysicalDevice, device, mFramesInFlight,
+                                                                                  mQueueFamilyProperties.timestampValidBits,
+                                                                                  mPhysicalDeviceProperties.limits.timestampPeriod)))
+    {
+        logger::info("trace: no calibrated GPU timestamps, trace will have CPU scopes only");
+    }
+    const uint32_t timestampValidBits = mPhysicalDeviceProperties.limits.timestampComputeAndGraphics ? mQueueFamilyProperties.timestampValidBits : 0;
+    if(mSettings.dynamicResolutionTarget > 0 &&
+       !mDynamicResolution.create(device, mFramesInFlight, timestampValidBits, mPhysicalDeviceProperties.limits.timestampPeriod, mSettings.dynamicResolutionTarget))
+    {
+        logger::warning("dynamic resolution: no GPU timestamps on the graphics queue, rendering at full resolution");
+    }
+
+    createPipelineCache();
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_DEVICE, device, "device");
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_QUEUE, mQueue, "graphics queue");
+}
+
+void Engine::createWindows()
+{
+    for(auto& output : mOutputs)
+    {
+        output->window = std::make_unique<Window>(mWindowWidth, mWindowHeight);
+    }
 }
 
-void Engine::createSurface()
+void Engine::createSurface(Output& output) // wołane po kolei dla wyjść - [0] wybiera format wspólny dla wszystkich
 {
 #ifdef VK_USE_PLATFORM_WIN32_KHR
     VkWin32SurfaceCreateInfoKHR win32SurfaceCreateInfo {};
     win32SurfaceCreateInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
     win32SurfaceCreateInfo.pNext = NULL;
     win32SurfaceCreateInfo.flags = 0;
-    win32SurfaceCreateInfo.hinstance = mWindow.getHinstance();
-    win32SurfaceCreateInfo.hwnd = mWindow.getHwnd();
+    win32SurfaceCreateInfo.hinstance = output.window->getHinstance();
+    win32SurfaceCreateInfo.hwnd = output.window->getHwnd();
 
-    VkResult res = vkCreateWin32SurfaceKHR(mInstance, &win32SurfaceCreateInfo, NULL, &mSurface);
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    VkResult res = vkCreateWin32SurfaceKHR(mInstance, &win32SurfaceCreateInfo, NULL, &surface);
     assertVkSuccess(res, "failed to create win32 surface");
 #elif defined(VK_USE_PLATFORM_XCB_KHR)
     VkXcbSurfaceCreateInfoKHR xcbSurfaceCreateInfo;
     xcbSurfaceCreateInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
     xcbSurfaceCreateInfo.pNext = NULL;
     xcbSurfaceCreateInfo.flags = 0;
-    xcbSurfaceCreateInfo.connection = mWindow.mConnection;
-    xcbSurfaceCreateInfo.window = mWindow.mWindowId;
+    xcbSurfaceCreateInfo.connection = output.window->mConnection;
+    xcbSurfaceCreateInfo.window = output.window->mWindowId;
 
-    VkResult res = vkCreateXcbSurfaceKHR(mInstance, &xcbSurfaceCreateInfo, NULL, &mSurface);
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    VkResult res = vkCreateXcbSurfaceKHR(mInstance, &xcbSurfaceCreateInfo, NULL, &surface);
     assertVkSuccess(res, "failed to create xcb surface");
 #endif
-    res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, mSurface, &mSurfaceCapabilities);
-    assertVkSuccess(res, "failed to get surface capabilities");
+    output.surface = SurfaceHandle(mInstance, surface);
 
     uint32_t surfaceFormatCount = 0;
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &surfaceFormatCount, NULL);
+    res = vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, output.surface, &surfaceFormatCount, NULL);
     assertVkSuccess(res, "failed to get surface formats");
 
-    mSurfaceFormats.resize(surfaceFormatCount);
+    std::vector<VkSurfaceFormatKHR> surfaceFormats(surfaceFormatCount);
 
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &surfaceFormatCount, mSurfaceFormats.data());
+    res = vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, output.surface, &surfaceFormatCount, surfaceFormats.data());
     assertVkSuccess(res, "failed to get surface formats");
 
-    VkBool32 supported;
-    res = vkGetPhysicalDeviceSurfaceSupportKHR(mPhysicalDevice, mQueueFamilyIndex, mSurface, &supported);
-    if(res == VK_FALSE)
+    if(mSwapchainImageFormat == VK_FORMAT_UNDEFINED)
+    {
+        mSwapchainImageFormat = surfaceFormats[0].format; // znany już tutaj, żeby renderpass nie czekał na swapchain
+        output.colorSpace = surfaceFormats[0].colorSpace;
+    }
+    else
+    {
+        // kolejne wyjścia muszą mieć ten sam format - inaczej potrzebny byłby drugi renderpass i pipeline
+        const auto format = std::find_if(surfaceFormats.begin(), surfaceFormats.end(), [this](const VkSurfaceFormatKHR& f){ return f.format == mSwapchainImageFormat; });
+        if(format == surfaceFormats.end())
+        {
+            throw std::runtime_error("output surface does not support the swapchain format of the first output");
+        }
+        output.colorSpace = format->colorSpace;
+    }
+
+    VkBool32 supported = VK_FALSE;
+    res = vkGetPhysicalDeviceSurfaceSupportKHR(mPhysicalDevice, mQueueFamilyIndex, output.surface, &supported);
+    if(res != VK_SUCCESS || supported == VK_FALSE) // present idzie tą samą kolejką co grafika
     {
-        std::runtime_error("surface is not supported");
+        throw std::runtime_error("surface is not supported");
     }
 }
 
-void Engine::createSwapchain() // tworzę zqwsze kiedy zmieniają sięjego parametry
+void Engine::createSwapchain(Output& output) // tworzę zqwsze kiedy zmieniają sięjego parametry
 {
-    VkSurfaceCapabilitiesKHR surfaceCapabilities {};
-    VkResult res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, mSurface, &surfaceCapabilities); //pozbyc sie tego ew. surface ze swapchainem
+    // jedno zapytanie na swapchain - przy odtwarzaniu po zmianie rozmiaru stare wartości są już nieaktualne
+    VkResult res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, output.surface, &output.surfaceCapabilities);
     assertVkSuccess(res, "failed to get surface capabilities");
+    const VkSurfaceCapabilitiesKHR& surfaceCapabilities = output.surfaceCapabilities;
 
     VkSwapchainCreateInfoKHR swapchainCreateInfo {};
     swapchainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     swapchainCreateInfo.pNext = NULL;
     swapchainCreateInfo.flags = 0;
-    swapchainCreateInfo.surface = mSurface;
-    swapchainCreateInfo.minImageCount = (mSurfaceCapabilities.minImageCount + 1) < mSurfaceCapabilities.maxImageCount ? (mSurfaceCapabilities.minImageCount + 1) : mSurfaceCapabilities.minImageCount; // warunek ? jeśli true : jeśli false
-    swapchainCreateInfo.imageFormat = mSurfaceFormats[0].format;
-    swapchainCreateInfo.imageColorSpace = mSurfaceFormats[0].colorSpace;
+    swapchainCreateInfo.surface = output.surface;
+    // maxImageCount == 0 - brak limitu
+    swapchainCreateInfo.minImageCount = (surfaceCapabilities.maxImageCount == 0 || surfaceCapabilities.minImageCount + 1 <= surfaceCapabilities.maxImageCount) ? (surfaceCapabilities.minImageCount + 1) : surfaceCapabilities.minImageCount; // warunek ? jeśli true : jeśli false
+    swapchainCreateInfo.imageFormat = mSwapchainImageFormat;
+    swapchainCreateInfo.imageColorSpace = output.colorSpace;
     swapchainCreateInfo.imageArrayLayers = 1; //non-stereoscopic 3d app = 1
     swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    output.readable = (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+    if(output.readable)
+    {
+        swapchainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // do readbacku
+    }
     swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE; //dostęp do obrazka będzie mieć jednocześnie jedna rodzina kolejek
     swapchainCreateInfo.queueFamilyIndexCount = mQueueCount;
     swapchainCreateInfo.pQueueFamilyIndices = VK_NULL_HANDLE; //zero bo ^SHARING_MODE_EXCLUSIVE
@@ -369,40 +589,60 @@ void Engine::createSwapchain() // tworzę zqwsze kiedy zmieniają sięjego param
     swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchainCreateInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR; // v-sync, aktualizuję cały bufor i dopiero go wyświetlam
     swapchainCreateInfo.clipped = VK_TRUE;
-    swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+    swapchainCreateInfo.oldSwapchain = output.swapchain; // VK_NULL_HANDLE przy pierwszym tworzeniu
 
-    if((mSurfaceCapabilities.currentExtent.width != 0xffffffff) && (mSurfaceCapabilities.currentExtent.height != 0xffffffff))
+    if((surfaceCapabilities.currentExtent.width != 0xffffffff) && (surfaceCapabilities.currentExtent.height != 0xffffffff))
     {
         swapchainCreateInfo.imageExtent = surfaceCapabilities.currentExtent;
     }
     else
     {
-        swapchainCreateInfo.imageExtent.width = mWindowWidth;
-        swapchainCreateInfo.imageExtent.height = mWindowHeight;
+        swapchainCreateInfo.imageExtent.width = std::clamp<uint32_t>(mWindowWidth, surfaceCapabilities.minImageExtent.width, surfaceCapabilities.maxImageExtent.width);
+        swapchainCreateInfo.imageExtent.height = std::clamp<uint32_t>(mWindowHeight, surfaceCapabilities.minImageExtent.height, surfaceCapabilities.maxImageExtent.height);
     }
-    mSwapchainWidth = swapchainCreateInfo.imageExtent.width;
-    mSwapchainHeight = swapchainCreateInfo.imageExtent.height;
+    output.width = swapchainCreateInfo.imageExtent.width;
+    output.height = swapchainCreateInfo.imageExtent.height;
 
-    mSwapchainImageFormat = swapchainCreateInfo.imageFormat;
+    if(!mSettings.vsync)
+    {
+        uint32_t presentModeCount = 0;
+        res = vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, output.surface, &presentModeCount, NULL);
+        assertVkSuccess(res, "failed to get surface present modes");
+        std::vector<VkPresentModeKHR> presentModes(presentModeCount);
+        res = vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, output.surface, &presentModeCount, presentModes.data());
+        assertVkSuccess(res, "failed to get surface present modes");
+
+        for(auto presentMode : {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR}) // FIFO zostaje, jeśli żaden nie jest dostępny
+        {
+            if(std::find(presentModes.begin(), presentModes.end(), presentMode) != presentModes.end())
+            {
+                swapchainCreateInfo.presentMode = presentMode;
+                break;
+            }
+        }
+    }
 
-    res = vkCreateSwapchainKHR(mDevice, &swapchainCreateInfo, NULL, &mSwapchain);
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    res = vkCreateSwapchainKHR(mDevice, &swapchainCreateInfo, NULL, &swapchain);
     assertVkSuccess(res, "failed to create swapchain");
+    output.swapchain = SwapchainHandle(mDevice, swapchain);
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_SWAPCHAIN_KHR, swapchain, output.name + " swapchain");
 
-    res = vkGetSwapchainImagesKHR(mDevice, mSwapchain, &mSwapchainImageCount, NULL);
+    res = vkGetSwapchainImagesKHR(mDevice, output.swapchain, &output.swapchainImageCount, NULL);
     assertVkSuccess(res, "failed to get swapchain images");
-    mSwapchainImages.resize(mSwapchainImageCount);
-    res = vkGetSwapchainImagesKHR(mDevice, mSwapchain, &mSwapchainImageCount, mSwapchainImages.data());
+    output.swapchainImages.resize(output.swapchainImageCount);
+    res = vkGetSwapchainImagesKHR(mDevice, output.swapchain, &output.swapchainImageCount, output.swapchainImages.data());
     assertVkSuccess(res, "failed to get swapchain images");
 
-    mImageViews.resize(mSwapchainImages.size());
+    output.imageViews.resize(output.swapchainImages.size());
 
-    for(uint32_t i = 0; i < mImageViews.size(); i++)
+    for(uint32_t i = 0; i < output.swapchainImageCount; i++)
     {
         VkImageViewCreateInfo imageViewCreateInfo {};
         imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         imageViewCreateInfo.pNext = NULL;
         imageViewCreateInfo.flags = 0;
-        imageViewCreateInfo.image = mSwapchainImages[i];
+        imageViewCreateInfo.image = output.swapchainImages[i];
         imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
         imageViewCreateInfo.format = mSwapchainImageFormat;
         imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -415,18 +655,39 @@ void Engine::createSwapchain() // tworzę zqwsze kiedy zmieniają sięjego param
         imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
         imageViewCreateInfo.subresourceRange.layerCount = 1;
 
-        VkResult res = vkCreateImageView(mDevice, &imageViewCreateInfo, NULL, &mImageViews[i]);
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkResult res = vkCreateImageView(mDevice, &imageViewCreateInfo, NULL, &imageView);
         assertVkSuccess(res, "failed to create image view");
+        output.imageViews[i] = ImageViewHandle(mDevice, imageView);
+
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_IMAGE, output.swapchainImages[i], output.name + " swapchain image " + std::to_string(i));
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_IMAGE_VIEW, imageView, output.name + " swapchain image view " + std::to_string(i));
+    }
+
+    // semafory acquire należą do swapchaina - każde wyjście pobiera obraz osobno, submit czeka na wszystkie
+    VkSemaphoreCreateInfo semaphoreCreateInfo {};
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = NULL;
+    semaphoreCreateInfo.flags = 0;
+
+    output.acquireSemaphores.resize(mFramesInFlight);
+    for(uint32_t i = 0; i < mFramesInFlight; i++)
+    {
+        VkSemaphore acquireSemaphore = VK_NULL_HANDLE;
+        res = vkCreateSemaphore(mDevice, &semaphoreCreateInfo, NULL, &acquireSemaphore);
+        assertVkSuccess(res, "failed to create aqcuire semaphore");
+        output.acquireSemaphores[i] = SemaphoreHandle(mDevice, acquireSemaphore);
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_SEMAPHORE, acquireSemaphore, output.name + " acquire semaphore " + std::to_string(i));
     }
 }
 
-void Engine::createDepthImage()
+void Engine::createDepthImage(Output& output)
 {
     VkImage depthImage = VK_NULL_HANDLE;
     VkImageView depthImageView = VK_NULL_HANDLE;
 
-    mDepthImages.resize(mSwapchainImageCount);
-    mDepthImageViews.resize(mSwapchainImageCount);
+    output.depthImages.resize(output.swapchainImageCount);
+    output.depthImageViews.resize(output.swapchainImageCount);
 
     VkImageCreateInfo depthImageCreateInfo {};
     depthImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -434,14 +695,14 @@ void Engine::createDepthImage()
     depthImageCreateInfo.flags = 0;
     depthImageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
     depthImageCreateInfo.format = VK_FORMAT_D32_SFLOAT;
-    depthImageCreateInfo.extent.width = mWindowWidth;
-    depthImageCreateInfo.extent.height = mWindowHeight;
+    depthImageCreateInfo.extent.width = output.width;
+    depthImageCreateInfo.extent.height = output.height;
     depthImageCreateInfo.extent.depth = 1;
     depthImageCreateInfo.mipLevels = 1;
     depthImageCreateInfo.arrayLayers = 1;
     depthImageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     depthImageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    depthImageCreateInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    depthImageCreateInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT; // sampled - źródło piramidy Hi-Z
     depthImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     depthImageCreateInfo.queueFamilyIndexCount = 0;
 //    depthImageCreateInfo.pQueueFamilyIndices; ignored
@@ -460,37 +721,94 @@ void Engine::createDepthImage()
     depthImageViewCreateInfo.subresourceRange.layerCount = 1;
     depthImageViewCreateInfo.subresourceRange.levelCount = 1;
 
-    vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &mDeviceMemoryProperties); //TODO przenieść to w mądrzejsze miejsce
-
-    mDeviceMemory.resize(mSwapchainImageCount);
+    output.depthMemory.resize(output.swapchainImageCount);
 
-    for(uint32_t i = 0; i < mSwapchainImageCount; i++)
+    for(uint32_t i = 0; i < output.swapchainImageCount; i++)
     {
-        VkResult res = vkCreateImage(mDevice, &depthImageCreateInfo, NULL, &depthImage); // każdy image musi mieć podpiętą pamięć zaalokowaną na karcie -> findMemoryProperties
+        VkResult res = vkCreateImage(mDevice, &depthImageCreateInfo, NULL, &depthImage); // każdy image musi mieć podpiętą pamięć zaalokowaną na karcie -> mAllocator
         assertVkSuccess(res, "failed to create depth image");
-        mDepthImages[i] = depthImage;
+        output.depthImages[i] = ImageHandle(mDevice, depthImage);
 
         depthImageViewCreateInfo.image = depthImage;
 
-        const auto requiredProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
         VkMemoryRequirements memoryRequirements;
         vkGetImageMemoryRequirements(mDevice, depthImage, &memoryRequirements);
 
-        uint32_t memoryIndex = findMemoryProperties(memoryRequirements.memoryTypeBits, requiredProperties);
-
-        VkMemoryAllocateInfo allocateCreateInfo {};
-        allocateCreateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocateCreateInfo.pNext = NULL;
-        allocateCreateInfo.allocationSize = memoryRequirements.size;
-        allocateCreateInfo.memoryTypeIndex = memoryIndex;
-
-        vkAllocateMemory(mDevice, &allocateCreateInfo, NULL, &mDeviceMemory[i]);
-        vkBindImageMemory(mDevice, depthImage, mDeviceMemory[i], 0);
+        output.depthMemory[i] = mAllocator.allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        VkDeviceMemory deviceMemory = output.depthMemory[i];
+        vkBindImageMemory(mDevice, depthImage, deviceMemory, 0);
 
         res = vkCreateImageView(mDevice, &depthImageViewCreateInfo, NULL, &depthImageView);
         assertVkSuccess(res, "failed to create depth image view");
-        mDepthImageViews[i] = depthImageView;
+        output.depthImageViews[i] = ImageViewHandle(mDevice, depthImageView);
+
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_IMAGE, depthImage, output.name + " depth image " + std::to_string(i));
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_IMAGE_VIEW, depthImageView, output.name + " depth image view " + std::to_string(i));
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_DEVICE_MEMORY, deviceMemory, output.name + " depth memory " + std::to_string(i));
+    }
+}
+
+void Engine::createColorImage(Output& output)
+{
+    if(!mDynamicResolution.isEnabled())
+    {
+        return;
+    }
+
+    // obraz ma pełny rozmiar wyjścia - zmiana skali to tylko inny renderArea, bez tworzenia obrazów w trakcie
+    VkImageCreateInfo colorImageCreateInfo {};
+    colorImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    colorImageCreateInfo.pNext = NULL;
+    colorImageCreateInfo.flags = 0;
+    colorImageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    colorImageCreateInfo.format = mSwapchainImageFormat; // ten sam renderpass co bez dynamicznej rozdzielczości
+    colorImageCreateInfo.extent.width = output.width;
+    colorImageCreateInfo.extent.height = output.height;
+    colorImageCreateInfo.extent.depth = 1;
+    colorImageCreateInfo.mipLevels = 1;
+    colorImageCreateInfo.arrayLayers = 1;
+    colorImageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorImageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    colorImageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // transfer src - źródło blitu
+    colorImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    colorImageCreateInfo.queueFamilyIndexCount = 0;
+    colorImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImageViewCreateInfo colorImageViewCreateInfo {};
+    colorImageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    colorImageViewCreateInfo.pNext = NULL;
+    colorImageViewCreateInfo.flags = 0;
+    colorImageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    colorImageViewCreateInfo.format = colorImageCreateInfo.format;
+    colorImageViewCreateInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    colorImageViewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    output.colorImages.resize(output.swapchainImageCount);
+    output.colorImageViews.resize(output.swapchainImageCount);
+    output.colorMemory.resize(output.swapchainImageCount);
+
+    for(uint32_t i = 0; i < output.swapchainImageCount; i++)
+    {
+        VkImage colorImage = VK_NULL_HANDLE;
+        VkResult res = vkCreateImage(mDevice, &colorImageCreateInfo, NULL, &colorImage);
+        assertVkSuccess(res, "failed to create offscreen color image");
+        output.colorImages[i] = ImageHandle(mDevice, colorImage);
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(mDevice, colorImage, &memoryRequirements);
+        output.colorMemory[i] = mAllocator.allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        VkDeviceMemory deviceMemory = output.colorMemory[i];
+        vkBindImageMemory(mDevice, colorImage, deviceMemory, 0);
+
+        colorImageViewCreateInfo.image = colorImage;
+        VkImageView colorImageView = VK_NULL_HANDLE;
+        res = vkCreateImageView(mDevice, &colorImageViewCreateInfo, NULL, &colorImageView);
+        assertVkSuccess(res, "failed to create offscreen color image view");
+        output.colorImageViews[i] = ImageViewHandle(mDevice, colorImageView);
+
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_IMAGE, colorImage, output.name + " color image " + std::to_string(i));
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_IMAGE_VIEW, colorImageView, output.name + " color image view " + std::to_string(i));
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_DEVICE_MEMORY, deviceMemory, output.name + " color memory " + std::to_string(i));
     }
 }
 
@@ -502,8 +820,10 @@ void Engine::createCommandBuffer() // trzeba się synchronizować, żeby proceso
     commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     commandPoolCreateInfo.queueFamilyIndex = mQueueFamilyIndex;
 
-    VkResult res = vkCreateCommandPool(mDevice, &commandPoolCreateInfo, NULL, &mCommandPool);
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkResult res = vkCreateCommandPool(mDevice, &commandPoolCreateInfo, NULL, &commandPool);
     assertVkSuccess(res, "failed to create command pool");
+    mCommandPool = CommandPoolHandle(mDevice, commandPool);
 
     VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
     commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -515,6 +835,12 @@ void Engine::createCommandBuffer() // trzeba się synchronizować, żeby proceso
     res = vkAllocateCommandBuffers(mDevice, &commandBufferAllocateInfo, mCommandBuffers.data());  //initial state
     assertVkSuccess(res, "failed to allocate command buffers");
 
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_COMMAND_POOL, commandPool, "command pool");
+    for(uint32_t i = 0; i < mFramesInFlight; i++)
+    {
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_COMMAND_BUFFER, mCommandBuffers[i], "frame command buffer " + std::to_string(i));
+    }
+
     mCommandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     mCommandBufferBeginInfo.pNext = NULL;
     mCommandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -535,7 +861,8 @@ void Engine::createFence()
     {
         VkResult res = vkCreateFence(mDevice, &fenceCreateInfo, NULL, &queueSubmitFence);
         assertVkSuccess(res, "failed to create fence");
-        mQueueSubmitFences[i] = queueSubmitFence;
+        mQueueSubmitFences[i] = FenceHandle(mDevice, queueSubmitFence);
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_FENCE, queueSubmitFence, "queue submit fence " + std::to_string(i));
     }
 }
 
@@ -552,16 +879,8 @@ void Engine::createSemaphores()
     {
         VkResult res = vkCreateSemaphore(mDevice, &semaphoreCreateInfo, NULL, &queueSubmitSemaphore);
         assertVkSuccess(res, "failed to create queue submit semaphore");
-        mQueueSubmitSemaphores[i] = queueSubmitSemaphore;
-    }
-
-    VkSemaphore acquireSemaphore = VK_NULL_HANDLE;
-    mAcquireSemaphores.resize(mFramesInFlight);
-    for(uint32_t i = 0; i < mFramesInFlight; i++)
-    {
-        VkResult res = vkCreateSemaphore(mDevice, &semaphoreCreateInfo, NULL, &acquireSemaphore);
-        assertVkSuccess(res, "failed to create aqcuire semaphore");
-        mAcquireSemaphores[i] = acquireSemaphore;
+        mQueueSubmitSemaphores[i] = SemaphoreHandle(mDevice, queueSubmitSemaphore);
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_SEMAPHORE, queueSubmitSemaphore, "queue submit semaphore " + std::to_string(i));
     }
 }
 
@@ -595,6 +914,19 @@ void Engine::createRenderPass()
     attachmentDescriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     attachmentDescriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     attachmentDescriptions[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    if(mDynamicResolution.isEnabled())
+    {
+        // kolor idzie do obrazu poza ekranem, który jest potem źródłem blitu na swapchain
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, mSwapchainImageFormat, &formatProperties);
+        const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+        if((formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures)
+        {
+            throw std::runtime_error("dynamic resolution: swapchain format does not support blits");
+        }
+        mUpscaleFilter = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+        attachmentDescriptions[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    }
 
     attachmentDescriptions[1].flags = 0; //indeks 1 - depthattachment
     attachmentDescriptions[1].format = VK_FORMAT_D32_SFLOAT;
@@ -614,22 +946,37 @@ void Engine::createRenderPass()
     renderPassCreateInfo.pAttachments = attachmentDescriptions.data();
     renderPassCreateInfo.subpassCount = 1;
     renderPassCreateInfo.pSubpasses = &mSubpass;
-    renderPassCreateInfo.dependencyCount = 0;
-    renderPassCreateInfo.pDependencies = NULL;
-
-    VkResult res = vkCreateRenderPass(mDevice, &renderPassCreateInfo, NULL, &mRenderPass);
+    // głębia z poprzedniej ramki jest czytana przez culling (compute) - clear może ruszyć dopiero po nim
+    VkSubpassDependency depthDependency {};
+    depthDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    depthDependency.dstSubpass = 0;
+    depthDependency.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    depthDependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    depthDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depthDependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depthDependency.dependencyFlags = 0;
+
+    renderPassCreateInfo.dependencyCount = 1;
+    renderPassCreateInfo.pDependencies = &depthDependency;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkResult res = vkCreateRenderPass(mDevice, &renderPassCreateInfo, NULL, &renderPass);
     assertVkSuccess(res, "failed to create renderpass");
+    mRenderPass = RenderPassHandle(mDevice, renderPass);
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_RENDER_PASS, renderPass, "main renderpass");
 }
 
-void Engine::createFrameBuffer() //dla róznych obrazków rózny frame buffer
+void Engine::createFrameBuffer(Output& output) //dla róznych obrazków rózny frame buffer
 {
-    for(uint32_t i = 0; i < mSwapchainImageCount; i++)
+    output.framebuffers.clear(); // przy odtwarzaniu swapchaina
+    output.framebuffers.reserve(output.swapchainImageCount);
+    for(uint32_t i = 0; i < output.swapchainImageCount; i++)
     {
         VkFramebuffer framebuffer = VK_NULL_HANDLE;
 
-        std::vector<VkImageView> framebufferAttachment(mSwapchainImageCount);
-        framebufferAttachment[0] = mImageViews[i]; //już konkretne, w renderpass tylko szablon
-        framebufferAttachment[1] = mDepthImageViews[i];
+        std::array<VkImageView, 2> framebufferAttachment;
+        framebufferAttachment[0] = mDynamicResolution.isEnabled() ? output.colorImageViews[i].get() : output.imageViews[i].get(); //już konkretne, w renderpass tylko szablon
+        framebufferAttachment[1] = output.depthImageViews[i];
 
         VkFramebufferCreateInfo framebufferCreateInfo {};
         framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -638,18 +985,75 @@ void Engine::createFrameBuffer() //dla róznych obrazków rózny frame buffer
         framebufferCreateInfo.renderPass = mRenderPass;
         framebufferCreateInfo.attachmentCount = 2; //color and depth
         framebufferCreateInfo.pAttachments = framebufferAttachment.data();
-        framebufferCreateInfo.width = mWindowWidth;
-        framebufferCreateInfo.height = mWindowHeight;
+        framebufferCreateInfo.width = output.width;
+        framebufferCreateInfo.height = output.height;
         framebufferCreateInfo.layers = 1;
         // dla każdego swapchain jeden framebuff i potem podczas renderowania jak sprawdzę na którym obrazku mogę pisać to na podstawie tego wybieram framebuff o danym indeksie
 
         VkResult res = vkCreateFramebuffer(mDevice, &framebufferCreateInfo, NULL, &framebuffer);
         assertVkSuccess(res, "failed to create framebuffer");
-        mFramebuffers.push_back(framebuffer);
+        output.framebuffers.emplace_back(mDevice, framebuffer);
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_FRAMEBUFFER, framebuffer, output.name + " framebuffer " + std::to_string(i));
+    }
+}
+
+bool Engine::recreateSwapchain(Output& output)
+{
+    TRACE_SCOPE("recreate swapchain");
+    VkResult res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, output.surface, &output.surfaceCapabilities);
+    assertVkSuccess(res, "failed to get surface capabilities");
+    if(output.surfaceCapabilities.currentExtent.width == 0 || output.surfaceCapabilities.currentExtent.height == 0)
+    {
+        return false; // swapchain nie może mieć zerowego rozmiaru - zostaje stary do czasu przywrócenia okna
+    }
+
+    // zmiana rozmiaru jest rzadka - zamiast śledzić, które ramki w locie używają starych obrazów, czekamy na wszystkie
+    vkDeviceWaitIdle(mDevice);
+    output.framebuffers.clear(); // framebuffery przed widokami, widoki przed swoimi obrazami
+    output.imageViews.clear();
+    output.depthImageViews.clear();
+    output.colorImageViews.clear();
+    createSwapchain(output);
+    createDepthImage(output);
+    createColorImage(output);
+    createFrameBuffer(output);
+    if(mSettings.occlusionCulling)
+    {
+        {
+            OcclusionCuller old = std::move(output.occlusionCuller); // piramida ma rozmiar starej głębi
+        }
+        output.occlusionCuller = OcclusionCuller();
+        createOcclusionCulling(output);
+    }
+    output.previousImageIndex = UINT32_MAX; // nowa głębia nie ma jeszcze nic z poprzedniej ramki
+    if(&output == mOutputs[0].get())
+    {
+        mReadback.resize(output.width, output.height);
+    }
+    output.resized = false;
+    invalidateCommandBuffers(); // nagrane bufory mają stare framebuffery
+    logger::info(output.name, " swapchain recreated at ", output.width, "x", output.height);
+    return true;
+}
+
+void Engine::loadShaders()
+{
+    mVertexShaderCode = loadShader("shaders/vs.spv");
+    mFragmentShaderCode = loadShader("shaders/fs.spv");
+    if(mSettings.occlusionCulling)
+    {
+        mDepthPyramidShaderCode = loadShader("shaders/depthpyramid.spv");
+        mCullShaderCode = loadShader("shaders/cull.spv");
+    }
+    if(mSettings.particleCount > 0)
+    {
+        mParticleSimulationShaderCode = loadShader("shaders/particles.spv");
+        mParticleVertexShaderCode = loadShader("shaders/particle_vs.spv");
+        mParticleFragmentShaderCode = loadShader("shaders/particle_fs.spv");
     }
 }
 
-void Engine::createPipeline()
+void Engine::createPipelineLayout()
 {
     VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
     pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -657,38 +1061,134 @@ void Engine::createPipeline()
     pipelineLayoutCreateInfo.flags = 0;
     pipelineLayoutCreateInfo.setLayoutCount = 0;
     pipelineLayoutCreateInfo.pSetLayouts = VK_NULL_HANDLE; //pewnie kiedyś będę chciała to ustawić
-    pipelineLayoutCreateInfo.pushConstantRangeCount = 0; // 256bajtów do szybciej aktualizacji
-    pipelineLayoutCreateInfo.pPushConstantRanges = VK_NULL_HANDLE;
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(DrawConstants);
+
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1; // 256bajtów do szybciej aktualizacji
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
-    VkResult res = vkCreatePipelineLayout(mDevice, &pipelineLayoutCreateInfo, NULL, &mPipelineLayout);
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkResult res = vkCreatePipelineLayout(mDevice, &pipelineLayoutCreateInfo, NULL, &pipelineLayout);
     assertVkSuccess(res, "failed to create pipeline layout");
+    mPipelineLayout = PipelineLayoutHandle(mDevice, pipelineLayout);
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipelineLayout, "main pipeline layout");
+}
 
-    std::vector<VkShaderModuleCreateInfo> shaderModuleCreateInfos(2);
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos(2);
+void Engine::createGeometry()
+{
+    Sphere meshBounds;
+    if(!mSettings.meshPath.empty())
+    {
+        // plik jest zmapowany, więc dane idą prosto ze stron pliku do stagingu - bez parsowania i kopii pośrednich
+        const auto start = std::chrono::steady_clock::now();
+        const MeshFile mesh(mSettings.meshPath);
+        mVertexLayout = mesh.layout();
+        mMeshQuantization = mesh.quantization();
+        mMeshVertexCount = mesh.header().vertexCount;
+        mMeshLods.assign(mesh.lods(), mesh.lods() + mesh.header().lodCount);
+        if(mMeshLods.empty())
+        {
+            mMeshLods.push_back({0, mesh.header().indexCount, 0.0f, 0});
+        }
+        const float* sphere = mesh.header().boundingSphere;
+        meshBounds = {sphere[0], sphere[1], sphere[2], sphere[3]};
+        mMeshIndexType = mesh.header().indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+        const VkDeviceSize totalSize = mesh.vertexDataSize() + mesh.indexDataSize();
+        StagingUploader uploader(mDevice, mQueue, mQueueFamilyIndex, mAllocator, totalSize + 2 * meshFileAlignment);
+        mMeshVertices = uploader.upload(mesh.vertexData(), mesh.vertexDataSize(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        mMeshIndices = uploader.upload(mesh.indexData(), mesh.indexDataSize(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        uploader.submit();
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const double megabytes = double(totalSize) / (1024.0 * 1024.0);
+        logger::info("mesh ", mSettings.meshPath, ": ", mMeshVertexCount, " vertices, ", mesh.header().indexCount, " indices, ",
+                     megabytes, " MB in ", ms, " ms (", megabytes / (ms / 1000.0), " MB/s)");
+    }
+    else
+    {
+        const std::vector<MeshVertex> vertices = createCubeVertices();
+        mMeshVertexCount = vertices.size();
+        mMeshLods = {{0, mMeshVertexCount, 0.0f, 0}};
+        mMeshIndexType = VK_INDEX_TYPE_UINT16;
+        meshBounds = {0.0f, 0.0f, 0.0f, std::sqrt(0.75f)};
+        mMeshQuantization = computeQuantization(mVertexLayout, vertices.data(), vertices.size());
+
+        std::vector<uint8_t> encoded(vertices.size() * mVertexLayout.stride);
+        encodeVertices(mVertexLayout, mMeshQuantization, vertices.data(), vertices.size(), encoded.data());
+        // trywialne indeksy - wszystkie siatki idą tą samą ścieżką vkCmdDrawIndexed(Indirect)
+        std::vector<uint16_t> indices(vertices.size());
+        std::iota(indices.begin(), indices.end(), uint16_t(0));
+
+        const VkDeviceSize indexSize = indices.size() * sizeof(uint16_t);
+        StagingUploader uploader(mDevice, mQueue, mQueueFamilyIndex, mAllocator, encoded.size() + indexSize + 16);
+        mMeshVertices = uploader.upload(encoded.data(), encoded.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        mMeshIndices = uploader.upload(indices.data(), indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        uploader.submit();
+    }
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_BUFFER, mMeshVertices.buffer.get(), "mesh vertices");
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_BUFFER, mMeshIndices.buffer.get(), "mesh indices");
+
+    std::vector<float> lodErrors;
+    for(const MeshLod& lod : mMeshLods)
+    {
+        lodErrors.push_back(lod.error);
+    }
+    mLodSelector.setMesh(meshBounds, lodErrors.data(), mMeshLods.size());
+
+    mInstanceBuffer.create(mAllocator, mFramesInFlight);
+
+    logger::info("vertex layout: ", vertexLayoutName(mVertexLayout.type), ", ", mVertexLayout.stride, " B per vertex (full: ",
+                 VertexLayout::create(VertexLayoutType::Full).stride, " B)");
+}
+
+void Engine::createOcclusionCulling(Output& output)
+{
+    if(!mSettings.occlusionCulling)
+    {
+        return;
+    }
+    output.occlusionCuller.create(mDevice, mAllocator, mFramesInFlight, output.width, output.height, mDepthPyramidShaderCode, mCullShaderCode);
+    logger::info(output.name, " occlusion culling: depth pyramid ", output.occlusionCuller.pyramidLevels(), " levels");
+}
+
+void Engine::createParticles()
+{
+    if(mSettings.particleCount == 0)
+    {
+        return;
+    }
+    const uint32_t timestampValidBits = mPhysicalDeviceProperties.limits.timestampComputeAndGraphics ? mQueueFamilyProperties.timestampValidBits : 0;
+    mParticles.create(mDevice, mAllocator, mRenderPass, mPipelineCache, mSettings.particleCount, mFramesInFlight, timestampValidBits,
+                      mPhysicalDeviceProperties.limits.timestampPeriod, mParticleSimulationShaderCode, mParticleVertexShaderCode, mParticleFragmentShaderCode);
+    mLastRenderTime = std::chrono::steady_clock::now();
+    logger::info("particles: ", mSettings.particleCount, " (", (VkDeviceSize(mSettings.particleCount) * sizeof(Particle)) >> 20, " MiB on GPU)");
+}
 
-    /*----------- open vertex shader --------*/
-    std::ifstream vsfile("shaders/vs.spv", std::ios::ate | std::ios::binary);
-    if(!vsfile)
+void Engine::createTextureStreamer()
+{
+    if(mSettings.texturePaths.empty())
     {
-        throw std::runtime_error("shader file does not exist");
+        return;
     }
-    const size_t vsSize = vsfile.tellg();
-    if (vsSize == 0)
+    // połowa rdzeni - wątki ładujące głównie czekają na dysk, a render i okno też potrzebują swoich
+    const uint32_t loaderThreads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+    mTextureStreamer.create(mPhysicalDevice, mDevice, mAllocator, mDeletionQueue, mFramesInFlight, VkDeviceSize(mSettings.textureUploadBudget) << 20, loaderThreads);
+    for(const std::string& path : mSettings.texturePaths)
     {
-        throw std::runtime_error("shader file empty");
+        mTextures.push_back(mTextureStreamer.load(path));
     }
-    vsfile.seekg(0);
-    std::vector<uint32_t> vsCode((vsSize - 1) / 4 + 1);
-    vsfile.read(reinterpret_cast<char*>(vsCode.data()), vsSize);
+    logger::info("texture streaming: ", mTextures.size(), " textures, ", loaderThreads, " loader threads, ", mSettings.textureUploadBudget, " MiB per frame");
+}
+
+PipelineHandle Engine::createPipeline(const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode) const
+{
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos(2);
 
-    shaderModuleCreateInfos[0].sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO; //reprezentuje skompilowany shader
-    shaderModuleCreateInfos[0].pNext = NULL;
-    shaderModuleCreateInfos[0].flags = 0;
-    shaderModuleCreateInfos[0].codeSize = vsSize;
-    shaderModuleCreateInfos[0].pCode = vsCode.data();
-    VkShaderModule vertexShaderModule;
-    res = vkCreateShaderModule(mDevice, &shaderModuleCreateInfos[0], NULL, &vertexShaderModule);
-    assertVkSuccess(res, "failed to create vs module");
+    /*----------- vertex shader module --------*/
+    const ShaderModuleHandle vertexShaderModule = createShaderModule(mDevice, vertexShaderCode); // niszczone po stworzeniu pipeline'u, bo już niepotrzebne
 
     shaderStageCreateInfos[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //reprezentuje cały etap
     shaderStageCreateInfos[0].pNext = NULL;
@@ -698,29 +1198,8 @@ void Engine::createPipeline()
     shaderStageCreateInfos[0].pName = "main";
     shaderStageCreateInfos[0].pSpecializationInfo = NULL;
 
-    /*----------- open fragment shader --------*/
-    std::ifstream fsfile("shaders/fs.spv", std::ios::ate | std::ios::binary);
-    if(!fsfile)
-    {
-        throw std::runtime_error("shader file does not exist");
-    }
-    const size_t fsSize = fsfile.tellg();
-    if (fsSize == 0)
-    {
-        throw std::runtime_error("shader file empty");
-    }
-    fsfile.seekg(0);
-    std::vector<uint32_t> fsCode((fsSize - 1) / 4 + 1);
-    fsfile.read(reinterpret_cast<char*>(fsCode.data()), fsSize);
-
-    shaderModuleCreateInfos[1].sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shaderModuleCreateInfos[1].pNext = NULL;
-    shaderModuleCreateInfos[1].flags = 0;
-    shaderModuleCreateInfos[1].codeSize = fsSize;
-    shaderModuleCreateInfos[1].pCode = fsCode.data();
-    VkShaderModule fragmentShaderModule;
-    res = vkCreateShaderModule(mDevice, &shaderModuleCreateInfos[1], NULL, &fragmentShaderModule);
-    assertVkSuccess(res, "failed to create fs module");
+    /*----------- fragment shader module --------*/
+    const ShaderModuleHandle fragmentShaderModule = createShaderModule(mDevice, fragmentShaderCode);
 
     shaderStageCreateInfos[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shaderStageCreateInfos[1].pNext = NULL;
@@ -730,37 +1209,35 @@ void Engine::createPipeline()
     shaderStageCreateInfos[1].pName = "main";
     shaderStageCreateInfos[1].pSpecializationInfo = NULL;
 
-    struct alignas(16) Vertex
-    {
-        std::array<float, 3> position;
-        float pad;
-        std::array<float, 4> color;
-    };
-
-    VkVertexInputBindingDescription bindingDescription {};
-    bindingDescription.binding = 0; //indeks vertexbuff z którego będą pobierane atrybuty
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; //indeksuję vertexbuff indeksem wierzchołków
-    //binding = 1, przykładowo vertex input instance - gdy do rysowania kilka elementów
+    // binding 0 - wierzchołki w formacie z VertexLayout, binding 1 - rekordy instancji ze sceny
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributesDescriptions;
+    describeVertexInput(mVertexLayout, 0, bindingDescriptions, vertexAttributesDescriptions);
 
-    std::vector<VkVertexInputAttributeDescription> vertexAttributesDescriptions(2);
-    vertexAttributesDescriptions[0].location = 0;  //vertex position
-    vertexAttributesDescriptions[0].binding = 0;
-    vertexAttributesDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertexAttributesDescriptions[0].offset = 0;
+    VkVertexInputBindingDescription instanceBindingDescription {};
+    instanceBindingDescription.binding = 1;
+    instanceBindingDescription.stride = sizeof(InstanceData);
+    instanceBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    bindingDescriptions.push_back(instanceBindingDescription);
 
-    vertexAttributesDescriptions[1].location = 1;  //vertex color
-    vertexAttributesDescriptions[1].binding = 0;
-    vertexAttributesDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    vertexAttributesDescriptions[1].offset = 16; //odległość Vertex::color od początku struktury czyli rozmiar Vertex::position
+    constexpr uint32_t instanceLocation = 3; // po pozycji, normalnej i kolorze
+    for(uint32_t column = 0; column < 4; column++) // mat4 model zajmuje 4 lokacje, po jednej na kolumnę
+    {
+        VkVertexInputAttributeDescription attributeDescription {};
+        attributeDescription.location = instanceLocation + column;
+        attributeDescription.binding = 1;
+        attributeDescription.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributeDescription.offset = column * sizeof(Vector4);
+        vertexAttributesDescriptions.push_back(attributeDescription);
+    }
 
     VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo{};
     vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputCreateInfo.pNext = NULL;
     vertexInputCreateInfo.flags = 0;
-    vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-    vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputCreateInfo.vertexAttributeDescriptionCount = vertexAttributesDescriptions.size(); //vertex color and position
+    vertexInputCreateInfo.vertexBindingDescriptionCount = bindingDescriptions.size();
+    vertexInputCreateInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+    vertexInputCreateInfo.vertexAttributeDescriptionCount = vertexAttributesDescriptions.size(); //position, normal, color and instance matrix
     vertexInputCreateInfo.pVertexAttributeDescriptions = vertexAttributesDescriptions.data();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo{};
@@ -770,26 +1247,24 @@ void Engine::createPipeline()
     inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport viewport{};
-    viewport.x = 0;
-    viewport.y = mSwapchainHeight;
-    viewport.width = mSwapchainWidth;
-    viewport.height = -static_cast<float>(mSwapchainHeight);
-    viewport.minDepth = 0;
-    viewport.maxDepth = 1;
-
-    VkRect2D scissor{};
-    scissor.extent = {mSwapchainWidth, mSwapchainHeight};
-    scissor.offset = {0, 0};
-
+    // viewport i scissor są dynamiczne (ustawiane w render()), dzięki temu pipeline nie czeka na rozmiar swapchaina
     VkPipelineViewportStateCreateInfo viewportStateCreateInfo{};
     viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportStateCreateInfo.pNext = NULL;
     viewportStateCreateInfo.flags = 0;
     viewportStateCreateInfo.viewportCount = 1;
-    viewportStateCreateInfo.pViewports = &viewport;
+    viewportStateCreateInfo.pViewports = NULL;
     viewportStateCreateInfo.scissorCount = 1;
-    viewportStateCreateInfo.pScissors = &scissor;
+    viewportStateCreateInfo.pScissors = NULL;
+
+    const std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo{};
+    dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateCreateInfo.pNext = NULL;
+    dynamicStateCreateInfo.flags = 0;
+    dynamicStateCreateInfo.dynamicStateCount = dynamicStates.size();
+    dynamicStateCreateInfo.pDynamicStates = dynamicStates.data();
 
     VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo{};
     rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -865,34 +1340,547 @@ void Engine::createPipeline()
     pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
     pipelineCreateInfo.pDepthStencilState = &depthStencilStateCreateInfo;
     pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
-    pipelineCreateInfo.pDynamicState = NULL;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
     pipelineCreateInfo.layout = mPipelineLayout;
     pipelineCreateInfo.renderPass = mRenderPass;
     pipelineCreateInfo.subpass = 0;
     pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineCreateInfo.basePipelineIndex = -1;
 
-    res = vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, NULL, &mPipeline);
-    vkDestroyShaderModule(mDevice, vertexShaderModule, NULL); //niszczę bo niepotrzebne
-    vkDestroyShaderModule(mDevice, fragmentShaderModule, NULL);
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult res = vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineCreateInfo, NULL, &pipeline);
     assertVkSuccess(res, "failed to create pipeline");
+    mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_PIPELINE, pipeline, "main pipeline");
+    return PipelineHandle(mDevice, pipeline);
 }
 
-void Engine::render(uint32_t frameIndex)
+void Engine::reloadShaders()
 {
-    vkWaitForFences(mDevice, 1, &mQueueSubmitFences[frameIndex], VK_TRUE, 0);
-    VkResult res = vkResetFences(mDevice, 1, &mQueueSubmitFences[frameIndex]);
-    assertVkSuccess(res, "failed to reset fence");
-
-    VkCommandBuffer cmdBuff = mCommandBuffers[frameIndex];
-    uint32_t currentSwapchainImageIndex = 0;
-
-    res = vkAcquireNextImageKHR(mDevice, mSwapchain, UINT64_MAX, mAcquireSemaphores[frameIndex], VK_NULL_HANDLE, &currentSwapchainImageIndex); //semafor azasygnalizowany kiedy obrazek będzie dostępny do rysowania
-    assertVkSuccess(res, "failed to get current swapchain image index");
-
-    /*-------- Begin Command Buffer ----------*/
-    res = vkBeginCommandBuffer(cmdBuff, &mCommandBufferBeginInfo); //recording state
-    assertVkSuccess(res, "failed to begin command buffers");
+    loadShaders();
+    PipelineHandle pipeline = createPipeline(mVertexShaderCode, mFragmentShaderCode);
+    retire(std::move(mPipeline)); // ramki w locie mogą jeszcze używać starego pipeline'u
+    mPipeline = std::move(pipeline);
+    invalidateCommandBuffers(); // nagrane bufory mają stary pipeline
+}
+
+void Engine::rebuildPipelines(const std::vector<std::string>& fileNames)
+{
+    TRACE_SCOPE("rebuild pipelines");
+    for(uint32_t index = 0; index < reloadablePipelines.size(); index++)
+    {
+        const ReloadablePipeline& reloadable = reloadablePipelines[index];
+        const bool affected = std::any_of(fileNames.begin(), fileNames.end(), [&reloadable](const std::string& fileName)
+        {
+            return std::any_of(reloadable.shaders.begin(), reloadable.shaders.end(), [&fileName](const char* shader){ return shader != nullptr && fileName == shader; });
+        });
+        const bool exists = index == 0 || mParticles.isEnabled();
+        if(!affected || !exists)
+        {
+            continue;
+        }
+
+        // oba etapy od nowa z dysku, także niezmieniony - mVertexShaderCode i reszta należą do wątku renderu
+        try
+        {
+            const auto start = std::chrono::steady_clock::now();
+            std::array<std::vector<uint32_t>, 2> code;
+            for(size_t stage = 0; stage < code.size() && reloadable.shaders[stage] != nullptr; stage++)
+            {
+                code[stage] = loadShader((std::string("shaders/") + reloadable.shaders[stage]).c_str());
+            }
+            PipelineHandle pipeline;
+            if(index == 0)
+            {
+                pipeline = createPipeline(code[0], code[1]);
+            }
+            else if(index == 1)
+            {
+                pipeline = mParticles.buildSimulationPipeline(code[0]);
+            }
+            else
+            {
+                pipeline = mParticles.buildDrawPipeline(code[0], code[1]);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mReloadMutex);
+                mReloadedPipelines.push_back({index, std::move(pipeline)});
+            }
+            mPipelinesReloaded.store(true, std::memory_order_release);
+            logger::info("shaders: rebuilt ", reloadable.name, " pipeline in ", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), " ms");
+        }
+        catch(const std::exception& e)
+        {
+            logger::warning("shaders: keeping the old ", reloadable.name, " pipeline: ", e.what());
+        }
+    }
+}
+
+void Engine::applyReloadedPipelines()
+{
+    // zwykła ramka płaci za to jeden odczyt atomowy
+    if(!mPipelinesReloaded.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::vector<ReloadedPipeline> reloaded;
+    {
+        std::lock_guard<std::mutex> lock(mReloadMutex);
+        reloaded.swap(mReloadedPipelines);
+        mPipelinesReloaded.store(false, std::memory_order_relaxed);
+    }
+    for(ReloadedPipeline& entry : reloaded)
+    {
+        // ramki w locie mogą jeszcze używać starych pipeline'ów
+        switch(entry.index)
+        {
+        case 0:
+            retire(std::exchange(mPipeline, std::move(entry.pipeline)));
+            break;
+        case 1:
+            retire(mParticles.replaceSimulationPipeline(std::move(entry.pipeline)));
+            break;
+        default:
+            retire(mParticles.replaceDrawPipeline(std::move(entry.pipeline)));
+            break;
+        }
+    }
+    invalidateCommandBuffers(); // nagrane bufory mają stare pipeline'y
+}
+
+void Engine::createPipelineCache()
+{
+    // dane z poprzedniego uruchomienia, jeśli są z tego samego urządzenia i sterownika - nagłówek wg specyfikacji
+    std::vector<char> data;
+    std::ifstream file(pipelineCachePath, std::ios::ate | std::ios::binary);
+    if(file)
+    {
+        data.resize(file.tellg());
+        file.seekg(0);
+        file.read(data.data(), data.size());
+    }
+    struct CacheHeader
+    {
+        uint32_t size;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint8_t uuid[VK_UUID_SIZE];
+    };
+    CacheHeader header {};
+    if(data.size() >= sizeof(header))
+    {
+        std::memcpy(&header, data.data(), sizeof(header));
+    }
+    if(header.vendorID != mPhysicalDeviceProperties.vendorID || header.deviceID != mPhysicalDeviceProperties.deviceID ||
+       std::memcmp(header.uuid, mPhysicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        if(!data.empty())
+        {
+            logger::info("pipeline cache: ", pipelineCachePath, " is from another device or driver, starting empty");
+        }
+        data.clear();
+    }
+
+    VkPipelineCacheCreateInfo pipelineCacheCreateInfo {};
+    pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheCreateInfo.pNext = NULL;
+    pipelineCacheCreateInfo.flags = 0;
+    pipelineCacheCreateInfo.initialDataSize = data.size();
+    pipelineCacheCreateInfo.pInitialData = data.empty() ? NULL : data.data();
+
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    VkResult res = vkCreatePipelineCache(mDevice, &pipelineCacheCreateInfo, NULL, &pipelineCache);
+    assertVkSuccess(res, "failed to create pipeline cache");
+    mPipelineCache = PipelineCacheHandle(mDevice, pipelineCache);
+    logger::debug("pipeline cache: ", data.size(), " bytes from ", pipelineCachePath);
+}
+
+void Engine::savePipelineCache() const
+{
+    if(mPipelineCache == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    size_t size = 0;
+    if(vkGetPipelineCacheData(mDevice, mPipelineCache, &size, NULL) != VK_SUCCESS || size == 0)
+    {
+        return;
+    }
+    std::vector<char> data(size);
+    if(vkGetPipelineCacheData(mDevice, mPipelineCache, &size, data.data()) != VK_SUCCESS)
+    {
+        return;
+    }
+    std::ofstream file(pipelineCachePath, std::ios::binary);
+    file.write(data.data(), size);
+    if(!file)
+    {
+        logger::warning("failed to write ", pipelineCachePath);
+    }
+}
+
+std::vector<VkCommandBuffer> Engine::allocateCommandBuffers(VkCommandBufferLevel level, uint32_t count, const std::string& name)
+{
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.pNext = NULL;
+    commandBufferAllocateInfo.commandPool = mCommandPool;
+    commandBufferAllocateInfo.level = level;
+    commandBufferAllocateInfo.commandBufferCount = count;
+
+    std::vector<VkCommandBuffer> commandBuffers(count);
+    VkResult res = vkAllocateCommandBuffers(mDevice, &commandBufferAllocateInfo, commandBuffers.data());
+    assertVkSuccess(res, "failed to allocate command buffers");
+    for(uint32_t i = 0; i < count; i++)
+    {
+        mDebugUtils.setObjectName(mDevice, VK_OBJECT_TYPE_COMMAND_BUFFER, commandBuffers[i], name + std::to_string(i));
+    }
+    return commandBuffers;
+}
+
+void Engine::invalidateCommandBuffers()
+{
+    mDrawStateVersion++;
+    mStaticFrames = 0;
+}
+
+void Engine::updateDrawState()
+{
+    // wszystko, co trafia do nagranych buforów: rekordy instancji, ich liczba (bufory rosną razem z nią) i kamera
+    const Camera& camera = mScene.camera();
+    bool cameraChanged = camera.fovY != mRecordedCamera.fovY || camera.nearPlane != mRecordedCamera.nearPlane || camera.farPlane != mRecordedCamera.farPlane;
+    for(int i = 0; i < 3; i++)
+    {
+        cameraChanged |= camera.position[i] != mRecordedCamera.position[i] || camera.target[i] != mRecordedCamera.target[i];
+    }
+
+    // dopóki tekstury dochodzą, każda ramka ma w buforze inne kopie; cząsteczki mają inny krok czasu w każdej ramce
+    const bool resolutionChanged = mDynamicResolution.scale() != mRecordedResolutionScale;
+    if(cameraChanged || !mScene.changedInstances().empty() || mScene.instanceCount() != mRecordedInstanceCount || mTextureStreamer.isBusy() ||
+       mParticles.isEnabled() || resolutionChanged)
+    {
+        mRecordedCamera = camera;
+        mRecordedInstanceCount = mScene.instanceCount();
+        mRecordedResolutionScale = mDynamicResolution.scale();
+        invalidateCommandBuffers();
+    }
+}
+
+Engine::CachedFrame& Engine::cachedFrameFor(uint32_t frameIndex)
+{
+    std::vector<CachedFrame>& cachedFrames = mCachedFrames[frameIndex];
+    for(CachedFrame& cachedFrame : cachedFrames)
+    {
+        bool sameImages = true;
+        for(uint32_t i = 0; i < mOutputs.size(); i++)
+        {
+            sameImages &= cachedFrame.imageIndices[i] == mOutputs[i]->imageIndex;
+        }
+        if(sameImages)
+        {
+            return cachedFrame;
+        }
+    }
+
+    // każda kombinacja obrazów swapchainów to osobny primary (inny framebuffer) - przy kilku wyjściach
+    // kombinacji robi się dużo, więc powyżej limitu nadpisujemy najstarszy
+    CachedFrame* cachedFrame = nullptr;
+    if(cachedFrames.size() < maxCachedFramesPerSlot)
+    {
+        cachedFrames.emplace_back();
+        cachedFrame = &cachedFrames.back();
+        cachedFrame->commandBuffer = allocateCommandBuffers(VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, "cached frame " + std::to_string(frameIndex) + "/" + std::to_string(cachedFrames.size() - 1) + " ")[0];
+    }
+    else
+    {
+        std::rotate(cachedFrames.begin(), cachedFrames.begin() + 1, cachedFrames.end());
+        cachedFrame = &cachedFrames.back();
+    }
+    cachedFrame->imageIndices.clear();
+    for(const auto& output : mOutputs)
+    {
+        cachedFrame->imageIndices.push_back(output->imageIndex);
+    }
+    cachedFrame->version = 0;
+    return *cachedFrame;
+}
+
+void Engine::render(uint32_t frameIndex)
+{
+    TRACE_SCOPE("render");
+    VkResult res;
+    {
+        TRACE_SCOPE("wait for fence");
+        res = vkWaitForFences(mDevice, 1, mQueueSubmitFences[frameIndex].ptr(), VK_TRUE, UINT64_MAX); // command buffer tej ramki nie może być już w użyciu
+        assertVkSuccess(res, "failed to wait for fence");
+    }
+    // przed resetem fence'a - pominięta ramka zostawia slot gotowy dla następnej
+    if(!acquireImages(frameIndex))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10)); // wszystkie okna zminimalizowane - bez tego pętla run() kręciłaby się na pusto
+        return;
+    }
+    const bool allAcquired = std::all_of(mOutputs.begin(), mOutputs.end(), [](const std::unique_ptr<Output>& output){ return output->acquired; });
+    res = vkResetFences(mDevice, 1, mQueueSubmitFences[frameIndex].ptr());
+    assertVkSuccess(res, "failed to reset fence");
+
+    mFrameSlot = frameIndex;
+    mDeletionQueue.collect(frameIndex); // ramka, która ostatnio używała tego slotu, właśnie się skończyła
+    applyReloadedPipelines();           // przebudowane w tle - podmiana tylko tutaj, między ramkami
+    mFrameArena.reset(frameIndex);
+    mReadback.collect(frameIndex);      // jej kopia obrazu też jest już gotowa
+    mGpuTrace.collect(frameIndex);      // i jej znaczniki czasu
+    mTextureStreamer.collect(frameIndex); // i jej staging tekstur
+    mParticles.collect(frameIndex);       // i czas symulacji cząsteczek
+    mDynamicResolution.collect(frameIndex); // i czas GPU całej ramki - skala na tę ramkę
+    mAllocator.beginFrame();            // po zwolnieniach z kolejki - budżet i ewentualne wyrzucanie
+
+    VkCommandBuffer cmdBuff = mCommandBuffers[frameIndex];
+
+    // tylko brudne poddrzewa i tylko zmienione rekordy instancji - statyczna część sceny nic nie kosztuje
+    {
+        TRACE_SCOPE("update scene");
+        applySimulation();
+        if(mRecorder)
+        {
+            mRecorder->frame(mScene.camera()); // operacje nagrane do tej pory trafiają przed tę ramkę
+        }
+        mScene.updateTransforms();
+        // na razie tekstury nie są jeszcze rysowane - każda na całą wysokość największego wyjścia
+        uint32_t screenSize = 0;
+        for(auto& output : mOutputs)
+        {
+            screenSize = std::max(screenSize, output->height);
+            output->renderExtent = mDynamicResolution.renderExtent(output->width, output->height);
+        }
+        for(TextureId texture : mTextures)
+        {
+            mTextureStreamer.request(texture, float(screenSize));
+        }
+        updateDrawState();
+    }
+
+    // Ramka, w której nic się nie zmieniło, nie ma uploadu ani cullingu, więc jej primary zależy tylko od slotu
+    // i pobranych obrazów - taki sam był już nagrany i idzie do kolejki bez nagrywania.
+    CachedFrame* cachedFrame = nullptr;
+    if(mSettings.cacheCommandBuffers && mStaticFrames >= staticFramesBeforeReuse && !mReadback.isEnabled() && allAcquired)
+    {
+        cachedFrame = &cachedFrameFor(frameIndex);
+        cmdBuff = cachedFrame->commandBuffer;
+    }
+
+    if(cachedFrame == nullptr || cachedFrame->version != mDrawStateVersion)
+    {
+        TRACE_SCOPE("record");
+        VkCommandBufferBeginInfo beginInfo = mCommandBufferBeginInfo;
+        if(cachedFrame != nullptr)
+        {
+            beginInfo.flags = 0; // będzie wysyłany wiele razy
+            cachedFrame->version = mDrawStateVersion;
+        }
+
+        /*-------- Begin Command Buffer ----------*/
+        res = vkBeginCommandBuffer(cmdBuff, &beginInfo); //recording state
+        assertVkSuccess(res, "failed to begin command buffers");
+        mDynamicResolution.beginFrame(cmdBuff, frameIndex);
+        mDrawQueue.resetStats();
+        mGpuTrace.beginFrame(cmdBuff, frameIndex);
+        const uint32_t frameScope = mGpuTrace.begin(cmdBuff, "frame");
+
+        mInstanceBuffer.upload(cmdBuff, frameIndex, mScene, mDeletionQueue);
+        mTextureStreamer.record(cmdBuff);
+
+        if(mParticles.isEnabled())
+        {
+            const auto now = std::chrono::steady_clock::now();
+            const float deltaTime = std::chrono::duration<float>(now - mLastRenderTime).count();
+            mLastRenderTime = now;
+            const uint32_t particleScope = mGpuTrace.begin(cmdBuff, "particles");
+            mParticles.record(cmdBuff, frameIndex, deltaTime);
+            mGpuTrace.end(cmdBuff, particleScope);
+        }
+
+        // wszystkie wyjścia w jednym command bufferze - instancje są wysłane raz, a wyjścia różnią się tylko celem i proporcjami
+        for(uint32_t outputIndex = 0; outputIndex < mOutputs.size(); outputIndex++)
+        {
+            if(!mOutputs[outputIndex]->acquired)
+            {
+                continue;
+            }
+            const uint32_t outputScope = mGpuTrace.begin(cmdBuff, mOutputs[outputIndex]->name.c_str());
+            recordOutput(cmdBuff, frameIndex, *mOutputs[outputIndex]);
+            mGpuTrace.end(cmdBuff, outputScope);
+            if(outputIndex == 0)
+            {
+                mReadback.record(cmdBuff, frameIndex, mOutputs[0]->swapchainImages[mOutputs[0]->imageIndex], mFrameNumber);
+            }
+        }
+
+        mGpuTrace.end(cmdBuff, frameScope);
+        mDynamicResolution.endFrame(cmdBuff);
+        res = vkEndCommandBuffer(cmdBuff);
+        assertVkSuccess(res, "failed to end command buffers");
+        mDrawStats = mDrawQueue.stats();
+        /*--------- End Command Buffer ----------*/
+    }
+    mScene.clearChanges();
+    mFrameNumber++;
+    mStaticFrames++;
+
+    // to jest po to, że jak semafor nie jest zasygnalizowany to nie pisze do obrazka, bo ten jeszcze
+    // nie jest na to gotowy, optymalizacja, żeby karta mogła wykonwyać dziąłania na przód
+    // tylko wyjścia z pobranym obrazem; presentOutputs[i] - indeks w mOutputs i-tego z nich
+    const uint32_t maxOutputCount = mOutputs.size();
+    VkSemaphore* waitSemaphores = mFrameArena.allocate<VkSemaphore>(maxOutputCount);
+    VkPipelineStageFlags* waitStages = mFrameArena.allocate<VkPipelineStageFlags>(maxOutputCount);
+    VkSwapchainKHR* swapchains = mFrameArena.allocate<VkSwapchainKHR>(maxOutputCount);
+    uint32_t* imageIndices = mFrameArena.allocate<uint32_t>(maxOutputCount);
+    VkResult* presentResults = mFrameArena.allocate<VkResult>(maxOutputCount);
+    uint32_t* presentOutputs = mFrameArena.allocate<uint32_t>(maxOutputCount);
+    uint32_t outputCount = 0;
+    for(uint32_t i = 0; i < maxOutputCount; i++)
+    {
+        if(!mOutputs[i]->acquired)
+        {
+            continue;
+        }
+        waitSemaphores[outputCount] = mOutputs[i]->acquireSemaphores[frameIndex];
+        waitStages[outputCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        swapchains[outputCount] = mOutputs[i]->swapchain;
+        imageIndices[outputCount] = mOutputs[i]->imageIndex;
+        presentOutputs[outputCount] = i;
+        outputCount++;
+    }
+
+    VkSubmitInfo submitInfo {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = NULL;
+    submitInfo.waitSemaphoreCount = outputCount;
+    submitInfo.pWaitSemaphores = waitSemaphores; //przekazuje semafory na ktore ma zaczekac karta, po jednym na wyjście
+    submitInfo.pWaitDstStageMask = waitStages; // podajemy faze wykonania pipelinu na ktorym karta ma zaczekac na semafor
+    submitInfo.commandBufferCount = 1; // jeden bo jednocześnie chcę wysłać 1 cmdbuff
+    submitInfo.pCommandBuffers = &cmdBuff;
+    submitInfo.signalSemaphoreCount = 1; // liczba semaforów, która będzie sygnalizowała że command buffer się wykonał
+    submitInfo.pSignalSemaphores = mQueueSubmitSemaphores[frameIndex].ptr(); // wskaźnik na ten semafor
+
+    {
+        TRACE_SCOPE("submit");
+        res = vkQueueSubmit(mQueue, 1, &submitInfo, mQueueSubmitFences[frameIndex]); //fence zasygnalizowany gdy koemndy na karcie zostaną wykonane
+        assertVkSuccess(res, "failed to queue submit");
+    }
+
+    // jeden present dla wszystkich swapchainów - jedno przejście przez sterownik i jeden semafor do odczekania
+    VkPresentInfoKHR presentInfo {};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.pNext = NULL;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = mQueueSubmitSemaphores[frameIndex].ptr();
+    presentInfo.swapchainCount = outputCount;
+    presentInfo.pSwapchains = swapchains;
+    presentInfo.pImageIndices = imageIndices;
+    presentInfo.pResults = presentResults;
+
+    {
+        TRACE_SCOPE("present");
+        res = vkQueuePresentKHR(mQueue, &presentInfo);
+    }
+    // SUBOPTIMAL - obraz i tak został pokazany; oba przypadki odtwarzają swapchain przed następnym acquire
+    for(uint32_t i = 0; i < outputCount; i++)
+    {
+        if(presentResults[i] == VK_SUBOPTIMAL_KHR || presentResults[i] == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            mOutputs[presentOutputs[i]]->resized = true;
+            continue;
+        }
+        assertVkSuccess(presentResults[i], "failed to queue presentation");
+    }
+    if(res != VK_SUBOPTIMAL_KHR && res != VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        assertVkSuccess(res, "failed to queue presentation");
+    }
+}
+
+bool Engine::acquireImages(uint32_t frameIndex)
+{
+    TRACE_SCOPE("acquire");
+    // Zminimalizowane wyjście (zerowy rozmiar) nie dostaje obrazu i jest w tej ramce pomijane - reszta renderuje dalej,
+    // a render() nigdy nie czeka na okno, więc processEvents() dalej obsługuje Escape i Close.
+    bool anyAcquired = false;
+    for(auto& output : mOutputs)
+    {
+        output->acquired = false;
+        if(output->resized && !recreateSwapchain(*output))
+        {
+            continue;
+        }
+
+        while(true)
+        {
+            VkResult res = vkAcquireNextImageKHR(mDevice, output->swapchain, UINT64_MAX, output->acquireSemaphores[frameIndex], VK_NULL_HANDLE, &output->imageIndex); //semafor azasygnalizowany kiedy obrazek będzie dostępny do rysowania
+            if(res == VK_SUBOPTIMAL_KHR)
+            {
+                output->resized = true; // obraz jest ważny, swapchain odtworzony w następnej ramce
+                output->acquired = true;
+                break;
+            }
+            if(res != VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                assertVkSuccess(res, "failed to get current swapchain image index");
+                output->acquired = true;
+                break;
+            }
+
+            // semafor nie został zasygnalizowany, więc można od razu spróbować z nowym swapchainem
+            if(!recreateSwapchain(*output))
+            {
+                output->resized = true; // spróbujemy w następnej ramce
+                break;
+            }
+        }
+        anyAcquired |= output->acquired;
+    }
+    return anyAcquired;
+}
+
+void Engine::recordOutput(VkCommandBuffer cmdBuff, uint32_t frameIndex, Output& output)
+{
+    const uint32_t instanceCount = mScene.instanceCount();
+    const Matrix4 viewProjection = mScene.camera().viewProjection(float(output.width) / float(output.height));
+
+    // W trybie cache culling w nieruchomej scenie daje co ramkę to samo, a jego wynik zostaje w buforach
+    // na GPU; zawartość renderpassu jest nagrywana od nowa tylko dla slotu, który widział starszy stan.
+    const bool cached = mSettings.cacheCommandBuffers;
+    const bool cull = mSettings.occlusionCulling && (!cached || mStaticFrames < staticFramesBeforeReuse);
+    if(cached && output.drawCommandBuffers.empty())
+    {
+        output.drawCommandBuffers = allocateCommandBuffers(VK_COMMAND_BUFFER_LEVEL_SECONDARY, mFramesInFlight, output.name + " draw command buffer ");
+        output.drawVersions.assign(mFramesInFlight, 0);
+    }
+    const bool drawsDirty = !cached || output.drawVersions[frameIndex] != mDrawStateVersion;
+
+    if(cull || drawsDirty)
+    {
+        mLodSelector.update(mScene, float(output.renderExtent.height)); // LOD zależy od wysokości renderowanego obrazu w pikselach
+    }
+
+    // przed renderpassem: piramida z głębi poprzedniej ramki i kompaktowanie widocznych instancji
+    if(cull)
+    {
+        CullInput cullInput;
+        cullInput.instances = mInstanceBuffer.buffer();
+        cullInput.instanceCount = instanceCount;
+        cullInput.lods = mLodSelector.lods().data();
+        cullInput.lodInstanceCounts = mLodSelector.lodInstanceCounts();
+        cullInput.meshLods = &mMeshLods;
+        cullInput.boundingSphere = mLodSelector.bounds();
+        cullInput.viewProjection = viewProjection;
+        // z dynamiczną rozdzielczością głębia zajmuje tylko róg obrazu, a piramida zakłada cały - zostaje sam frustum culling
+        const bool hasPreviousDepth = output.previousImageIndex < output.swapchainImageCount && !mDynamicResolution.isEnabled();
+        cullInput.previousDepth = hasPreviousDepth ? output.depthImageViews[output.previousImageIndex].get() : VK_NULL_HANDLE;
+        output.occlusionCuller.record(cmdBuff, frameIndex, cullInput, mDeletionQueue);
+    }
 
     VkClearColorValue clearColorValue;
     clearColorValue.float32[0] = 0.0f;
@@ -904,7 +1892,7 @@ void Engine::render(uint32_t frameIndex)
     clearDepthValue.depth = 1.0f;
     //clearDepthValue.stencil; ignored - no stencil
 
-    std::vector<VkClearValue> clearValues(2);
+    std::array<VkClearValue, 2> clearValues;
     clearValues[0].color = clearColorValue;
     clearValues[1].depthStencil = clearDepthValue;
 
@@ -912,51 +1900,202 @@ void Engine::render(uint32_t frameIndex)
     renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassBeginInfo.pNext = NULL;
     renderPassBeginInfo.renderPass = mRenderPass;
-    renderPassBeginInfo.framebuffer = mFramebuffers[currentSwapchainImageIndex];
+    renderPassBeginInfo.framebuffer = output.framebuffers[output.imageIndex];
     renderPassBeginInfo.renderArea.offset = {0,0};
-    renderPassBeginInfo.renderArea.extent = {mWindowWidth, mWindowHeight};
+    renderPassBeginInfo.renderArea.extent = output.renderExtent;
     renderPassBeginInfo.clearValueCount = clearValues.size();
     renderPassBeginInfo.pClearValues = clearValues.data();
 
     /*----------- Begin RenderPass ----------*/
-    vkCmdBeginRenderPass(cmdBuff, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    if(!cached)
+    {
+        vkCmdBeginRenderPass(cmdBuff, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        recordDraws(cmdBuff, output, viewProjection);
+    }
+    else
+    {
+        VkCommandBuffer drawCmdBuff = output.drawCommandBuffers[frameIndex];
+        if(drawsDirty)
+        {
+            // framebuffer pominięty - ten sam bufor pasuje do każdego obrazu swapchaina
+            VkCommandBufferInheritanceInfo inheritanceInfo {};
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.pNext = NULL;
+            inheritanceInfo.renderPass = mRenderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+            VkCommandBufferBeginInfo beginInfo {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.pNext = NULL;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+            VkResult res = vkBeginCommandBuffer(drawCmdBuff, &beginInfo);
+            assertVkSuccess(res, "failed to begin draw command buffer");
+            recordDraws(drawCmdBuff, output, viewProjection);
+            res = vkEndCommandBuffer(drawCmdBuff);
+            assertVkSuccess(res, "failed to end draw command buffer");
+            output.drawVersions[frameIndex] = mDrawStateVersion;
+        }
+        vkCmdBeginRenderPass(cmdBuff, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        vkCmdExecuteCommands(cmdBuff, 1, &drawCmdBuff);
+    }
 
     /*------------ End RenderPass -----------*/
     vkCmdEndRenderPass(cmdBuff);
 
-    res = vkEndCommandBuffer(cmdBuff);
-    assertVkSuccess(res, "failed to end command buffers");
-    /*--------- End Command Buffer ----------*/
+    if(mDynamicResolution.isEnabled())
+    {
+        recordUpscale(cmdBuff, output);
+    }
 
-    VkPipelineStageFlags pipelineStageFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;  // to jest po to, że jak semafor nie jest zasygnalizowany to nie pisze do obrazka, bo ten jeszcze
-    // nie jest na to gotowy, optymalizacja, żeby karta mogła wykonwyać dziąłania na przód
+    output.previousImageIndex = output.imageIndex;
+}
 
-    VkSubmitInfo submitInfo {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.pNext = NULL;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &mAcquireSemaphores[frameIndex]; //przekazuje semafor na ktory ma zaczekac karta
-    submitInfo.pWaitDstStageMask = &pipelineStageFlags; // podajemy faze wykonania pipelinu na ktorym karta ma zaczekac na semafor
-    submitInfo.commandBufferCount = 1; // jeden bo jednocześnie chcę wysłać 1 cmdbuff
-    submitInfo.pCommandBuffers = &cmdBuff;
-    submitInfo.signalSemaphoreCount = 1; // liczba semaforów, która będzie sygnalizowała że command buffer się wykonał
-    submitInfo.pSignalSemaphores = &mQueueSubmitSemaphores[frameIndex]; // wskaźnik na ten semafor
+void Engine::recordUpscale(VkCommandBuffer cmdBuff, const Output& output)
+{
+    // obraz poza ekranem jest już w TRANSFER_SRC (finalLayout), brakuje tylko zależności od zapisu koloru
+    std::array<VkImageMemoryBarrier, 2> toTransfer {};
+    toTransfer[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer[0].pNext = NULL;
+    toTransfer[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    toTransfer[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer[0].image = output.colorImages[output.imageIndex];
+    toTransfer[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    // obraz swapchaina jest nadpisywany w całości - poprzednia zawartość nieistotna; semafor acquire czeka na COLOR_ATTACHMENT_OUTPUT
+    toTransfer[1] = toTransfer[0];
+    toTransfer[1].srcAccessMask = 0;
+    toTransfer[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer[1].image = output.swapchainImages[output.imageIndex];
+
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL,
+                         toTransfer.size(), toTransfer.data());
+
+    VkImageBlit blit {};
+    blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    blit.srcOffsets[0] = {0, 0, 0};
+    blit.srcOffsets[1] = {int32_t(output.renderExtent.width), int32_t(output.renderExtent.height), 1};
+    blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    blit.dstOffsets[0] = {0, 0, 0};
+    blit.dstOffsets[1] = {int32_t(output.width), int32_t(output.height), 1};
+    vkCmdBlitImage(cmdBuff, output.colorImages[output.imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   output.swapchainImages[output.imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, mUpscaleFilter);
+
+    VkImageMemoryBarrier toPresent = toTransfer[1];
+    toPresent.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toPresent.dstAccessMask = 0; // prezentacja jest zsynchronizowana semaforem
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &toPresent);
+}
 
-    res = vkQueueSubmit(mQueue, 1, &submitInfo, mQueueSubmitFences[frameIndex]); //fence zasygnalizowany gdy koemndy na karcie zostaną wykonane
-    assertVkSuccess(res, "failed to queue submit");
+void Engine::recordDraws(VkCommandBuffer cmdBuff, const Output& output, const Matrix4& viewProjection)
+{
+    VkViewport viewport{};
+    viewport.x = 0;
+    viewport.y = output.renderExtent.height;
+    viewport.width = output.renderExtent.width;
+    viewport.height = -static_cast<float>(output.renderExtent.height);
+    viewport.minDepth = 0;
+    viewport.maxDepth = 1;
+    vkCmdSetViewport(cmdBuff, 0, 1, &viewport);
 
-    VkPresentInfoKHR presentInfo {};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.pNext = NULL;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &mQueueSubmitSemaphores[frameIndex];
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = &mSwapchain;
-    presentInfo.pImageIndices = &currentSwapchainImageIndex;
-    presentInfo.pResults = NULL;
+    VkRect2D scissor{};
+    scissor.extent = output.renderExtent;
+    scissor.offset = {0, 0};
+    vkCmdSetScissor(cmdBuff, 0, 1, &scissor);
 
-    res = vkQueuePresentKHR(mQueue, &presentInfo);
-    assertVkSuccess(res, "failed to queue presentation");
+    // wszystko przez kolejkę - kolejność i bindy ustala klucz, nie kolejność dodawania
+    mDrawQueue.reset();
+    if(mScene.instanceCount() > 0)
+    {
+        DrawConstants constants;
+        constants.viewProjection = viewProjection;
+        constants.positionScale = mMeshQuantization.scale;
+        constants.positionOffset = mMeshQuantization.offset;
+
+        DrawPipeline pipeline;
+        pipeline.pipeline = mPipeline;
+        pipeline.layout = mPipelineLayout;
+        pipeline.pushConstantStages = VK_SHADER_STAGE_VERTEX_BIT;
+        pipeline.pushConstantSize = sizeof(constants);
+        static_assert(sizeof(constants) <= sizeof(pipeline.pushConstants), "draw constants do not fit");
+        std::memcpy(pipeline.pushConstants.data(), &constants, sizeof(constants));
+        const uint32_t pipelineIndex = mDrawQueue.addPipeline(pipeline);
+
+        DrawMesh mesh;
+        mesh.vertexBuffers = {mMeshVertices.buffer, mInstanceBuffer.buffer()};
+        mesh.vertexBufferCount = 2;
+        mesh.indexBuffer = mMeshIndices.buffer;
+        mesh.indexType = mMeshIndexType;
+        const uint32_t meshIndex = mDrawQueue.addMesh(mesh);
+
+        const uint64_t key = DrawQueue::makeKey(DrawPass::Opaque, pipelineIndex, 0, meshIndex);
+        if(mSettings.occlusionCulling)
+        {
+            mDrawQueue.push(key, drawVisibleInstances, &output.occlusionCuller);
+        }
+        else
+        {
+            // zakres instancji na LOD - sąsiednie batche tego samego LOD-u queue łączy w jeden draw
+            for(const LodBatch& batch : mLodSelector.batches())
+            {
+                const MeshLod& lod = mMeshLods[batch.lod];
+                mDrawQueue.push(key, lod.indexCount, lod.firstIndex, 0, batch.firstInstance, batch.instanceCount);
+            }
+        }
+    }
+
+    // przebieg przezroczysty - po siatkach, test z ich głębią
+    const ParticleDraw particleDraw {&mParticles, viewProjection, &mScene.camera()};
+    if(mParticles.isEnabled())
+    {
+        mDrawQueue.push(DrawQueue::makeKey(DrawPass::Transparent, DrawQueue::none, 0, DrawQueue::none), drawParticles, &particleDraw);
+    }
+    mDrawQueue.submit(cmdBuff);
+}
+
+void Engine::processEvents()
+{
+    TRACE_SCOPE("process events");
+    // raz na ramkę, bez czekania - pusta kolejka kosztuje jeden odczyt atomowy
+    Event event;
+    for(auto& output : mOutputs)
+    {
+        while(output->window->events().pop(event))
+        {
+            switch(event.type)
+            {
+            case EventType::Close: // zamknięcie któregokolwiek okna kończy - wyjść nie da się na razie odpinać w locie
+                stop();
+                break;
+            case EventType::KeyDown:
+                if(event.key == Key::Escape)
+                {
+                    stop();
+                }
+                break;
+            case EventType::Resize:
+                // swapchain odtwarzany dopiero przed acquire - kilka zdarzeń z jednego przeciągania to jedno odtworzenie
+                logger::debug(output->name, " window resized to ", event.x, "x", event.y);
+                if(uint32_t(event.x) != output->width || uint32_t(event.y) != output->height)
+                {
+                    output->resized = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
 }
 
 void Engine::run()
@@ -965,7 +2104,8 @@ void Engine::run()
 
     while(true)
     {
-        mWindow.handleEvents();
+        TRACE_SCOPE("frame");
+        processEvents();
         if(mRun == false)
         {
             break;
@@ -973,6 +2113,208 @@ void Engine::run()
         render((imageIndex % mFramesInFlight));
         imageIndex++;
     }
+
+    if(mSimulation.isRunning())
+    {
+        mSimulation.stop();
+        logger::info("simulation: ", mSimulation.tickCount(), " ticks, ", mSimulation.droppedTicks(), " dropped");
+    }
+}
+
+std::vector<double> Engine::benchmarkRender(uint32_t frameCount)
+{
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    std::vector<double> renderTimes;
+    renderTimes.reserve(frameCount);
+
+    for(uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        processEvents();
+        if(mRun == false)
+        {
+            break;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        render(frame % mFramesInFlight);
+        renderTimes.push_back(Microseconds(std::chrono::steady_clock::now() - start).count());
+    }
+
+    vkDeviceWaitIdle(mDevice);
+    return renderTimes;
+}
+
+void Engine::startSimulation(std::vector<Entity> entities, SimulationTick tick, float tickRate)
+{
+    SimulationState initialState;
+    initialState.transforms.reserve(entities.size());
+    for(Entity entity : entities)
+    {
+        initialState.transforms.push_back(mScene.localTransform(entity));
+    }
+    initialState.camera = mScene.camera();
+
+    mSimulatedEntities = std::move(entities);
+    mAppliedTick = UINT64_MAX;
+    mSimulation.start(std::move(initialState), std::move(tick), tickRate);
+    logger::info("simulation: ", mSimulatedEntities.size(), " entities at ", tickRate, " ticks/s");
+}
+
+void Engine::applySimulation()
+{
+    const SimulationSnapshot* snapshot = mSimulation.isRunning() ? mSimulation.latest() : nullptr;
+    if(snapshot == nullptr)
+    {
+        return;
+    }
+
+    // render jest tick za symulacją: alpha 0 - previous, 1 - current
+    const float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - snapshot->time).count();
+    const float alpha = std::clamp(elapsed / mSimulation.tickInterval(), 0.0f, 1.0f);
+    if(snapshot->tick == mAppliedTick && alpha == mAppliedAlpha)
+    {
+        return; // nowego ticku nie ma, a interpolacja doszła do końca - scena stoi i nagrane bufory zostają ważne
+    }
+    mAppliedTick = snapshot->tick;
+    mAppliedAlpha = alpha;
+
+    const SimulationState& previous = snapshot->previous;
+    const SimulationState& current = snapshot->current;
+    for(size_t i = 0; i < mSimulatedEntities.size(); i++)
+    {
+        LocalTransform transform;
+        transform.position = lerp(previous.transforms[i].position, current.transforms[i].position, alpha);
+        transform.rotation = nlerp(previous.transforms[i].rotation, current.transforms[i].rotation, alpha);
+        transform.scale = lerp(previous.transforms[i].scale, current.transforms[i].scale, alpha);
+        mScene.setLocalTransform(mSimulatedEntities[i], transform);
+    }
+
+    Camera& camera = mScene.camera();
+    camera = current.camera;
+    camera.position = lerp(previous.camera.position, current.camera.position, alpha);
+    camera.target = lerp(previous.camera.target, current.camera.target, alpha);
+}
+
+void Engine::startRecording(const std::string& path)
+{
+    mRecorder = std::make_unique<CommandRecorder>(path, mSettings);
+    mScene.setRecorder(mRecorder.get());
+}
+
+std::vector<double> Engine::replay(CommandLog& log, bool realtime)
+{
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    std::vector<double> renderTimes;
+    renderTimes.reserve(log.frameCount());
+
+    const auto replayStart = std::chrono::steady_clock::now();
+    for(size_t frame = 0; frame < log.frameCount(); frame++)
+    {
+        processEvents();
+        if(mRun == false)
+        {
+            break;
+        }
+
+        log.apply(frame, mScene); // poza pomiarem - w nagraniu te operacje robiła aplikacja między ramkami
+        if(realtime)
+        {
+            std::this_thread::sleep_until(replayStart + std::chrono::nanoseconds(log.frameTime(frame)));
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        render(frame % mFramesInFlight);
+        renderTimes.push_back(Microseconds(std::chrono::steady_clock::now() - start).count());
+    }
+
+    vkDeviceWaitIdle(mDevice);
+    return renderTimes;
+}
+
+std::vector<double> Engine::benchmarkParticles(uint32_t frameCount)
+{
+    std::vector<double> simulationTimes;
+    simulationTimes.reserve(frameCount);
+
+    for(uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        processEvents();
+        if(mRun == false)
+        {
+            break;
+        }
+        render(frame % mFramesInFlight);
+        if(mParticles.simulationMilliseconds() > 0) // wynik ramki sprzed mFramesInFlight, odebrany w render()
+        {
+            simulationTimes.push_back(mParticles.simulationMilliseconds());
+        }
+    }
+
+    vkDeviceWaitIdle(mDevice);
+    return simulationTimes;
+}
+
+std::vector<uint64_t> Engine::countFrameAllocations(uint32_t frameCount, const std::function<void(uint32_t)>& update)
+{
+    std::vector<uint64_t> allocations;
+    allocations.reserve(frameCount);
+
+    for(uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        processEvents();
+        if(mRun == false)
+        {
+            break;
+        }
+
+        update(frame);
+        const uint64_t before = heapAllocationCount();
+        render(frame % mFramesInFlight);
+        allocations.push_back(heapAllocationCount() - before);
+    }
+
+    vkDeviceWaitIdle(mDevice);
+    return allocations;
+}
+
+void Engine::setReadbackCallback(ReadbackCallback callback, uint32_t interval)
+{
+    const Output& output = *mOutputs[0]; // kopiowane jest tylko główne wyjście
+    if(!output.readable)
+    {
+        logger::warning("swapchain images do not support TRANSFER_SRC, readback disabled");
+        return;
+    }
+
+    if(!mReadback.isEnabled() && callback != nullptr)
+    {
+        // bufory dopiero przy pierwszym użyciu - bez readbacku silnik nie zajmuje na nie pamięci
+        if(!mReadback.create(mAllocator, mFramesInFlight, output.width, output.height, mSwapchainImageFormat))
+        {
+            logger::warning("swapchain format ", mSwapchainImageFormat, " is not supported by readback, readback disabled");
+            return;
+        }
+    }
+    mReadback.setCallback(std::move(callback), interval);
+}
+
+MemoryStats Engine::memoryStats() const
+{
+    return mAllocator.stats();
+}
+
+void Engine::logMemoryStats() const
+{
+    const MemoryStats stats = mAllocator.stats();
+    for(uint32_t heapIndex = 0; heapIndex < stats.heaps.size(); heapIndex++)
+    {
+        const MemoryHeapStats& heap = stats.heaps[heapIndex];
+        logger::info("memory heap ", heapIndex, (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "",
+                     ": ", heap.allocationCount, " allocations, ", heap.allocatedBytes >> 20, " MiB allocated, usage ",
+                     heap.usage >> 20, " / budget ", heap.budget >> 20, " MiB", stats.driverBudget ? "" : " (estimated)");
+    }
 }
 
 void Engine::stop()
@@ -1,7 +1,32 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 #include "window.h"
+#include "debug.h"
+#include "commandlog.h"
+#include "deletionqueue.h"
+#include "drawqueue.h"
+#include "dynamicresolution.h"
+#include "framearena.h"
+#include "gputrace.h"
+#include "instancebuffer.h"
+#include "lod.h"
+#include "memory.h"
+#include "output.h"
+#include "particles.h"
+#include "readback.h"
+#include "scene.h"
+#include "settings.h"
+#include "shaderwatcher.h"
+#include "simulation.h"
+#include "texturestreamer.h"
+#include "vkhandle.h"
 #include <vulkan.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -10,89 +35,192 @@
 class Engine
 {
 public:
-    Engine();
+    Engine(const EngineSettings& settings = EngineSettings{});
     ~Engine();
     void run();
     void stop();
+    std::vector<double> benchmarkRender(uint32_t frameCount); // czas każdego render() w mikrosekundach
+    // liczba alokacji na stercie w każdym render(); update(frame) jest wołane przed ramką, poza pomiarem
+    std::vector<uint64_t> countFrameAllocations(uint32_t frameCount, const std::function<void(uint32_t)>& update);
+    std::vector<double> benchmarkParticles(uint32_t frameCount); // czas symulacji cząsteczek na GPU w ms, z ramek z wynikiem
+    // tick co 1/tickRate s na osobnym wątku, start ze stanu encji w scenie; render co ramkę przepisuje do sceny
+    // stan interpolowany między dwoma ostatnimi tickami. Encje nie mogą być usuwane, dopóki symulacja działa.
+    void startSimulation(std::vector<Entity> entities, SimulationTick tick, float tickRate = 60.0f);
+    void startRecording(const std::string& path); // przed wypełnieniem sceny - nagranie ma tylko operacje od tej chwili
+    // ramki z nagrania jedna po drugiej albo w oryginalnych odstępach; czas każdego render() w mikrosekundach
+    std::vector<double> replay(CommandLog& log, bool realtime);
+    void reloadShaders(); // podmienia pipeline bez vkDeviceWaitIdle - stary trafia do kolejki usuwania; z watchShaders dzieje się samo
+    Scene& scene() { return mScene; } // rysowana co klatkę, zmiany trafiają na GPU w render()
+    void setReadbackCallback(ReadbackCallback callback, uint32_t interval = 1); // kopia co interval-tą ramkę, callback z opóźnieniem mFramesInFlight ramek
+    MemoryStats memoryStats() const; // zużycie i budżet per sterta, alokacje per typ pamięci, wyrzucone zasoby
+    DrawQueueStats drawStats() const { return mDrawStats; } // draw'y i zmiany stanu ostatniej nagrywanej ramki, wszystkie wyjścia razem
+    float resolutionScale() const { return mDynamicResolution.scale(); } // bieżąca skala dynamicznej rozdzielczości, 1 gdy wyłączona
+
+    template<typename T>
+    void retire(T handle) // obiekt zniszczony dopiero gdy GPU skończy ramki, które mogły go używać
+    {
+        mDeletionQueue.retire(mFrameSlot, std::move(handle));
+    }
 
 private:
+    EngineSettings mSettings;
     uint32_t mFramesInFlight = 2; //ile będzie jednocześnie command bufferów
 
     uint16_t mWindowWidth = 800;
     uint16_t mWindowHeight = 600;
     bool mRun = true;
 
-    void assertVkSuccess(VkResult res, std::string_view);
+    void assertVkSuccess(VkResult res, std::string_view) const;
     void createInstance();
     void createDevice();
-    void createSurface();
-    void createSwapchain();
-    void createDepthImage();
+    void createWindows();
+    void createSurface(Output& output);
+    void createSwapchain(Output& output);
+    void createDepthImage(Output& output);
+    void createColorImage(Output& output); // tylko z dynamiczną rozdzielczością
     void createCommandBuffer();
     void createFence();
     void createSemaphores();
     void createRenderPass();
-    void createFrameBuffer();
-    void createPipeline();
+    void createFrameBuffer(Output& output);
+    bool recreateSwapchain(Output& output); // po zmianie rozmiaru; false - okno ma zerowy rozmiar (zminimalizowane)
+    void loadShaders();
+    void createPipelineLayout();
+    void createGeometry();
+    void createOcclusionCulling(Output& output);
+    void createTextureStreamer();
+    void createParticles();
+    void logMemoryStats() const;
+    void createPipelineCache(); // z pipeline_cache.bin, jeśli pasuje do urządzenia i sterownika
+    void savePipelineCache() const;
+    PipelineHandle createPipeline(const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode) const;
+    void rebuildPipelines(const std::vector<std::string>& fileNames); // wątek obserwatora - tylko pipeline'y zależne od tych plików
+    void applyReloadedPipelines(); // wątek renderu, na granicy ramek
+    void processEvents(); // opróżnia kolejkę zdarzeń okna
     void render(uint32_t i);
-
-    uint32_t findMemoryProperties(uint32_t memoryTypeBitsRequirement, VkMemoryPropertyFlags requiredProperties);
+    bool acquireImages(uint32_t frameIndex); // ustawia Output::acquired; false - żadne wyjście nie ma teraz obrazu, ramka jest pomijana
+    void applySimulation(); // najnowsza migawka symulacji -> scena
+    void recordOutput(VkCommandBuffer cmdBuff, uint32_t frameIndex, Output& output); // culling i renderpass jednego wyjścia
+    void recordDraws(VkCommandBuffer cmdBuff, const Output& output, const Matrix4& viewProjection); // zawartość renderpassu
+    void recordUpscale(VkCommandBuffer cmdBuff, const Output& output); // blit renderExtent -> cały obraz swapchaina
+
+    /*---- cached command buffers ---*/
+    struct CachedFrame
+    {
+        std::vector<uint32_t> imageIndices; // obraz każdego wyjścia, do którego bufor był nagrany
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        uint64_t version = 0; // mDrawStateVersion z chwili nagrania
+    };
+    static constexpr uint32_t staticFramesBeforeReuse = 2; // culling potrzebuje ramki z głębią po zmianie, żeby się ustalić
+    static constexpr size_t maxCachedFramesPerSlot = 8;
+
+    std::vector<VkCommandBuffer> allocateCommandBuffers(VkCommandBufferLevel level, uint32_t count, const std::string& name);
+    void invalidateCommandBuffers();
+    void updateDrawState(); // podbija wersję, jeśli zmieniło się coś, co jest w nagranych buforach
+    CachedFrame& cachedFrameFor(uint32_t frameIndex);
+
+    // kolejność deklaracji = odwrotna kolejność niszczenia: urządzenie po wszystkich swoich obiektach, okno po powierzchni
 
     /*------- instance ------------*/
-    VkInstance mInstance = VK_NULL_HANDLE;
+    InstanceHandle mInstance;
+    DebugUtils mDebugUtils; // aktywne tylko w profilu debug
 
     /*----- physical device -------*/
     VkPhysicalDeviceProperties mPhysicalDeviceProperties = {};
     VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
-    VkPhysicalDeviceMemoryProperties mDeviceMemoryProperties;
+    MemoryAllocator mAllocator;
 
     /*--------- queues ------------*/
     VkQueueFamilyProperties mQueueFamilyProperties = {};
     uint32_t mQueueFamilyIndex = 0;
     uint32_t mQueueCount = 1;
-    VkDevice mDevice = VK_NULL_HANDLE;
+    DeviceHandle mDevice;
     VkQueue mQueue = VK_NULL_HANDLE;
+    GpuTrace mGpuTrace; // tor GPU w trace'ie, tylko z --trace
+    DynamicResolution mDynamicResolution; // tylko z dynamicResolutionTarget i znacznikami czasu na kolejce
 
-    /*---- surface and window -----*/
-    VkSurfaceKHR mSurface = VK_NULL_HANDLE;
-    VkSurfaceCapabilitiesKHR mSurfaceCapabilities = {};
-    Window mWindow;
-    std::vector<VkSurfaceFormatKHR> mSurfaceFormats;
-
-    /*- swapchain and image views -*/
-    uint32_t mSwapchainImageCount = 0;
-    VkSwapchainKHR mSwapchain = VK_NULL_HANDLE;
-    std::vector<VkImage> mSwapchainImages;
-    VkFormat mSwapchainImageFormat;
-    std::vector<VkImageView> mImageViews;
-    uint32_t mSwapchainWidth = 0;
-    uint32_t mSwapchainHeight = 0;
-
-    /*------- depth image/view -----*/
-    std::vector<VkImage> mDepthImages;
-    std::vector<VkImageView> mDepthImageViews;
-    std::vector<VkDeviceMemory> mDeviceMemory {};
+    /*---------- outputs -----------*/
+    // okna ze swapchainami, tworzone w grafie startu równolegle z instancją i urządzeniem; [0] jest główne (readback)
+    std::vector<std::unique_ptr<Output>> mOutputs;
+    VkFormat mSwapchainImageFormat = VK_FORMAT_UNDEFINED; // wspólny dla wszystkich wyjść - jeden renderpass i pipeline
+    VkFilter mUpscaleFilter = VK_FILTER_LINEAR; // NEAREST, jeśli format nie ma filtrowania liniowego
 
     /*------- command buffer -------*/
-    VkCommandPool mCommandPool = VK_NULL_HANDLE;
+    CommandPoolHandle mCommandPool; // command buffery zwalniane razem z pulą
     std::vector<VkCommandBuffer> mCommandBuffers = std::vector<VkCommandBuffer>(2);
     VkCommandBufferBeginInfo mCommandBufferBeginInfo = {};
+    std::vector<std::vector<CachedFrame>> mCachedFrames; // tylko z cacheCommandBuffers, na slot ramki
+    uint64_t mDrawStateVersion = 1;
+    uint32_t mStaticFrames = 0; // ramki od ostatniej zmiany stanu
+    Camera mRecordedCamera;
+    size_t mRecordedInstanceCount = 0;
+    float mRecordedResolutionScale = 1.0f; // viewport i scissor są w nagranych buforach
 
     /*--- fences and semaphores ----*/
-    std::vector<VkFence> mQueueSubmitFences;
-    std::vector<VkSemaphore> mQueueSubmitSemaphores;
-    std::vector<VkSemaphore> mAcquireSemaphores;
+    std::vector<FenceHandle> mQueueSubmitFences;
+    std::vector<SemaphoreHandle> mQueueSubmitSemaphores; // jeden na ramkę - present czeka na niego raz dla wszystkich swapchainów
 
     /*--------- renderpass ---------*/
-    VkRenderPass mRenderPass = VK_NULL_HANDLE;
+    RenderPassHandle mRenderPass;
     VkSubpassDescription mSubpass {};
 
-    /*-------- framebuffer ---------*/
-    std::vector<VkFramebuffer> mFramebuffers;
+    /*------- draw submission ------*/
+    DrawQueue mDrawQueue; // wspólna dla wyjść - każde nagrywa swój renderpass po kolei
+    DrawQueueStats mDrawStats;
 
     /*--------- pipeline -----------*/
-    VkPipeline mPipeline = VK_NULL_HANDLE;
-    VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+    std::vector<uint32_t> mVertexShaderCode; // SPIR-V wczytany równolegle z tworzeniem swapchaina
+    std::vector<uint32_t> mDepthPyramidShaderCode;
+    std::vector<uint32_t> mCullShaderCode;
+    std::vector<uint32_t> mFragmentShaderCode;
+    std::vector<uint32_t> mParticleSimulationShaderCode;
+    std::vector<uint32_t> mParticleVertexShaderCode;
+    std::vector<uint32_t> mParticleFragmentShaderCode;
+    PipelineLayoutHandle mPipelineLayout;
+    PipelineCacheHandle mPipelineCache; // zapisywany przy zamknięciu - kolejne uruchomienie i przeładowania nie kompilują od zera
+    PipelineHandle mPipeline;
+
+    /*------ shader hot reload -----*/
+    struct ReloadedPipeline
+    {
+        uint32_t index = 0; // w reloadablePipelines
+        PipelineHandle pipeline;
+    };
+    ShaderWatcher mShaderWatcher; // tylko z watchShaders; zatrzymywany pierwszy w destruktorze
+    std::mutex mReloadMutex;
+    std::vector<ReloadedPipeline> mReloadedPipelines; // pod mReloadMutex, gotowe do podmiany
+    std::atomic<bool> mPipelinesReloaded {false};     // render() sprawdza bez blokady
+
+    /*----------- scene ------------*/
+    Scene mScene;
+    VertexLayout mVertexLayout; // z ustawień albo z pliku siatki, potrzebny pipeline'owi
+    QuantizationParameters mMeshQuantization;
+    Buffer mMeshVertices;
+    Buffer mMeshIndices; // pusty dla siatki bez indeksów
+    uint32_t mMeshVertexCount = 0;
+    VkIndexType mMeshIndexType = VK_INDEX_TYPE_UINT32;
+    std::vector<MeshLod> mMeshLods; // zakresy indeksów, a dla siatki bez indeksów - wierzchołków
+    LodSelector mLodSelector;
+    InstanceBuffer mInstanceBuffer;
+    TextureStreamer mTextureStreamer;
+    std::vector<TextureId> mTextures; // z ustawień, w tej samej kolejności
+    ParticleSystem mParticles;
+    std::chrono::steady_clock::time_point mLastRenderTime; // krok symulacji cząsteczek
+    std::unique_ptr<CommandRecorder> mRecorder; // tylko przy nagrywaniu
+    Simulation mSimulation;
+    std::vector<Entity> mSimulatedEntities;
+    uint64_t mAppliedTick = UINT64_MAX; // migawka i chwila interpolacji ostatnio przepisane do sceny
+    float mAppliedAlpha = 0.0f;
+
+    /*---------- readback ----------*/
+    FrameReadback mReadback;
+    uint64_t mFrameNumber = 0;
+
+    /*------ deferred deletion -----*/
+    uint32_t mFrameSlot = 0; // slot ramki, która jest teraz nagrywana
+    FrameArena mFrameArena;  // dane CPU ramki - render() nie alokuje na stercie
+    static constexpr size_t frameArenaBytes = 64 * 1024;
+    DeletionQueue mDeletionQueue; // ostatnie pole - niszczone pierwsze
 
 };
 
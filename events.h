@@ -0,0 +1,45 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+#include "spscqueue.h"
+#include <chrono>
+#include <cstdint>
+
+enum class EventType : uint8_t
+{
+    KeyDown,
+    KeyUp,
+    MouseMove,
+    MouseButtonDown,
+    MouseButtonUp,
+    Resize,
+    Close // użytkownik zamyka okno - okno jeszcze istnieje, decyzja należy do silnika
+};
+
+enum class Key : uint8_t
+{
+    Unknown, // reszta tylko jako code
+    Escape,
+    Space,
+    Enter
+};
+
+struct Event
+{
+    EventType type = EventType::Close;
+    Key key = Key::Unknown;
+    uint8_t button = 0;   // 1 - lewy, 2 - środkowy, 3 - prawy
+    uint32_t code = 0;    // kod klawisza platformy (VK_* na Windows, keycode X11)
+    int32_t x = 0;        // pozycja myszy albo nowa szerokość okna
+    int32_t y = 0;        // albo wysokość
+    uint64_t timestamp = 0; // eventTimestamp() w chwili odebrania przez wątek okna
+};
+
+using EventQueue = SpscQueue<Event, 1024>;
+
+// ns zegara monotonicznego - to samo źródło co pomiary ramek, więc da się policzyć opóźnienie wejścia
+inline uint64_t eventTimestamp()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // EVENTS_H
@@ -0,0 +1,47 @@
+#include "framearena.h"
+#include "log.h"
+
+void FrameArena::resize(uint32_t frameSlots, size_t bytesPerSlot)
+{
+    mSlots.resize(frameSlots);
+    for(Slot& slot : mSlots)
+    {
+        slot.memory = std::make_unique<std::byte[]>(bytesPerSlot);
+        slot.size = bytesPerSlot;
+        slot.offset = 0;
+    }
+    mCurrentSlot = 0;
+}
+
+void FrameArena::reset(uint32_t frameSlot)
+{
+    Slot& slot = mSlots[frameSlot];
+    if(slot.overflowBytes > 0)
+    {
+        // alokacja tylko wtedy, gdy ramka potrzebowała więcej niż kiedykolwiek - w stanie ustalonym nie ma tu nic do roboty
+        const size_t size = (slot.size + slot.overflowBytes) * 2;
+        logger::debug("frame arena slot ", frameSlot, " grows from ", slot.size, " to ", size, " bytes");
+        slot.overflow.clear();
+        slot.overflowBytes = 0;
+        slot.memory = std::make_unique<std::byte[]>(size);
+        slot.size = size;
+    }
+    slot.offset = 0;
+    mCurrentSlot = frameSlot;
+}
+
+void* FrameArena::allocateBytes(size_t size, size_t alignment)
+{
+    Slot& slot = mSlots[mCurrentSlot];
+    const size_t offset = (slot.offset + alignment - 1) & ~(alignment - 1);
+    if(offset + size <= slot.size)
+    {
+        slot.offset = offset + size;
+        return slot.memory.get() + offset;
+    }
+
+    // new[] wyrównuje do max_align_t, a większego wyrównania allocate() nie przepuszcza
+    slot.overflow.push_back(std::make_unique<std::byte[]>(size));
+    slot.overflowBytes += size;
+    return slot.overflow.back().get();
+}
@@ -0,0 +1,51 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Pamięć CPU na dane żyjące jedną ramkę (listy semaforów do submitu, struktury do presentu itp.), jeden liniowy blok
+// na slot ramki. allocate() tylko przesuwa offset, reset() po odczekaniu fence'a slotu oddaje wszystko naraz.
+// Destruktory nie są wołane, więc tylko typy trywialnie niszczalne.
+class FrameArena
+{
+public:
+    void resize(uint32_t frameSlots, size_t bytesPerSlot);
+    void reset(uint32_t frameSlot); // od teraz allocate() bierze z tego slotu
+
+    template<typename T>
+    T* allocate(size_t count) // elementy zainicjalizowane T{}
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "frame arena never runs destructors");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        T* items = static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+        for(size_t i = 0; i < count; i++)
+        {
+            new(items + i) T{};
+        }
+        return items;
+    }
+
+    size_t capacity(uint32_t frameSlot) const { return mSlots[frameSlot].size; }
+
+private:
+    struct Slot
+    {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size = 0;
+        size_t offset = 0;
+        // co się nie zmieściło - osobne bloki do końca ramki, przy następnym reset() blok główny rośnie o ich sumę
+        std::vector<std::unique_ptr<std::byte[]>> overflow;
+        size_t overflowBytes = 0;
+    };
+
+    void* allocateBytes(size_t size, size_t alignment);
+
+    std::vector<Slot> mSlots;
+    uint32_t mCurrentSlot = 0;
+};
+
+#endif // FRAMEARENA_H
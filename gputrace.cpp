@@ -0,0 +1,177 @@
+#include "gputrace.h"
+#include "log.h"
+#include "trace.h"
+#include <vector>
+
+namespace
+{
+    uint64_t hostTicksToNanoseconds(uint64_t ticks)
+    {
+#if(_WIN32)
+        // steady_clock w MSVC to QueryPerformanceCounter przeliczony na ns
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<uint64_t>(double(ticks) * 1e9 / double(frequency.QuadPart));
+#else
+        return ticks; // CLOCK_MONOTONIC - ten sam zegar co steady_clock
+#endif
+    }
+}
+
+bool GpuTrace::create(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t frameSlots,
+                      uint32_t timestampValidBits, float timestampPeriod)
+{
+#if(_WIN32)
+    const VkTimeDomainEXT hostDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+    const VkTimeDomainEXT hostDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+    if(timestampValidBits == 0)
+    {
+        return false;
+    }
+
+    // funkcje rozszerzenia nie są eksportowane przez loader
+    auto getTimeDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+    auto getCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(vkGetDeviceProcAddr(device, "vkGetCalibratedTimestampsEXT"));
+    if(getTimeDomains == nullptr || getCalibratedTimestamps == nullptr)
+    {
+        return false;
+    }
+
+    uint32_t domainCount = 0;
+    getTimeDomains(physicalDevice, &domainCount, NULL);
+    std::vector<VkTimeDomainEXT> domains(domainCount);
+    getTimeDomains(physicalDevice, &domainCount, domains.data());
+    bool deviceDomain = false;
+    bool hostDomainFound = false;
+    for(VkTimeDomainEXT domain : domains)
+    {
+        deviceDomain |= domain == VK_TIME_DOMAIN_DEVICE_EXT;
+        hostDomainFound |= domain == hostDomain;
+    }
+    if(!deviceDomain || !hostDomainFound)
+    {
+        return false;
+    }
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo {};
+    queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCreateInfo.pNext = NULL;
+    queryPoolCreateInfo.flags = 0;
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = frameSlots * maxScopesPerFrame * 2;
+
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    if(vkCreateQueryPool(device, &queryPoolCreateInfo, NULL, &queryPool) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    mDevice = device;
+    mQueryPool = QueryPoolHandle(device, queryPool);
+    mGetCalibratedTimestamps = getCalibratedTimestamps;
+    mHostDomain = hostDomain;
+    mTimestampMask = timestampValidBits >= 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+    mTimestampPeriod = timestampPeriod;
+    mSlots.resize(frameSlots);
+    return true;
+}
+
+void GpuTrace::collect(uint32_t frameSlot)
+{
+    if(!isEnabled() || mSlots[frameSlot].scopeCount == 0 || !trace::isEnabled())
+    {
+        return;
+    }
+    if(++mFramesSinceCalibration >= calibrationInterval)
+    {
+        calibrate();
+    }
+
+    // para (wartość, dostępność) na zapytanie - zakres z niedostępnym wynikiem (np. pierwsze nagranie) jest pomijany
+    const Slot& slot = mSlots[frameSlot];
+    std::array<uint64_t, maxScopesPerFrame * 2 * 2> results = {};
+    const VkResult res = vkGetQueryPoolResults(mDevice, mQueryPool, frameSlot * maxScopesPerFrame * 2, slot.scopeCount * 2,
+                                               sizeof(results), results.data(), 2 * sizeof(uint64_t),
+                                               VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if(res != VK_SUCCESS && res != VK_NOT_READY)
+    {
+        return;
+    }
+
+    for(uint32_t scope = 0; scope < slot.scopeCount; scope++)
+    {
+        const uint64_t* query = &results[scope * 4];
+        if(query[1] != 0 && query[3] != 0)
+        {
+            trace::gpuComplete(slot.names[scope], toHostTime(query[0]), toHostTime(query[2]));
+        }
+    }
+}
+
+void GpuTrace::beginFrame(VkCommandBuffer cmdBuff, uint32_t frameSlot)
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+    mRecordingSlot = frameSlot;
+    mSlots[frameSlot].scopeCount = 0;
+    vkCmdResetQueryPool(cmdBuff, mQueryPool, frameSlot * maxScopesPerFrame * 2, maxScopesPerFrame * 2);
+}
+
+uint32_t GpuTrace::begin(VkCommandBuffer cmdBuff, const char* name)
+{
+    if(!isEnabled() || mSlots[mRecordingSlot].scopeCount == maxScopesPerFrame)
+    {
+        return UINT32_MAX;
+    }
+    Slot& slot = mSlots[mRecordingSlot];
+    const uint32_t scope = slot.scopeCount++;
+    slot.names[scope] = name;
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, (mRecordingSlot * maxScopesPerFrame + scope) * 2);
+    return scope;
+}
+
+void GpuTrace::end(VkCommandBuffer cmdBuff, uint32_t scope)
+{
+    if(!isEnabled() || scope == UINT32_MAX)
+    {
+        return;
+    }
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mQueryPool, (mRecordingSlot * maxScopesPerFrame + scope) * 2 + 1);
+}
+
+void GpuTrace::calibrate()
+{
+    std::array<VkCalibratedTimestampInfoEXT, 2> infos {};
+    infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[0].pNext = NULL;
+    infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+    infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[1].pNext = NULL;
+    infos[1].timeDomain = mHostDomain;
+
+    std::array<uint64_t, 2> timestamps = {};
+    uint64_t maxDeviation = 0;
+    if(mGetCalibratedTimestamps(mDevice, infos.size(), infos.data(), timestamps.data(), &maxDeviation) == VK_SUCCESS)
+    {
+        mCalibrationDeviceTicks = timestamps[0];
+        mCalibrationHostTime = hostTicksToNanoseconds(timestamps[1]);
+        mFramesSinceCalibration = 0;
+    }
+}
+
+uint64_t GpuTrace::toHostTime(uint64_t deviceTicks) const
+{
+    // licznik ma timestampValidBits bitów i może się przekręcić - różnica modulo, ze znakiem
+    uint64_t delta = (deviceTicks - mCalibrationDeviceTicks) & mTimestampMask;
+    int64_t signedDelta = static_cast<int64_t>(delta);
+    if(delta > mTimestampMask / 2)
+    {
+        signedDelta = -static_cast<int64_t>((mTimestampMask - delta) + 1);
+    }
+    return mCalibrationHostTime + static_cast<int64_t>(double(signedDelta) * mTimestampPeriod);
+}
@@ -0,0 +1,52 @@
+#ifndef GPUTRACE_H
+#define GPUTRACE_H
+#include "vkhandle.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Znaczniki czasu GPU dla trace'u: zakres to para zapytań w command bufferze ramki. Wyniki slotu są czytane po
+// odczekaniu jego fence'a (bez czekania na GPU) i przeliczane na zegar trace::now() przez VK_EXT_calibrated_timestamps.
+// Tworzone tylko, gdy śledzenie jest włączone przy starcie - bez tego wszystkie metody są no-opami.
+class GpuTrace
+{
+public:
+    static constexpr uint32_t maxScopesPerFrame = 16;
+
+    // false - rozszerzenie nie zna zegara hosta, którego używa trace::now(), albo kolejka nie ma timestampów
+    bool create(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t frameSlots,
+                uint32_t timestampValidBits, float timestampPeriod);
+    bool isEnabled() const { return mQueryPool != VK_NULL_HANDLE; }
+
+    void collect(uint32_t frameSlot);                            // po vkWaitForFences slotu
+    void beginFrame(VkCommandBuffer cmdBuff, uint32_t frameSlot); // zaraz po vkBeginCommandBuffer, przed renderpassem
+    uint32_t begin(VkCommandBuffer cmdBuff, const char* name);  // nazwa musi żyć do trace::stop()
+    void end(VkCommandBuffer cmdBuff, uint32_t scope);
+
+private:
+    struct Slot
+    {
+        std::array<const char*, maxScopesPerFrame> names = {};
+        uint32_t scopeCount = 0; // z ostatniego nagrania - bufor z cache jest wysyłany z tymi samymi zakresami
+    };
+
+    void calibrate();
+    uint64_t toHostTime(uint64_t deviceTicks) const;
+
+    VkDevice mDevice = VK_NULL_HANDLE;
+    QueryPoolHandle mQueryPool;
+    PFN_vkGetCalibratedTimestampsEXT mGetCalibratedTimestamps = nullptr;
+    VkTimeDomainEXT mHostDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+    uint64_t mTimestampMask = 0;
+    double mTimestampPeriod = 1.0; // ns na tick
+    std::vector<Slot> mSlots;
+    uint32_t mRecordingSlot = 0;
+
+    // para odczytów z tej samej chwili; zegary dryfują, więc co calibrationInterval odczytanych ramek od nowa
+    static constexpr uint32_t calibrationInterval = 64;
+    uint32_t mFramesSinceCalibration = calibrationInterval;
+    uint64_t mCalibrationDeviceTicks = 0;
+    uint64_t mCalibrationHostTime = 0;
+};
+
+#endif // GPUTRACE_H
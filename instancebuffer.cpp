@@ -0,0 +1,135 @@
+#include "instancebuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t minimumCapacity = 1024;
+    constexpr VkDeviceSize recordSize = sizeof(InstanceData);
+}
+
+void InstanceBuffer::create(MemoryAllocator& allocator, uint32_t frameSlots)
+{
+    mAllocator = &allocator;
+    mStaging.resize(frameSlots);
+}
+
+size_t InstanceBuffer::upload(VkCommandBuffer cmdBuff, uint32_t frameSlot, const Scene& scene, DeletionQueue& deletionQueue)
+{
+    const size_t instanceCount = scene.instanceCount();
+    reserve(instanceCount, frameSlot, deletionQueue);
+
+    const std::vector<InstanceData>& instances = scene.instances();
+    mRegions.clear();
+    size_t copiedRecords = 0;
+
+    if(mFullUpload)
+    {
+        if(instanceCount == 0)
+        {
+            return 0;
+        }
+        reserveStaging(instanceCount, frameSlot, deletionQueue);
+        std::memcpy(mStaging[frameSlot].mapped, instances.data(), instanceCount * recordSize);
+        mRegions.push_back({0, 0, instanceCount * recordSize});
+        mFullUpload = false;
+        copiedRecords = instanceCount;
+    }
+    else
+    {
+        mSortedIndices.clear();
+        for(const uint32_t index : scene.changedInstances())
+        {
+            if(index < instanceCount) // rekordy usuniętych instancji
+            {
+                mSortedIndices.push_back(index);
+            }
+        }
+        if(mSortedIndices.empty())
+        {
+            return 0;
+        }
+        std::sort(mSortedIndices.begin(), mSortedIndices.end());
+        reserveStaging(mSortedIndices.size(), frameSlot, deletionQueue);
+
+        auto* staging = static_cast<InstanceData*>(mStaging[frameSlot].mapped);
+        for(size_t i = 0; i < mSortedIndices.size(); i++)
+        {
+            const uint32_t index = mSortedIndices[i];
+            staging[i] = instances[index];
+
+            if(!mRegions.empty() && mRegions.back().dstOffset + mRegions.back().size == index * recordSize)
+            {
+                mRegions.back().size += recordSize;
+            }
+            else
+            {
+                mRegions.push_back({i * recordSize, index * recordSize, recordSize});
+            }
+        }
+        copiedRecords = mSortedIndices.size();
+    }
+
+    mAllocator->flush(mStaging[frameSlot]);
+
+    // poprzednia klatka może jeszcze czytać bufor instancji w vertex input albo w cullingu - kopia musi na nią poczekać
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 0, NULL);
+
+    vkCmdCopyBuffer(cmdBuff, mStaging[frameSlot].buffer, mBuffer.buffer, static_cast<uint32_t>(mRegions.size()), mRegions.data());
+
+    VkBufferMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = mBuffer.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+
+    return copiedRecords;
+}
+
+void InstanceBuffer::reserve(size_t instanceCount, uint32_t frameSlot, DeletionQueue& deletionQueue)
+{
+    if(instanceCount <= mCapacity)
+    {
+        return;
+    }
+
+    size_t capacity = std::max(mCapacity * 2, minimumCapacity);
+    while(capacity < instanceCount)
+    {
+        capacity *= 2;
+    }
+
+    if(mBuffer.buffer != VK_NULL_HANDLE)
+    {
+        deletionQueue.retire(frameSlot, std::move(mBuffer));
+    }
+    mBuffer = mAllocator->createBuffer(capacity * recordSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT); // storage - czytany też przez culling
+    mCapacity = capacity;
+    mFullUpload = true;
+}
+
+void InstanceBuffer::reserveStaging(size_t recordCount, uint32_t frameSlot, DeletionQueue& deletionQueue)
+{
+    Buffer& staging = mStaging[frameSlot];
+    const VkDeviceSize size = recordCount * recordSize;
+    if(staging.size >= size)
+    {
+        return;
+    }
+
+    if(staging.buffer != VK_NULL_HANDLE)
+    {
+        deletionQueue.retire(frameSlot, std::move(staging));
+    }
+    // rozmiar jak bufora docelowego - po pierwszym pełnym uploadzie staging już nie rośnie
+    staging = mAllocator->createBuffer(std::max(size, mCapacity * recordSize), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
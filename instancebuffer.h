@@ -0,0 +1,33 @@
+#ifndef INSTANCEBUFFER_H
+#define INSTANCEBUFFER_H
+#include "deletionqueue.h"
+#include "memory.h"
+#include "scene.h"
+#include <vector>
+
+// Rekordy instancji w pamięci device local. Co klatkę do bufora stagingowego slotu trafiają tylko rekordy
+// z listy zmian sceny, a ciągłe zakresy indeksów są łączone w jeden VkBufferCopy.
+class InstanceBuffer
+{
+public:
+    void create(MemoryAllocator& allocator, uint32_t frameSlots);
+
+    // przed renderpassem, zwraca liczbę skopiowanych rekordów; stare bufory po powiększeniu trafiają do deletionQueue
+    size_t upload(VkCommandBuffer cmdBuff, uint32_t frameSlot, const Scene& scene, DeletionQueue& deletionQueue);
+    VkBuffer buffer() const { return mBuffer.buffer; }
+
+private:
+    void reserve(size_t instanceCount, uint32_t frameSlot, DeletionQueue& deletionQueue);
+    void reserveStaging(size_t recordCount, uint32_t frameSlot, DeletionQueue& deletionQueue);
+
+    MemoryAllocator* mAllocator = nullptr;
+    Buffer mBuffer;
+    size_t mCapacity = 0; // w rekordach
+    bool mFullUpload = false; // po powiększeniu nowy bufor trzeba wypełnić w całości
+
+    std::vector<Buffer> mStaging; // jeden na slot ramki
+    std::vector<uint32_t> mSortedIndices;
+    std::vector<VkBufferCopy> mRegions;
+};
+
+#endif // INSTANCEBUFFER_H
@@ -0,0 +1,136 @@
+#include "lod.h"
+#include <algorithm>
+#include <iterator>
+
+// Porównania bez dzielenia: rzutowany promień r * scale / d <= limit  <=>  r * scale <= limit * d.
+// Kamera wewnątrz sfery (d <= r) daje zawsze LOD 0.
+
+void scalar::selectLods(const LodThresholds& thresholds, const Vector3& cameraPosition, const InstanceData* instances, size_t count, uint32_t* lods)
+{
+    const float hysteresisScale = 1.0f / (1.0f - thresholds.hysteresis);
+    for(size_t i = 0; i < count; i++)
+    {
+        const Matrix4& m = instances[i].model;
+        const Vector3 center = m[0].xyz() * thresholds.bounds.x + m[1].xyz() * thresholds.bounds.y + m[2].xyz() * thresholds.bounds.z + m[3].xyz();
+        const float scale2 = std::max(std::max(dot(m[0].xyz(), m[0].xyz()), dot(m[1].xyz(), m[1].xyz())), dot(m[2].xyz(), m[2].xyz()));
+        const float projected = thresholds.bounds.w * std::sqrt(scale2) * thresholds.projectionScale;
+        const float distance = length(center - cameraPosition);
+
+        uint32_t finer = 0;
+        uint32_t coarser = 0;
+        for(uint32_t lod = 1; lod < thresholds.lodCount; lod++)
+        {
+            finer += projected <= thresholds.limits[lod] * distance;
+            coarser += projected * hysteresisScale <= thresholds.limits[lod] * distance;
+        }
+        lods[i] = finer < lods[i] ? finer : std::max(lods[i], coarser);
+    }
+}
+
+void selectLods(const LodThresholds& thresholds, const Vector3& cameraPosition, const InstanceData* instances, size_t count, uint32_t* lods)
+{
+    size_t i = 0;
+#ifdef MATH_SSE
+    const __m128 boundsX = _mm_set1_ps(thresholds.bounds.x);
+    const __m128 boundsY = _mm_set1_ps(thresholds.bounds.y);
+    const __m128 boundsZ = _mm_set1_ps(thresholds.bounds.z);
+    const __m128 radiusScale = _mm_set1_ps(thresholds.bounds.w * thresholds.projectionScale);
+    const __m128 hysteresisScale = _mm_set1_ps(1.0f / (1.0f - thresholds.hysteresis));
+    const __m128 cameraX = _mm_set1_ps(cameraPosition.x);
+    const __m128 cameraY = _mm_set1_ps(cameraPosition.y);
+    const __m128 cameraZ = _mm_set1_ps(cameraPosition.z);
+
+    for(; i + 4 <= count; i += 4)
+    {
+        // AoS -> SoA: kolumna k czterech macierzy w rejestrach x, y, z (w pomijane)
+        __m128 x[4], y[4], z[4];
+        for(int column = 0; column < 4; column++)
+        {
+            __m128 w;
+            x[column] = _mm_load_ps(&instances[i].model[column].x);
+            y[column] = _mm_load_ps(&instances[i + 1].model[column].x);
+            z[column] = _mm_load_ps(&instances[i + 2].model[column].x);
+            w = _mm_load_ps(&instances[i + 3].model[column].x);
+            _MM_TRANSPOSE4_PS(x[column], y[column], z[column], w);
+        }
+
+        const __m128 centerX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x[0], boundsX), _mm_mul_ps(x[1], boundsY)), _mm_add_ps(_mm_mul_ps(x[2], boundsZ), x[3]));
+        const __m128 centerY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y[0], boundsX), _mm_mul_ps(y[1], boundsY)), _mm_add_ps(_mm_mul_ps(y[2], boundsZ), y[3]));
+        const __m128 centerZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(z[0], boundsX), _mm_mul_ps(z[1], boundsY)), _mm_add_ps(_mm_mul_ps(z[2], boundsZ), z[3]));
+
+        __m128 scale2 = _mm_setzero_ps();
+        for(int column = 0; column < 3; column++)
+        {
+            const __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x[column], x[column]), _mm_mul_ps(y[column], y[column])), _mm_mul_ps(z[column], z[column]));
+            scale2 = _mm_max_ps(scale2, length2);
+        }
+        const __m128 projected = _mm_mul_ps(radiusScale, _mm_sqrt_ps(scale2));
+        const __m128 projectedHysteresis = _mm_mul_ps(projected, hysteresisScale);
+
+        const __m128 dx = _mm_sub_ps(centerX, cameraX);
+        const __m128 dy = _mm_sub_ps(centerY, cameraY);
+        const __m128 dz = _mm_sub_ps(centerZ, cameraZ);
+        const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+        // maska porównania to -1, więc odejmowanie liczy spełnione progi
+        __m128i finer = _mm_setzero_si128();
+        __m128i coarser = _mm_setzero_si128();
+        for(uint32_t lod = 1; lod < thresholds.lodCount; lod++)
+        {
+            const __m128 limit = _mm_mul_ps(_mm_set1_ps(thresholds.limits[lod]), distance);
+            finer = _mm_sub_epi32(finer, _mm_castps_si128(_mm_cmple_ps(projected, limit)));
+            coarser = _mm_sub_epi32(coarser, _mm_castps_si128(_mm_cmple_ps(projectedHysteresis, limit)));
+        }
+
+        // SSE2 nie ma min/max na int32 - wybór przez maski
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lods + i));
+        const __m128i coarserMask = _mm_cmpgt_epi32(coarser, current);
+        const __m128i kept = _mm_or_si128(_mm_and_si128(coarserMask, coarser), _mm_andnot_si128(coarserMask, current));
+        const __m128i finerMask = _mm_cmplt_epi32(finer, current);
+        const __m128i result = _mm_or_si128(_mm_and_si128(finerMask, finer), _mm_andnot_si128(finerMask, kept));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lods + i), result);
+    }
+#endif
+    scalar::selectLods(thresholds, cameraPosition, instances + i, count - i, lods + i);
+}
+
+void LodSelector::setMesh(const Sphere& bounds, const float* errors, uint32_t lodCount, float pixelError)
+{
+    mThresholds.bounds = bounds;
+    mThresholds.lodCount = std::min(std::max(lodCount, 1u), maxMeshLodCount);
+
+    float error = 0.0f;
+    for(uint32_t lod = 1; lod < mThresholds.lodCount; lod++)
+    {
+        // błąd musi rosnąć z LOD-em, inaczej zliczanie progów nie działa
+        error = std::max(error, errors[lod]);
+        mThresholds.limits[lod] = error > 0.0f ? pixelError / error : 1e30f;
+    }
+    std::fill(mLods.begin(), mLods.end(), 0u);
+}
+
+const std::vector<LodBatch>& LodSelector::update(const Scene& scene, float viewportHeight)
+{
+    const std::vector<InstanceData>& instances = scene.instances();
+    const Camera& camera = scene.camera();
+    mLods.resize(instances.size(), 0u);
+
+    mThresholds.projectionScale = viewportHeight / (2.0f * std::tan(camera.fovY * 0.5f));
+    if(mThresholds.lodCount > 1)
+    {
+        selectLods(mThresholds, camera.position, instances.data(), instances.size(), mLods.data());
+    }
+
+    mBatches.clear();
+    std::fill(std::begin(mLodInstanceCounts), std::end(mLodInstanceCounts), 0u);
+    for(uint32_t i = 0; i < mLods.size(); i++)
+    {
+        mLodInstanceCounts[mLods[i]]++;
+        if(mBatches.empty() || mBatches.back().lod != mLods[i])
+        {
+            mBatches.push_back({mLods[i], i, 0});
+        }
+        mBatches.back().instanceCount++;
+    }
+    return mBatches;
+}
@@ -0,0 +1,57 @@
+#ifndef LOD_H
+#define LOD_H
+#include "mathlib.h"
+#include "meshfile.h"
+#include "scene.h"
+#include <cstdint>
+#include <vector>
+
+// Progi LOD-ów jednej siatki. LOD i jest dopuszczalny, dopóki rzutowany promień sfery otaczającej (w pikselach)
+// nie przekracza limits[i] - wtedy jego błąd uproszczenia na ekranie jest mniejszy niż zadany błąd w pikselach.
+struct LodThresholds
+{
+    Sphere bounds;                     // sfera siatki w przestrzeni modelu
+    float limits[maxMeshLodCount] = {};    // limits[0] nieużywany - LOD 0 jest zawsze dopuszczalny
+    uint32_t lodCount = 1;
+    float projectionScale = 1.0f;      // wysokość viewportu / (2 * tan(fovY / 2))
+    float hysteresis = 0.1f;           // przejście na grubszy LOD dopiero przy promieniu mniejszym o ten ułamek
+};
+
+// Dla każdej instancji: nowy LOD z rzutowanego promienia i poprzedniego LOD-u (w lods, nadpisywany).
+// Na drobniejszy LOD przechodzimy od razu, na grubszy - z histerezą, żeby nie migało na granicy.
+namespace scalar
+{
+    void selectLods(const LodThresholds& thresholds, const Vector3& cameraPosition, const InstanceData* instances, size_t count, uint32_t* lods);
+}
+void selectLods(const LodThresholds& thresholds, const Vector3& cameraPosition, const InstanceData* instances, size_t count, uint32_t* lods);
+
+struct LodBatch
+{
+    uint32_t lod;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+// Stan LOD-ów instancji sceny i podział na batche. Batch to ciągły zakres instancji z tym samym LOD-em,
+// rysowany przez firstInstance prosto z bufora instancji, więc bufor instancji nie jest przestawiany.
+class LodSelector
+{
+public:
+    // errors - błąd LOD-u względem promienia sfery siatki, rosnący; pixelError - dopuszczalny błąd na ekranie
+    void setMesh(const Sphere& bounds, const float* errors, uint32_t lodCount, float pixelError = 1.0f);
+
+    const std::vector<LodBatch>& update(const Scene& scene, float viewportHeight);
+    const std::vector<LodBatch>& batches() const { return mBatches; }
+    uint32_t lodCount() const { return mThresholds.lodCount; }
+    const Sphere& bounds() const { return mThresholds.bounds; }
+    const std::vector<uint32_t>& lods() const { return mLods; }
+    const uint32_t* lodInstanceCounts() const { return mLodInstanceCounts; } // po update(), maxMeshLodCount elementów
+
+private:
+    LodThresholds mThresholds;
+    std::vector<uint32_t> mLods; // aktualny LOD każdej instancji, indeks jak w Scene::instances()
+    std::vector<LodBatch> mBatches;
+    uint32_t mLodInstanceCounts[maxMeshLodCount] = {};
+};
+
+#endif // LOD_H
@@ -0,0 +1,31 @@
+#include "log.h"
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+    std::mutex logMutex; // kroki startu logują z kilku wątków naraz
+
+    const char* levelName(LogLevel level)
+    {
+        switch(level)
+        {
+        case LogLevel::Debug:
+            return "debug";
+        case LogLevel::Info:
+            return "info";
+        case LogLevel::Warning:
+            return "warning";
+        case LogLevel::Error:
+            return "error";
+        }
+        return "";
+    }
+}
+
+void logger::write(LogLevel level, std::string_view message)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::ostream& stream = (level == LogLevel::Warning || level == LogLevel::Error) ? std::cerr : std::cout;
+    stream << "[" << levelName(level) << "] " << message << std::endl;
+}
@@ -0,0 +1,51 @@
+#ifndef LOG_H
+#define LOG_H
+#include <sstream>
+#include <string_view>
+
+enum class LogLevel
+{
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+namespace logger
+{
+    void write(LogLevel level, std::string_view message); // thread-safe, jedna linia na wywołanie
+
+    template<typename... Args>
+    void message(LogLevel level, const Args&... args)
+    {
+        std::ostringstream stream;
+        (stream << ... << args);
+        write(level, stream.str());
+    }
+
+    template<typename... Args>
+    void debug(const Args&... args)
+    {
+        message(LogLevel::Debug, args...);
+    }
+
+    template<typename... Args>
+    void info(const Args&... args)
+    {
+        message(LogLevel::Info, args...);
+    }
+
+    template<typename... Args>
+    void warning(const Args&... args)
+    {
+        message(LogLevel::Warning, args...);
+    }
+
+    template<typename... Args>
+    void error(const Args&... args)
+    {
+        message(LogLevel::Error, args...);
+    }
+}
+
+#endif // LOG_H
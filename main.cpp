@@ -1,8 +1,354 @@
 #include "engine.h"
+#include "benchmark.h"
+#include "capture.h"
+#include "log.h"
+#include "trace.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-int main()
+namespace
 {
-    Engine e;
+    std::vector<Entity> populateDemoScene(Scene& scene)
+    {
+        constexpr int gridSize = 32;
+        std::vector<Entity> instances;
+        for(int x = 0; x < gridSize; x++)
+        {
+            for(int z = 0; z < gridSize; z++)
+            {
+                LocalTransform transform;
+                transform.position = {(x - gridSize / 2) * 2.0f, 0.0f, (z - gridSize / 2) * 2.0f};
+                instances.push_back(scene.createInstance(transform));
+            }
+        }
+        scene.camera().position = {0.0f, 30.0f, 60.0f};
+        return instances;
+    }
+
+    // fala przez siatkę demo i obracające się sześciany - tylko z tego, co jest w stanie, bez dostępu do sceny
+    void simulateDemoScene(SimulationState& state, uint64_t tick, float deltaTime)
+    {
+        const float time = tick * deltaTime;
+        const Quaternion spin = fromAxisAngle({0.0f, 1.0f, 0.0f}, deltaTime);
+        for(LocalTransform& transform : state.transforms)
+        {
+            transform.position.y = std::sin(time * 2.0f + (transform.position.x + transform.position.z) * 0.2f);
+            transform.rotation = spin * transform.rotation;
+        }
+    }
+
+    // Cały argument musi być liczbą - std::stoul przepuszcza "12abc" i zawija "-1", a przy "x" rzuca bez informacji o fladze.
+    // argv[valueIndex - 1] to flaga, argv[valueIndex] wartość.
+    uint32_t parseUnsigned(char* argv[], int valueIndex)
+    {
+        const char* text = argv[valueIndex];
+        char* end = nullptr;
+        errno = 0;
+        const unsigned long long value = std::strtoull(text, &end, 10);
+        if(end == text || *end != '\0' || std::strchr(text, '-') != nullptr || errno == ERANGE || value > UINT32_MAX)
+        {
+            throw std::invalid_argument(std::string("invalid value for ") + argv[valueIndex - 1] + ": " + text);
+        }
+        return static_cast<uint32_t>(value);
+    }
+
+    float parseFloat(char* argv[], int valueIndex)
+    {
+        const char* text = argv[valueIndex];
+        char* end = nullptr;
+        errno = 0;
+        const float value = std::strtof(text, &end);
+        if(end == text || *end != '\0' || errno == ERANGE || !std::isfinite(value) || value < 0.0f)
+        {
+            throw std::invalid_argument(std::string("invalid value for ") + argv[valueIndex - 1] + ": " + text);
+        }
+        return value;
+    }
+
+    struct TraceSession // zamyka plik trace'u po zniszczeniu silnika, niezależnie od tego, którędy main wychodzi
+    {
+        ~TraceSession() { trace::stop(); }
+    };
+
+    void printUsage()
+    {
+        logger::info("usage: vulkan_project [--profile debug|release] [--no-vsync] [--vertex-layout full|compact|half] [--mesh <file.mesh>] [--no-occlusion]\n"
+                     "       [--memory-budget <MiB>] [--outputs <n>] [--cache-command-buffers] [--texture <file.tex>]... [--texture-budget <MiB>]\n"
+                     "       [--particles <n>] [--bench-particles <frames>] [--dynamic-resolution <ms>] [--watch-shaders]\n"
+                     "       [--bench-render <frames>] [--bench-scene <frames>] [--bench-math <iterations>] [--check-allocations <frames>]\n"
+                     "       [--capture <file>] [--capture-format y4m|raw] [--capture-policy drop|block] [--capture-every <n>]\n"
+                     "       [--trace <file.json>] [--record <file>] [--replay <file>] [--replay-realtime] [--simulate <ticks/s>]");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    EngineSettings settings;
+    uint32_t benchmarkFrames = 0;
+    uint32_t sceneBenchmarkFrames = 0;
+    uint32_t mathBenchmarkIterations = 0;
+    uint32_t allocationCheckFrames = 0;
+    uint32_t particleBenchmarkFrames = 0;
+    CaptureSettings captureSettings;
+    std::string tracePath;
+    std::string recordPath;
+    std::string replayPath;
+    bool replayRealtime = false;
+    float simulationRate = 0;
+
+    try
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            const bool hasValue = i + 1 < argc;
+
+            if(std::strcmp(argv[i], "--profile") == 0 && hasValue)
+            {
+                const char* value = argv[++i];
+                if(std::strcmp(value, "debug") == 0)
+                {
+                    settings.profile = Profile::Debug;
+                }
+                else if(std::strcmp(value, "release") == 0)
+                {
+                    settings.profile = Profile::Release;
+                }
+                else
+                {
+                    printUsage();
+                    return 1;
+                }
+            }
+            else if(std::strcmp(argv[i], "--no-vsync") == 0)
+            {
+                settings.vsync = false;
+            }
+            else if(std::strcmp(argv[i], "--vertex-layout") == 0 && hasValue)
+            {
+                const char* value = argv[++i];
+                if(std::strcmp(value, "full") == 0)
+                {
+                    settings.vertexLayout = VertexLayoutType::Full;
+                }
+                else if(std::strcmp(value, "compact") == 0)
+                {
+                    settings.vertexLayout = VertexLayoutType::Compact;
+                }
+                else if(std::strcmp(value, "half") == 0)
+                {
+                    settings.vertexLayout = VertexLayoutType::CompactHalf;
+                }
+                else
+                {
+                    printUsage();
+                    return 1;
+                }
+            }
+            else if(std::strcmp(argv[i], "--mesh") == 0 && hasValue)
+            {
+                settings.meshPath = argv[++i];
+            }
+            else if(std::strcmp(argv[i], "--no-occlusion") == 0)
+            {
+                settings.occlusionCulling = false;
+            }
+            else if(std::strcmp(argv[i], "--cache-command-buffers") == 0)
+            {
+                settings.cacheCommandBuffers = true;
+            }
+            else if(std::strcmp(argv[i], "--outputs") == 0 && hasValue)
+            {
+                settings.outputCount = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--memory-budget") == 0 && hasValue)
+            {
+                settings.memoryBudget = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--texture") == 0 && hasValue)
+            {
+                settings.texturePaths.push_back(argv[++i]);
+            }
+            else if(std::strcmp(argv[i], "--texture-budget") == 0 && hasValue)
+            {
+                settings.textureUploadBudget = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--particles") == 0 && hasValue)
+            {
+                settings.particleCount = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--dynamic-resolution") == 0 && hasValue)
+            {
+                settings.dynamicResolutionTarget = parseFloat(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--watch-shaders") == 0)
+            {
+                settings.watchShaders = true;
+            }
+            else if(std::strcmp(argv[i], "--bench-particles") == 0 && hasValue)
+            {
+                particleBenchmarkFrames = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--bench-render") == 0 && hasValue)
+            {
+                benchmarkFrames = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--bench-scene") == 0 && hasValue)
+            {
+                sceneBenchmarkFrames = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--bench-math") == 0 && hasValue)
+            {
+                mathBenchmarkIterations = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--check-allocations") == 0 && hasValue)
+            {
+                allocationCheckFrames = parseUnsigned(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--trace") == 0 && hasValue)
+            {
+                tracePath = argv[++i];
+            }
+            else if(std::strcmp(argv[i], "--record") == 0 && hasValue)
+            {
+                recordPath = argv[++i];
+            }
+            else if(std::strcmp(argv[i], "--replay") == 0 && hasValue)
+            {
+                replayPath = argv[++i];
+            }
+            else if(std::strcmp(argv[i], "--replay-realtime") == 0)
+            {
+                replayRealtime = true;
+            }
+            else if(std::strcmp(argv[i], "--simulate") == 0 && hasValue)
+            {
+                simulationRate = parseFloat(argv, ++i);
+            }
+            else if(std::strcmp(argv[i], "--capture") == 0 && hasValue)
+            {
+                captureSettings.path = argv[++i];
+            }
+            else if(std::strcmp(argv[i], "--capture-format") == 0 && hasValue)
+            {
+                const char* value = argv[++i];
+                if(std::strcmp(value, "y4m") == 0)
+                {
+                    captureSettings.format = CaptureFormat::Y4M;
+                }
+                else if(std::strcmp(value, "raw") == 0)
+                {
+                    captureSettings.format = CaptureFormat::Raw;
+                }
+                else
+                {
+                    printUsage();
+                    return 1;
+                }
+            }
+            else if(std::strcmp(argv[i], "--capture-policy") == 0 && hasValue)
+            {
+                const char* value = argv[++i];
+                if(std::strcmp(value, "drop") == 0)
+                {
+                    captureSettings.policy = CapturePolicy::DropNewest;
+                }
+                else if(std::strcmp(value, "block") == 0)
+                {
+                    captureSettings.policy = CapturePolicy::Block;
+                }
+                else
+                {
+                    printUsage();
+                    return 1;
+                }
+            }
+            else if(std::strcmp(argv[i], "--capture-every") == 0 && hasValue)
+            {
+                captureSettings.interval = parseUnsigned(argv, ++i);
+            }
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+    }
+    catch(const std::invalid_argument& e) // z parseUnsigned/parseFloat
+    {
+        logger::error(e.what());
+        printUsage();
+        return 1;
+    }
+
+    // przed silnikiem - startup też trafia do trace'u
+    TraceSession traceSession;
+    if(!tracePath.empty() && trace::start(tracePath))
+    {
+        trace::setThreadName("main");
+    }
+
+    if(!replayPath.empty())
+    {
+        runReplay(replayPath, settings, replayRealtime);
+        return 0;
+    }
+
+    if(benchmarkFrames > 0)
+    {
+        runRenderBenchmark(benchmarkFrames);
+        return 0;
+    }
+
+    if(particleBenchmarkFrames > 0)
+    {
+        runParticleBenchmark(particleBenchmarkFrames, settings.particleCount > 0 ? settings.particleCount : 4u << 20);
+        return 0;
+    }
+
+    if(allocationCheckFrames > 0)
+    {
+        return runAllocationCheck(allocationCheckFrames) ? 0 : 1;
+    }
+
+    if(mathBenchmarkIterations > 0)
+    {
+        runMathBenchmark(mathBenchmarkIterations);
+        return 0;
+    }
+
+    if(sceneBenchmarkFrames > 0)
+    {
+        runSceneBenchmark(sceneBenchmarkFrames);
+        return 0;
+    }
+
+    std::unique_ptr<FrameCapture> capture; // przed silnikiem - jego destruktor oddaje jeszcze ostatnie klatki z readbacku
+    if(!captureSettings.path.empty())
+    {
+        capture = std::make_unique<FrameCapture>(captureSettings);
+    }
+
+    Engine e(settings);
+    if(!recordPath.empty())
+    {
+        e.startRecording(recordPath);
+    }
+    std::vector<Entity> demoInstances = populateDemoScene(e.scene());
+    if(simulationRate > 0)
+    {
+        e.startSimulation(std::move(demoInstances), simulateDemoScene, simulationRate);
+    }
+    if(capture)
+    {
+        e.setReadbackCallback([&capture](const ReadbackFrame& frame){ capture->push(frame); }, captureSettings.interval);
+    }
     e.run();
     return 0;
 }
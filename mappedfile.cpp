@@ -0,0 +1,132 @@
+#include "mappedfile.h"
+#include <stdexcept>
+#include <utility>
+
+#if(_WIN32)
+#include <windows.h>
+#elif(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if(_WIN32)
+MappedFile::MappedFile(const std::string& path)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+    mFile = file;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    mSize = static_cast<size_t>(size.QuadPart);
+    if(mSize == 0)
+    {
+        return; // pustego pliku nie da się zmapować
+    }
+
+    mMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mMapping == NULL)
+    {
+        close();
+        throw std::runtime_error("failed to map " + path);
+    }
+    mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if(mData == nullptr)
+    {
+        close();
+        throw std::runtime_error("failed to map " + path);
+    }
+}
+
+void MappedFile::close()
+{
+    if(mData != nullptr)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if(mMapping != nullptr)
+    {
+        CloseHandle(mMapping);
+    }
+    if(mFile != nullptr)
+    {
+        CloseHandle(mFile);
+    }
+    mData = nullptr;
+    mMapping = nullptr;
+    mFile = nullptr;
+    mSize = 0;
+}
+#elif(__linux__)
+MappedFile::MappedFile(const std::string& path)
+{
+    const int file = open(path.c_str(), O_RDONLY);
+    if(file < 0)
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+
+    struct stat status;
+    if(fstat(file, &status) != 0)
+    {
+        ::close(file);
+        throw std::runtime_error("failed to stat " + path);
+    }
+    mSize = static_cast<size_t>(status.st_size);
+    if(mSize == 0)
+    {
+        ::close(file);
+        return;
+    }
+
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); // mapowanie trzyma własną referencję do pliku
+    if(data == MAP_FAILED)
+    {
+        mSize = 0;
+        throw std::runtime_error("failed to map " + path);
+    }
+    madvise(data, mSize, MADV_SEQUENTIAL); // czytamy strumienie od początku do końca - agresywny readahead
+    mData = static_cast<const uint8_t*>(data);
+}
+
+void MappedFile::close()
+{
+    if(mData != nullptr)
+    {
+        munmap(const_cast<uint8_t*>(mData), mSize);
+    }
+    mData = nullptr;
+    mSize = 0;
+}
+#endif // _WIN32
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if(this != &other)
+    {
+        close();
+        std::swap(mData, other.mData);
+        std::swap(mSize, other.mSize);
+#if(_WIN32)
+        std::swap(mFile, other.mFile);
+        std::swap(mMapping, other.mMapping);
+#endif
+    }
+    return *this;
+}
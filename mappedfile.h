@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Plik zmapowany tylko do odczytu. Strony ładuje system przy pierwszym dostępie, więc czytanie
+// prosto z data() do bufora stagingowego to jedyna kopia danych po drodze z dysku.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path); // rzuca, jeśli pliku nie da się otworzyć
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const uint8_t* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+private:
+    void close();
+
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+#if(_WIN32)
+    void* mFile = nullptr;    // HANDLE
+    void* mMapping = nullptr; // HANDLE
+#endif
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,144 @@
+#include "mathlib.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+Matrix4 perspective(float fovY, float aspect, float nearPlane, float farPlane)
+{
+    const float f = 1.0f / std::tan(fovY * 0.5f);
+    Matrix4 result {};
+    result[0].x = f / aspect;
+    result[1].y = f;
+    result[2].z = farPlane / (nearPlane - farPlane);
+    result[2].w = -1.0f;
+    result[3].z = nearPlane * farPlane / (nearPlane - farPlane);
+    return result;
+}
+
+Matrix4 lookAt(const Vector3& eye, const Vector3& target, const Vector3& up)
+{
+    const Vector3 f = normalize(target - eye);
+    const Vector3 s = normalize(cross(f, up));
+    const Vector3 u = cross(s, f);
+
+    return {{{s.x, u.x, -f.x, 0.0f},
+             {s.y, u.y, -f.y, 0.0f},
+             {s.z, u.z, -f.z, 0.0f},
+             {-dot(s, eye), -dot(u, eye), dot(f, eye), 1.0f}}};
+}
+
+void extractFrustumPlanes(const Matrix4& m, Plane planes[6])
+{
+    // wiersze macierzy (Gribb/Hartmann); głębia 0..1, więc bliska płaszczyzna to sam trzeci wiersz
+    const Vector4 row0 {m[0].x, m[1].x, m[2].x, m[3].x};
+    const Vector4 row1 {m[0].y, m[1].y, m[2].y, m[3].y};
+    const Vector4 row2 {m[0].z, m[1].z, m[2].z, m[3].z};
+    const Vector4 row3 {m[0].w, m[1].w, m[2].w, m[3].w};
+
+    planes[0] = row3 + row0; // lewa
+    planes[1] = row3 - row0; // prawa
+    planes[2] = row3 + row1; // dolna
+    planes[3] = row3 - row1; // górna
+    planes[4] = row2;        // bliska
+    planes[5] = row3 - row2; // daleka
+
+    for(int i = 0; i < 6; i++)
+    {
+        planes[i] = planes[i] * (1.0f / length(planes[i].xyz()));
+    }
+}
+
+void scalar::transformPoints(const Matrix4& m, const Vector3* points, Vector3* result, size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        result[i] = transformPoint(m, points[i]);
+    }
+}
+
+void scalar::cullSpheres(const Plane planes[6], const Sphere* spheres, size_t count, uint8_t* visible)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        bool inside = true;
+        for(int p = 0; p < 6; p++)
+        {
+            inside &= dot(planes[p].xyz(), spheres[i].xyz()) + planes[p].w >= -spheres[i].w;
+        }
+        visible[i] = inside;
+    }
+}
+
+void transformPoints(const Matrix4& m, const Vector3* points, Vector3* result, size_t count)
+{
+    size_t i = 0;
+#if defined(__AVX__)
+    const __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[0].x));
+    const __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[1].x));
+    const __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[2].x));
+    const __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[3].x));
+    for(; i + 2 <= count; i += 2)
+    {
+        const __m256 p = _mm256_loadu_ps(&points[i].x); // dwa Vector3, każdy po 16 bajtów
+        const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0, _mm256_permute_ps(p, 0x00)), _mm256_mul_ps(c1, _mm256_permute_ps(p, 0x55))),
+                                       _mm256_add_ps(_mm256_mul_ps(c2, _mm256_permute_ps(p, 0xaa)), c3));
+        _mm256_storeu_ps(&result[i].x, r);
+    }
+#endif
+#ifdef MATH_SSE
+    const __m128 m0 = _mm_load_ps(&m[0].x);
+    const __m128 m1 = _mm_load_ps(&m[1].x);
+    const __m128 m2 = _mm_load_ps(&m[2].x);
+    const __m128 m3 = _mm_load_ps(&m[3].x);
+    for(; i < count; i++)
+    {
+        const __m128 p = _mm_load_ps(&points[i].x);
+        const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, _mm_shuffle_ps(p, p, 0x00)), _mm_mul_ps(m1, _mm_shuffle_ps(p, p, 0x55))),
+                                    _mm_add_ps(_mm_mul_ps(m2, _mm_shuffle_ps(p, p, 0xaa)), m3));
+        _mm_store_ps(&result[i].x, r); // czwarty element trafia w wypełnienie Vector3
+    }
+#endif
+    scalar::transformPoints(m, points + i, result + i, count - i);
+}
+
+void cullSpheres(const Plane planes[6], const Sphere* spheres, size_t count, uint8_t* visible)
+{
+    size_t i = 0;
+#ifdef MATH_SSE
+    __m128 px[6], py[6], pz[6], pw[6];
+    for(int p = 0; p < 6; p++)
+    {
+        px[p] = _mm_set1_ps(planes[p].x);
+        py[p] = _mm_set1_ps(planes[p].y);
+        pz[p] = _mm_set1_ps(planes[p].z);
+        pw[p] = _mm_set1_ps(planes[p].w);
+    }
+
+    for(; i + 4 <= count; i += 4)
+    {
+        // AoS -> SoA: cztery sfery w rejestrach x, y, z, promień
+        __m128 x = _mm_load_ps(&spheres[i].x);
+        __m128 y = _mm_load_ps(&spheres[i + 1].x);
+        __m128 z = _mm_load_ps(&spheres[i + 2].x);
+        __m128 radius = _mm_load_ps(&spheres[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, radius);
+        const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(int p = 0; p < 6; p++)
+        {
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+                                               _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        visible[i] = mask & 1;
+        visible[i + 1] = (mask >> 1) & 1;
+        visible[i + 2] = (mask >> 2) & 1;
+        visible[i + 3] = (mask >> 3) & 1;
+    }
+#endif
+    scalar::cullSpheres(planes, spheres + i, count - i, visible + i);
+}
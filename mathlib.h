@@ -0,0 +1,222 @@
+#ifndef MATHLIB_H
+#define MATHLIB_H
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATH_SSE 1
+#endif
+
+// Typy mają układ std140: Vector3/Vector4/Quaternion po 16 bajtów z wyrównaniem 16, Matrix4 to 4 kolumny Vector4
+// (column-major, jak mat4 w GLSL). Można je kopiować prosto do uniform/storage/vertex bufferów.
+// Uwaga: w std140 float zaraz po vec3 wchodzi w jego czwarty element, a w C++ Vector3 zawsze zajmuje 16 bajtów.
+
+struct alignas(16) Vector3
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+
+    constexpr Vector3() = default;
+    constexpr Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+    constexpr float operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+    constexpr float& operator[](int i) { return i == 0 ? x : (i == 1 ? y : z); }
+};
+
+struct alignas(16) Vector4
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 0.0f;
+
+    constexpr Vector4() = default;
+    constexpr Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+    constexpr Vector4(const Vector3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    constexpr float operator[](int i) const { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+    constexpr float& operator[](int i) { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+    constexpr Vector3 xyz() const { return {x, y, z}; }
+};
+
+struct alignas(16) Quaternion
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 1.0f;
+
+    constexpr Quaternion() = default;
+    constexpr Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+struct alignas(16) Matrix4
+{
+    Vector4 columns[4];
+
+    static constexpr Matrix4 identity()
+    {
+        return {{{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}}};
+    }
+
+    constexpr const Vector4& operator[](int column) const { return columns[column]; }
+    constexpr Vector4& operator[](int column) { return columns[column]; }
+    const float* data() const { return &columns[0].x; }
+    float* data() { return &columns[0].x; }
+};
+
+static_assert(sizeof(Vector3) == 16 && alignof(Vector3) == 16, "std140 vec3");
+static_assert(sizeof(Vector4) == 16 && alignof(Vector4) == 16, "std140 vec4");
+static_assert(sizeof(Matrix4) == 64 && alignof(Matrix4) == 16, "std140 mat4");
+
+using Plane = Vector4;  // xyz - normalna, w - odległość; punkt p jest po dodatniej stronie, gdy dot(xyz, p) + w >= 0
+using Sphere = Vector4; // xyz - środek, w - promień
+
+/*----------- Vector3 ----------*/
+constexpr Vector3 operator+(const Vector3& a, const Vector3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+constexpr Vector3 operator-(const Vector3& a, const Vector3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+constexpr Vector3 operator-(const Vector3& v) { return {-v.x, -v.y, -v.z}; }
+constexpr Vector3 operator*(const Vector3& v, float s) { return {v.x * s, v.y * s, v.z * s}; }
+constexpr Vector3 operator*(float s, const Vector3& v) { return v * s; }
+constexpr float dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+constexpr Vector3 cross(const Vector3& a, const Vector3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline float length(const Vector3& v) { return std::sqrt(dot(v, v)); }
+inline Vector3 normalize(const Vector3& v) { return v * (1.0f / length(v)); }
+constexpr Vector3 lerp(const Vector3& a, const Vector3& b, float t) { return a + (b - a) * t; }
+
+/*----------- Vector4 ----------*/
+constexpr Vector4 operator+(const Vector4& a, const Vector4& b) { return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}; }
+constexpr Vector4 operator-(const Vector4& a, const Vector4& b) { return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}; }
+constexpr Vector4 operator*(const Vector4& v, float s) { return {v.x * s, v.y * s, v.z * s, v.w * s}; }
+constexpr Vector4 operator*(float s, const Vector4& v) { return v * s; }
+constexpr float dot(const Vector4& a, const Vector4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+/*---------- Quaternion --------*/
+constexpr Quaternion operator*(const Quaternion& a, const Quaternion& b) // najpierw b, potem a
+{
+    return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+constexpr Vector3 rotate(const Quaternion& q, const Vector3& v)
+{
+    const Vector3 u {q.x, q.y, q.z};
+    const Vector3 t = cross(u, v) * 2.0f;
+    return v + t * q.w + cross(u, t);
+}
+
+inline Quaternion fromAxisAngle(const Vector3& axis, float angle) // axis znormalizowana, kąt w radianach
+{
+    const float s = std::sin(angle * 0.5f);
+    return {axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f)};
+}
+
+// interpolacja liniowa z normalizacją - dla bliskich orientacji (kolejne ticki symulacji) prawie jak slerp, bez trygonometrii
+inline Quaternion nlerp(const Quaternion& a, const Quaternion& b, float t)
+{
+    const float sign = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f ? -1.0f : 1.0f; // krótsza droga
+    const float s = 1.0f - t;
+    const float k = t * sign;
+    const Quaternion q {a.x * s + b.x * k, a.y * s + b.y * k, a.z * s + b.z * k, a.w * s + b.w * k};
+    const float inverseLength = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return {q.x * inverseLength, q.y * inverseLength, q.z * inverseLength, q.w * inverseLength};
+}
+
+/*------------ Matrix4 ---------*/
+// macierz T * R * S bez mnożenia macierzy - tak liczymy transformacje lokalne węzłów sceny
+constexpr Matrix4 composeTransform(const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+{
+    const float x = rotation.x;
+    const float y = rotation.y;
+    const float z = rotation.z;
+    const float w = rotation.w;
+
+    return {{{(1.0f - 2.0f * (y * y + z * z)) * scale.x, (2.0f * (x * y + w * z)) * scale.x, (2.0f * (x * z - w * y)) * scale.x, 0.0f},
+             {(2.0f * (x * y - w * z)) * scale.y, (1.0f - 2.0f * (x * x + z * z)) * scale.y, (2.0f * (y * z + w * x)) * scale.y, 0.0f},
+             {(2.0f * (x * z + w * y)) * scale.z, (2.0f * (y * z - w * x)) * scale.z, (1.0f - 2.0f * (x * x + y * y)) * scale.z, 0.0f},
+             {position.x, position.y, position.z, 1.0f}}};
+}
+
+constexpr Matrix4 translation(const Vector3& offset)
+{
+    Matrix4 result = Matrix4::identity();
+    result[3] = Vector4(offset, 1.0f);
+    return result;
+}
+
+Matrix4 perspective(float fovY, float aspect, float nearPlane, float farPlane); // głębia 0..1, oś y do góry (viewport jest odwrócony)
+Matrix4 lookAt(const Vector3& eye, const Vector3& target, const Vector3& up);
+void extractFrustumPlanes(const Matrix4& viewProjection, Plane planes[6]); // znormalizowane, normalne do środka
+
+// Wersje skalarne: constexpr (stałe liczone w czasie kompilacji) i punkt odniesienia dla benchmarków.
+namespace scalar
+{
+    constexpr Vector4 transform(const Matrix4& m, const Vector4& v)
+    {
+        return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3] * v.w;
+    }
+
+    constexpr Vector3 transformPoint(const Matrix4& m, const Vector3& p) // bez dzielenia przez w - dla macierzy afinicznych
+    {
+        return transform(m, Vector4(p, 1.0f)).xyz();
+    }
+
+    constexpr Matrix4 multiply(const Matrix4& a, const Matrix4& b)
+    {
+        return {{transform(a, b[0]), transform(a, b[1]), transform(a, b[2]), transform(a, b[3])}};
+    }
+
+    void transformPoints(const Matrix4& m, const Vector3* points, Vector3* result, size_t count);
+    void cullSpheres(const Plane planes[6], const Sphere* spheres, size_t count, uint8_t* visible);
+}
+
+/*-------- gorące ścieżki ------*/
+inline Vector4 transform(const Matrix4& m, const Vector4& v)
+{
+#ifdef MATH_SSE
+    const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(&m[0].x), _mm_set1_ps(v.x)), _mm_mul_ps(_mm_load_ps(&m[1].x), _mm_set1_ps(v.y))),
+                                _mm_add_ps(_mm_mul_ps(_mm_load_ps(&m[2].x), _mm_set1_ps(v.z)), _mm_mul_ps(_mm_load_ps(&m[3].x), _mm_set1_ps(v.w))));
+    Vector4 result;
+    _mm_store_ps(&result.x, r);
+    return result;
+#else
+    return scalar::transform(m, v);
+#endif
+}
+
+inline Matrix4 multiply(const Matrix4& a, const Matrix4& b)
+{
+#ifdef MATH_SSE
+    const __m128 a0 = _mm_load_ps(&a[0].x);
+    const __m128 a1 = _mm_load_ps(&a[1].x);
+    const __m128 a2 = _mm_load_ps(&a[2].x);
+    const __m128 a3 = _mm_load_ps(&a[3].x);
+
+    Matrix4 result;
+    for(int column = 0; column < 4; column++)
+    {
+        const __m128 bc = _mm_load_ps(&b[column].x);
+        const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, 0x00)), _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, 0x55))),
+                                    _mm_add_ps(_mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, 0xaa)), _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, 0xff))));
+        _mm_store_ps(&result[column].x, r);
+    }
+    return result;
+#else
+    return scalar::multiply(a, b);
+#endif
+}
+
+inline Matrix4 operator*(const Matrix4& a, const Matrix4& b) { return multiply(a, b); }
+inline Vector4 operator*(const Matrix4& m, const Vector4& v) { return transform(m, v); }
+
+// wsadowo: SSE (AVX, jeśli kompilator go włączył - dwa punkty na iterację), result może być równe points
+void transformPoints(const Matrix4& m, const Vector3* points, Vector3* result, size_t count);
+// visible[i] = 1, jeśli sfera i przecina frustum albo jest w środku; SSE - cztery sfery na iterację
+void cullSpheres(const Plane planes[6], const Sphere* spheres, size_t count, uint8_t* visible);
+
+#endif // MATHLIB_H
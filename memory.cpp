@@ -0,0 +1,456 @@
+#include "memory.h"
+#include "log.h"
+#include <algorithm>
+#include <array>
+
+void DeviceMemory::reset()
+{
+    if(mMemory != VK_NULL_HANDLE)
+    {
+        mAllocator->free(mMemory);
+        mMemory = VK_NULL_HANDLE;
+    }
+}
+
+void MemoryAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device, bool memoryBudgetExtension, VkDeviceSize budgetLimit)
+{
+    mDevice = device;
+    mPhysicalDevice = physicalDevice;
+    mMemoryBudgetExtension = memoryBudgetExtension;
+    mBudgetLimit = budgetLimit;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mDeviceMemoryProperties);
+
+    mHeaps.resize(mDeviceMemoryProperties.memoryHeapCount);
+    for(uint32_t i = 0; i < mDeviceMemoryProperties.memoryHeapCount; i++)
+    {
+        mHeaps[i].size = mDeviceMemoryProperties.memoryHeaps[i].size;
+        mHeaps[i].flags = mDeviceMemoryProperties.memoryHeaps[i].flags;
+    }
+    mTypes.resize(mDeviceMemoryProperties.memoryTypeCount);
+    for(uint32_t i = 0; i < mDeviceMemoryProperties.memoryTypeCount; i++)
+    {
+        mTypes[i].flags = mDeviceMemoryProperties.memoryTypes[i].propertyFlags;
+        mTypes[i].heapIndex = mDeviceMemoryProperties.memoryTypes[i].heapIndex;
+    }
+    mAllocatedAtBudgetQuery.assign(mHeaps.size(), 0);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    updateBudget();
+}
+
+uint32_t MemoryAllocator::findMemoryProperties(uint32_t memoryTypeBitsRequirement, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties) const
+{
+    if(preferredProperties != 0)
+    {
+        try
+        {
+            return findMemoryProperties(memoryTypeBitsRequirement, requiredProperties | preferredProperties);
+        }
+        catch(const std::runtime_error&)
+        {
+            // brak typu z preferowanymi flagami - wystarczą wymagane
+        }
+    }
+
+    const uint32_t memoryCount = mDeviceMemoryProperties.memoryTypeCount;
+
+    for(uint32_t memoryIndex = 0; memoryIndex < memoryCount; memoryIndex++)
+    {
+        const uint32_t memoryTypeBits = (1 << memoryIndex);
+        const bool isRequiredMemoryType = memoryTypeBitsRequirement & memoryTypeBits;
+
+        if(isRequiredMemoryType)
+        {
+            const VkMemoryPropertyFlags properties = mDeviceMemoryProperties.memoryTypes[memoryIndex].propertyFlags;
+            const bool hasRequiredProperties = (properties & requiredProperties) == requiredProperties;
+
+            if(isRequiredMemoryType && hasRequiredProperties)
+            {
+                return memoryIndex;
+            }
+        }
+    }
+
+    throw std::runtime_error("failed to find memory type");
+}
+
+VkMemoryPropertyFlags MemoryAllocator::memoryPropertyFlags(uint32_t memoryTypeIndex) const
+{
+    return mDeviceMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+}
+
+DeviceMemory MemoryAllocator::allocate(const VkMemoryRequirements& memoryRequirements, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties)
+{
+    // kandydaci w kolejności sterownika (od najszybszych), najpierw z preferowanymi flagami
+    std::vector<uint32_t> candidates;
+    for(const VkMemoryPropertyFlags properties : {requiredProperties | preferredProperties, requiredProperties})
+    {
+        for(uint32_t memoryIndex = 0; memoryIndex < mDeviceMemoryProperties.memoryTypeCount; memoryIndex++)
+        {
+            const bool isRequiredMemoryType = memoryRequirements.memoryTypeBits & (1 << memoryIndex);
+            const bool hasProperties = (memoryPropertyFlags(memoryIndex) & properties) == properties;
+            if(isRequiredMemoryType && hasProperties && std::find(candidates.begin(), candidates.end(), memoryIndex) == candidates.end())
+            {
+                candidates.push_back(memoryIndex);
+            }
+        }
+    }
+    if(candidates.empty())
+    {
+        throw std::runtime_error("failed to find memory type");
+    }
+
+    // typ na stercie, która ma jeszcze miejsce, wygrywa z szybszym na pełnej - dopiero jak takiego nie ma, coś wyrzucamy
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::stable_partition(candidates.begin(), candidates.end(), [&](uint32_t memoryIndex)
+        {
+            const uint32_t heapIndex = mTypes[memoryIndex].heapIndex;
+            return heapUsage(heapIndex) + memoryRequirements.size <= mHeaps[heapIndex].budget;
+        });
+    }
+
+    for(const uint32_t memoryIndex : candidates)
+    {
+        try
+        {
+            return allocateMemoryType(memoryRequirements.size, memoryIndex);
+        }
+        catch(const std::runtime_error&)
+        {
+            // ta sterta jest pełna mimo wyrzucania - następny typ
+        }
+    }
+    throw std::runtime_error("failed to allocate memory");
+}
+
+DeviceMemory MemoryAllocator::allocateMemoryType(VkDeviceSize size, uint32_t memoryTypeIndex)
+{
+    const uint32_t heapIndex = mTypes[memoryTypeIndex].heapIndex;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        const VkDeviceSize budget = mHeaps[heapIndex].budget;
+        const bool overBudget = heapUsage(heapIndex) + size > budget;
+        lock.unlock();
+        if(overBudget)
+        {
+            evictUntil(heapIndex, budget > size ? budget - size : 0);
+
+            lock.lock();
+            const VkDeviceSize usage = heapUsage(heapIndex) - std::min(heapUsage(heapIndex), mHeaps[heapIndex].releasingBytes);
+            if(usage + size > budget)
+            {
+                // budżet jest miękki - lepiej go chwilę przekroczyć niż wywalić ładowanie, sterownik i tak może odmówić
+                logger::warning("memory heap ", heapIndex, " over budget: ", (usage + size) >> 20, " / ", budget >> 20, " MiB, nothing left to evict");
+            }
+        }
+    }
+
+    VkMemoryAllocateInfo allocateInfo {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext = NULL;
+    allocateInfo.allocationSize = size;
+    allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if(vkAllocateMemory(mDevice, &allocateInfo, NULL, &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate memory");
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    Allocation& allocation = mAllocations[memory];
+    allocation.size = size;
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    mHeaps[heapIndex].allocatedBytes += size;
+    mHeaps[heapIndex].allocationCount++;
+    mTypes[memoryTypeIndex].allocatedBytes += size;
+    mTypes[memoryTypeIndex].allocationCount++;
+    return DeviceMemory(this, memory, memoryTypeIndex);
+}
+
+void MemoryAllocator::free(VkDeviceMemory memory)
+{
+    // najpierw księgowość, dopiero potem vkFreeMemory - zwolniony uchwyt sterownik może od razu oddać
+    // innemu wątkowi (startup alokuje równolegle), a jego wpis nie może zniknąć razem z naszym
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const auto it = mAllocations.find(memory);
+        if(it != mAllocations.end())
+        {
+            const Allocation& allocation = it->second;
+            const uint32_t heapIndex = mTypes[allocation.memoryTypeIndex].heapIndex;
+            mHeaps[heapIndex].allocatedBytes -= allocation.size;
+            mHeaps[heapIndex].allocationCount--;
+            mTypes[allocation.memoryTypeIndex].allocatedBytes -= allocation.size;
+            mTypes[allocation.memoryTypeIndex].allocationCount--;
+            if(allocation.releasing)
+            {
+                mHeaps[heapIndex].releasingBytes -= allocation.size;
+            }
+            if(allocation.evictable != 0)
+            {
+                mEvictables.erase(allocation.evictable); // właściciel zwolnił zasób bez wyrejestrowania
+            }
+            mAllocations.erase(it);
+        }
+        else
+        {
+            logger::error("freeing device memory unknown to the allocator");
+        }
+    }
+    vkFreeMemory(mDevice, memory, NULL);
+}
+
+Buffer MemoryAllocator::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties)
+{
+    VkBufferCreateInfo bufferCreateInfo {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.pNext = NULL;
+    bufferCreateInfo.flags = 0;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = usage;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufferCreateInfo.queueFamilyIndexCount = 0;
+    bufferCreateInfo.pQueueFamilyIndices = NULL;
+
+    Buffer buffer;
+    buffer.size = size;
+
+    VkBuffer vkBuffer = VK_NULL_HANDLE;
+    if(vkCreateBuffer(mDevice, &bufferCreateInfo, NULL, &vkBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create buffer");
+    }
+    buffer.buffer = BufferHandle(mDevice, vkBuffer);
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(mDevice, vkBuffer, &memoryRequirements);
+
+    buffer.memory = allocate(memoryRequirements, requiredProperties, preferredProperties);
+    const VkMemoryPropertyFlags properties = memoryPropertyFlags(buffer.memory.memoryTypeIndex());
+    buffer.hostCoherent = (properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    if(vkBindBufferMemory(mDevice, vkBuffer, buffer.memory, 0) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to bind buffer memory");
+    }
+
+    if(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if(vkMapMemory(mDevice, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to map buffer memory");
+        }
+    }
+
+    return buffer;
+}
+
+void MemoryAllocator::invalidate(const Buffer& buffer) const
+{
+    if(!buffer.hostCoherent)
+    {
+        VkMappedMemoryRange range {};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.pNext = NULL;
+        range.memory = buffer.memory;
+        range.offset = 0;
+        range.size = VK_WHOLE_SIZE;
+        vkInvalidateMappedMemoryRanges(mDevice, 1, &range);
+    }
+}
+
+void MemoryAllocator::flush(const Buffer& buffer) const
+{
+    if(!buffer.hostCoherent)
+    {
+        VkMappedMemoryRange range {};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.pNext = NULL;
+        range.memory = buffer.memory;
+        range.offset = 0;
+        range.size = VK_WHOLE_SIZE;
+        vkFlushMappedMemoryRanges(mDevice, 1, &range);
+    }
+}
+
+EvictableId MemoryAllocator::registerEvictable(VkDeviceMemory memory, std::function<void()> evict)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Allocation& allocation = mAllocations.at(memory);
+    const EvictableId id = mNextEvictableId++;
+
+    Evictable& evictable = mEvictables[id];
+    evictable.memory = memory;
+    evictable.heapIndex = mTypes[allocation.memoryTypeIndex].heapIndex;
+    evictable.lastUsedFrame = mFrame;
+    evictable.evict = std::move(evict);
+    allocation.evictable = id;
+    return id;
+}
+
+void MemoryAllocator::unregisterEvictable(EvictableId id)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto it = mEvictables.find(id);
+    if(it != mEvictables.end())
+    {
+        mAllocations.at(it->second.memory).evictable = 0;
+        mEvictables.erase(it);
+    }
+}
+
+void MemoryAllocator::touch(EvictableId id)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto it = mEvictables.find(id);
+    if(it != mEvictables.end())
+    {
+        it->second.lastUsedFrame = mFrame;
+    }
+}
+
+void MemoryAllocator::beginFrame()
+{
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> targets {}; // co ramkę - bez sterty
+    std::array<bool, VK_MAX_MEMORY_HEAPS> underPressure {};
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFrame++;
+        updateBudget();
+        for(uint32_t heapIndex = 0; heapIndex < mHeaps.size(); heapIndex++)
+        {
+            // wyrzucamy do progu, a nie do samego budżetu - następna alokacja nie musi już nic zwalniać
+            targets[heapIndex] = static_cast<VkDeviceSize>(mHeaps[heapIndex].budget * pressureThreshold);
+            underPressure[heapIndex] = heapUsage(heapIndex) > targets[heapIndex];
+        }
+    }
+
+    for(uint32_t heapIndex = 0; heapIndex < mHeaps.size(); heapIndex++)
+    {
+        if(underPressure[heapIndex])
+        {
+            evictUntil(heapIndex, targets[heapIndex]);
+        }
+    }
+}
+
+MemoryStats MemoryAllocator::stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    MemoryStats stats;
+    stats.heaps = mHeaps;
+    for(uint32_t heapIndex = 0; heapIndex < mHeaps.size(); heapIndex++)
+    {
+        stats.heaps[heapIndex].usage = heapUsage(heapIndex);
+    }
+    stats.types = mTypes;
+    stats.driverBudget = mMemoryBudgetExtension;
+    stats.evictableCount = static_cast<uint32_t>(mEvictables.size());
+    stats.evictionCount = mEvictionCount;
+    stats.evictedBytes = mEvictedBytes;
+    return stats;
+}
+
+void MemoryAllocator::updateBudget()
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    budgetProperties.pNext = NULL;
+
+    if(mMemoryBudgetExtension)
+    {
+        VkPhysicalDeviceMemoryProperties2 memoryProperties {};
+        memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(mPhysicalDevice, &memoryProperties);
+    }
+
+    for(uint32_t heapIndex = 0; heapIndex < mHeaps.size(); heapIndex++)
+    {
+        MemoryHeapStats& heap = mHeaps[heapIndex];
+        if(mMemoryBudgetExtension)
+        {
+            heap.budget = budgetProperties.heapBudget[heapIndex];
+            heap.usage = budgetProperties.heapUsage[heapIndex];
+            mAllocatedAtBudgetQuery[heapIndex] = heap.allocatedBytes;
+        }
+        else
+        {
+            heap.budget = heap.size / 5 * 4; // reszta dla innych procesów i sterownika
+        }
+
+        if(mBudgetLimit != 0 && (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+        {
+            heap.budget = std::min(heap.budget, mBudgetLimit);
+        }
+    }
+}
+
+VkDeviceSize MemoryAllocator::heapUsage(uint32_t heapIndex) const
+{
+    const MemoryHeapStats& heap = mHeaps[heapIndex];
+    if(!mMemoryBudgetExtension)
+    {
+        return heap.allocatedBytes;
+    }
+
+    // sterownik zna też pamięć, o którą nie prosiliśmy wprost (swapchain, pule deskryptorów)
+    const VkDeviceSize allocatedAtQuery = mAllocatedAtBudgetQuery[heapIndex];
+    if(heap.allocatedBytes >= allocatedAtQuery)
+    {
+        return heap.usage + (heap.allocatedBytes - allocatedAtQuery);
+    }
+    const VkDeviceSize freed = allocatedAtQuery - heap.allocatedBytes;
+    return heap.usage > freed ? heap.usage - freed : 0;
+}
+
+bool MemoryAllocator::evictOne(uint32_t heapIndex, VkDeviceSize targetUsage)
+{
+    std::function<void()> evict;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const MemoryHeapStats& heap = mHeaps[heapIndex];
+        if(heapUsage(heapIndex) - std::min(heapUsage(heapIndex), heap.releasingBytes) <= targetUsage)
+        {
+            return false;
+        }
+
+        // najdawniej używany, ale nie z bieżącej ramki - inaczej zasób potrzebny teraz wypadałby co klatkę
+        auto victim = mEvictables.end();
+        for(auto it = mEvictables.begin(); it != mEvictables.end(); ++it)
+        {
+            const Evictable& evictable = it->second;
+            if(evictable.heapIndex == heapIndex && evictable.lastUsedFrame < mFrame &&
+               (victim == mEvictables.end() || evictable.lastUsedFrame < victim->second.lastUsedFrame))
+            {
+                victim = it;
+            }
+        }
+        if(victim == mEvictables.end())
+        {
+            return false;
+        }
+
+        Allocation& allocation = mAllocations.at(victim->second.memory);
+        allocation.releasing = true;
+        allocation.evictable = 0;
+        mHeaps[heapIndex].releasingBytes += allocation.size;
+        mEvictionCount++;
+        mEvictedBytes += allocation.size;
+
+        evict = std::move(victim->second.evict);
+        mEvictables.erase(victim);
+    }
+
+    evict(); // bez blokady - może od razu zwolnić pamięć, czyli wejść do free()
+    return true;
+}
+
+void MemoryAllocator::evictUntil(uint32_t heapIndex, VkDeviceSize targetUsage)
+{
+    while(evictOne(heapIndex, targetUsage))
+    {
+    }
+}
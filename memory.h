@@ -0,0 +1,167 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+#include "vkhandle.h"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class MemoryAllocator;
+
+// Pamięć z MemoryAllocatora - zwolnienie od razu odejmuje ją ze statystyk sterty.
+// Alokator musi żyć dłużej niż wszystkie jego alokacje.
+class DeviceMemory
+{
+public:
+    DeviceMemory() = default;
+    DeviceMemory(MemoryAllocator* allocator, VkDeviceMemory memory, uint32_t memoryTypeIndex)
+        : mAllocator(allocator), mMemory(memory), mMemoryTypeIndex(memoryTypeIndex) {}
+    ~DeviceMemory() { reset(); }
+
+    DeviceMemory(const DeviceMemory&) = delete;
+    DeviceMemory& operator=(const DeviceMemory&) = delete;
+    DeviceMemory(DeviceMemory&& other) noexcept
+        : mAllocator(other.mAllocator), mMemory(std::exchange(other.mMemory, VK_NULL_HANDLE)), mMemoryTypeIndex(other.mMemoryTypeIndex) {}
+    DeviceMemory& operator=(DeviceMemory&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset();
+            mAllocator = other.mAllocator;
+            mMemory = std::exchange(other.mMemory, VK_NULL_HANDLE);
+            mMemoryTypeIndex = other.mMemoryTypeIndex;
+        }
+        return *this;
+    }
+
+    operator VkDeviceMemory() const { return mMemory; }
+    VkDeviceMemory get() const { return mMemory; }
+    uint32_t memoryTypeIndex() const { return mMemoryTypeIndex; }
+    void reset();
+
+private:
+    MemoryAllocator* mAllocator = nullptr;
+    VkDeviceMemory mMemory = VK_NULL_HANDLE;
+    uint32_t mMemoryTypeIndex = 0;
+};
+
+struct Buffer
+{
+    BufferHandle buffer;
+    DeviceMemory memory;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; // pamięć host visible jest mapowana na stałe, vkFreeMemory sama ją odmapowuje
+    bool hostCoherent = true;
+};
+
+struct MemoryHeapStats
+{
+    VkDeviceSize size = 0;
+    VkMemoryHeapFlags flags = 0;
+    VkDeviceSize budget = 0;         // z VK_EXT_memory_budget albo 80% sterty, przycięte do limitu z ustawień
+    VkDeviceSize usage = 0;          // z rozszerzeniem - cały proces według sterownika, bez niego - tylko ten alokator
+    VkDeviceSize allocatedBytes = 0; // przez ten alokator
+    VkDeviceSize releasingBytes = 0; // wyrzucone, ale jeszcze w kolejce usuwania
+    uint32_t allocationCount = 0;
+};
+
+struct MemoryTypeStats
+{
+    VkMemoryPropertyFlags flags = 0;
+    uint32_t heapIndex = 0;
+    VkDeviceSize allocatedBytes = 0;
+    uint32_t allocationCount = 0;
+};
+
+struct MemoryStats
+{
+    std::vector<MemoryHeapStats> heaps;
+    std::vector<MemoryTypeStats> types;
+    bool driverBudget = false; // czy budżet i zużycie są z VK_EXT_memory_budget
+    uint32_t evictableCount = 0;
+    uint64_t evictionCount = 0;
+    VkDeviceSize evictedBytes = 0;
+};
+
+using EvictableId = uint64_t;
+
+class MemoryAllocator
+{
+public:
+    // budgetLimit != 0 - twardy limit dla stert DEVICE_LOCAL (kilka instancji silnika na jednej karcie)
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, bool memoryBudgetExtension, VkDeviceSize budgetLimit = 0);
+
+    // preferredProperties są brane pod uwagę tylko jeśli jakiś typ pamięci je ma, np. HOST_CACHED do odczytu na CPU
+    uint32_t findMemoryProperties(uint32_t memoryTypeBitsRequirement, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties = 0) const;
+    VkMemoryPropertyFlags memoryPropertyFlags(uint32_t memoryTypeIndex) const;
+
+    // wybiera typ, którego sterta mieści się jeszcze w budżecie; w razie potrzeby najpierw wyrzuca zasoby strumieniowane
+    DeviceMemory allocate(const VkMemoryRequirements& memoryRequirements, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties = 0);
+    DeviceMemory allocateMemoryType(VkDeviceSize size, uint32_t memoryTypeIndex);
+    Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties = 0);
+
+    void invalidate(const Buffer& buffer) const; // przed czytaniem na CPU, no-op dla pamięci coherent
+    void flush(const Buffer& buffer) const;      // po pisaniu na CPU
+
+    // Zasoby, które można w każdej chwili odtworzyć (tekstury, poziomy LOD). evict musi oddać pamięć - najlepiej przez
+    // kolejkę usuwania, bo GPU może jej jeszcze używać. Wołane bez blokady alokatora, po nim wpis jest już wyrejestrowany.
+    EvictableId registerEvictable(VkDeviceMemory memory, std::function<void()> evict);
+    void unregisterEvictable(EvictableId id);
+    void touch(EvictableId id); // zasób użyty w tej ramce - LRU
+
+    // Raz na ramkę, po odczekaniu fence'a: odświeża budżet ze sterownika i wyrzuca najdawniej używane zasoby,
+    // jeśli któraś sterta przekroczyła pressureThreshold budżetu.
+    void beginFrame();
+    MemoryStats stats() const;
+
+    static constexpr float pressureThreshold = 0.9f;
+
+private:
+    friend class DeviceMemory;
+
+    struct Allocation
+    {
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+        EvictableId evictable = 0; // 0 - zwykła alokacja
+        bool releasing = false;    // wyrzucona, czeka w kolejce usuwania
+    };
+
+    struct Evictable
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint32_t heapIndex = 0;
+        uint64_t lastUsedFrame = 0;
+        std::function<void()> evict;
+    };
+
+    void free(VkDeviceMemory memory);
+    void updateBudget();                                      // pod mMutex
+    VkDeviceSize heapUsage(uint32_t heapIndex) const;         // pod mMutex
+    bool evictOne(uint32_t heapIndex, VkDeviceSize targetUsage); // false - nie ma już czego wyrzucić
+    void evictUntil(uint32_t heapIndex, VkDeviceSize targetUsage);
+
+    VkDevice mDevice = VK_NULL_HANDLE;
+    VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties mDeviceMemoryProperties = {};
+    bool mMemoryBudgetExtension = false;
+    VkDeviceSize mBudgetLimit = 0;
+
+    // startup tworzy zasoby z kilku wątków naraz, strumieniowanie też nie musi być na wątku renderu
+    mutable std::mutex mMutex;
+    std::unordered_map<VkDeviceMemory, Allocation> mAllocations;
+    std::unordered_map<EvictableId, Evictable> mEvictables; // LRU liniowo - wpisów jest tyle co zasobów, nie alokacji
+    EvictableId mNextEvictableId = 1;
+    uint64_t mFrame = 0;
+
+    std::vector<MemoryHeapStats> mHeaps;
+    std::vector<MemoryTypeStats> mTypes;
+    std::vector<VkDeviceSize> mAllocatedAtBudgetQuery; // usage między zapytaniami = usage sterownika + nasza zmiana od tej pory
+    uint64_t mEvictionCount = 0;
+    VkDeviceSize mEvictedBytes = 0;
+};
+
+#endif // MEMORY_H
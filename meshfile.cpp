@@ -0,0 +1,131 @@
+#include "meshfile.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + meshFileAlignment - 1) / meshFileAlignment * meshFileAlignment;
+    }
+
+    void copyVector(float destination[4], const Vector4& source)
+    {
+        destination[0] = source.x;
+        destination[1] = source.y;
+        destination[2] = source.z;
+        destination[3] = source.w;
+    }
+}
+
+void writeMeshFile(const std::string& path, const MeshData& mesh)
+{
+    // 16-bit indeksy, jeśli wszystkie wierzchołki się mieszczą - połowa pamięci i przepustowości index fetch
+    const uint32_t indexSize = mesh.vertexCount <= 0x10000 ? 2 : 4;
+
+    MeshFileHeader header {};
+    header.magic = meshFileMagic;
+    header.version = meshFileVersion;
+    header.vertexLayout = static_cast<uint32_t>(mesh.layout.type);
+    header.vertexStride = mesh.layout.stride;
+    header.indexSize = indexSize;
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    header.vertexCount = mesh.vertexCount;
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.vertexOffset = alignUp(sizeof(MeshFileHeader));
+    header.indexOffset = alignUp(header.vertexOffset + mesh.vertices.size());
+    header.lodOffset = alignUp(header.indexOffset + uint64_t(mesh.indices.size()) * indexSize);
+    header.fileSize = header.lodOffset + mesh.lods.size() * sizeof(MeshLod);
+    copyVector(header.boundsMin, Vector4(mesh.boundsMin, 0.0f));
+    copyVector(header.boundsMax, Vector4(mesh.boundsMax, 0.0f));
+    copyVector(header.boundingSphere, mesh.boundingSphere);
+    copyVector(header.positionScale, mesh.quantization.scale);
+    copyVector(header.positionOffset, mesh.quantization.offset);
+
+    // cały plik składany w pamięci i zapisywany jednym write - konwerter nie jest wąskim gardłem
+    std::vector<uint8_t> file(header.fileSize, 0);
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + header.vertexOffset, mesh.vertices.data(), mesh.vertices.size());
+    if(indexSize == 2)
+    {
+        uint16_t* indices = reinterpret_cast<uint16_t*>(file.data() + header.indexOffset);
+        for(size_t i = 0; i < mesh.indices.size(); i++)
+        {
+            indices[i] = static_cast<uint16_t>(mesh.indices[i]);
+        }
+    }
+    else
+    {
+        std::memcpy(file.data() + header.indexOffset, mesh.indices.data(), mesh.indices.size() * indexSize);
+    }
+    std::memcpy(file.data() + header.lodOffset, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+
+    std::ofstream output(path, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(file.data()), file.size());
+    if(!output)
+    {
+        throw std::runtime_error("failed to write " + path);
+    }
+}
+
+MeshFile::MeshFile(const std::string& path)
+    : mFile(path)
+{
+    if(mFile.size() < sizeof(MeshFileHeader))
+    {
+        throw std::runtime_error(path + " is not a mesh file");
+    }
+    mHeader = reinterpret_cast<const MeshFileHeader*>(mFile.data());
+
+    if(mHeader->magic != meshFileMagic)
+    {
+        throw std::runtime_error(path + " is not a mesh file");
+    }
+    if(mHeader->version != meshFileVersion)
+    {
+        throw std::runtime_error(path + " has mesh file version " + std::to_string(mHeader->version) + ", expected " + std::to_string(meshFileVersion));
+    }
+    if(mHeader->vertexLayout > static_cast<uint32_t>(VertexLayoutType::CompactHalf) || layout().stride != mHeader->vertexStride)
+    {
+        throw std::runtime_error(path + " has an unknown vertex layout");
+    }
+    if(mHeader->indexSize != 2 && mHeader->indexSize != 4)
+    {
+        throw std::runtime_error(path + " has an invalid index size");
+    }
+
+    const bool aligned = mHeader->vertexOffset % meshFileAlignment == 0 && mHeader->indexOffset % meshFileAlignment == 0 && mHeader->lodOffset % meshFileAlignment == 0;
+    const bool inside = mHeader->fileSize <= mFile.size() && mHeader->vertexOffset + vertexDataSize() <= mHeader->fileSize &&
+                        mHeader->indexOffset + indexDataSize() <= mHeader->fileSize &&
+                        mHeader->lodOffset + uint64_t(mHeader->lodCount) * sizeof(MeshLod) <= mHeader->fileSize;
+    if(!aligned || !inside)
+    {
+        throw std::runtime_error(path + " is truncated or corrupted");
+    }
+
+    if(mHeader->lodCount > maxMeshLodCount)
+    {
+        throw std::runtime_error(path + " has too many LODs");
+    }
+    for(uint32_t lod = 0; lod < mHeader->lodCount; lod++)
+    {
+        if(uint64_t(lods()[lod].firstIndex) + lods()[lod].indexCount > mHeader->indexCount)
+        {
+            throw std::runtime_error(path + " has an LOD outside of the index data");
+        }
+    }
+}
+
+VertexLayout MeshFile::layout() const
+{
+    return VertexLayout::create(static_cast<VertexLayoutType>(mHeader->vertexLayout));
+}
+
+QuantizationParameters MeshFile::quantization() const
+{
+    QuantizationParameters quantization;
+    quantization.scale = {mHeader->positionScale[0], mHeader->positionScale[1], mHeader->positionScale[2], mHeader->positionScale[3]};
+    quantization.offset = {mHeader->positionOffset[0], mHeader->positionOffset[1], mHeader->positionOffset[2], mHeader->positionOffset[3]};
+    return quantization;
+}
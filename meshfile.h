@@ -0,0 +1,84 @@
+#ifndef MESHFILE_H
+#define MESHFILE_H
+#include "mappedfile.h"
+#include "vertexformat.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binarny format siatek: nagłówek, potem strumienie wierzchołków, indeksów i zakresów LOD,
+// każdy od offsetu wyrównanego do meshFileAlignment. Little endian, bez żadnego parsowania przy wczytywaniu.
+constexpr uint32_t meshFileMagic = 0x48534d56; // "VMSH"
+constexpr uint32_t meshFileVersion = 1;
+constexpr uint32_t meshFileAlignment = 64;
+constexpr uint32_t maxMeshLodCount = 8;
+
+struct MeshFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexLayout; // VertexLayoutType
+    uint32_t vertexStride;
+    uint32_t indexSize;    // 2 albo 4 bajty
+    uint32_t lodCount;
+    uint32_t vertexCount;
+    uint32_t indexCount;   // wszystkich LOD-ów razem
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t lodOffset;
+    uint64_t fileSize;
+    float boundsMin[4];
+    float boundsMax[4];
+    float boundingSphere[4]; // środek + promień
+    float positionScale[4];  // QuantizationParameters
+    float positionOffset[4];
+};
+
+static_assert(sizeof(MeshFileHeader) == 144, "mesh file header layout changed - bump meshFileVersion");
+
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;       // błąd uproszczenia względem promienia sfery otaczającej, 0 dla pełnej siatki
+    uint32_t reserved;
+};
+
+// Siatka przygotowana offline (konwerter), gotowa do zapisu.
+struct MeshData
+{
+    VertexLayout layout;
+    QuantizationParameters quantization;
+    std::vector<uint8_t> vertices; // już zakodowane w layout
+    uint32_t vertexCount = 0;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    Vector3 boundsMin;
+    Vector3 boundsMax;
+    Sphere boundingSphere;
+};
+
+void writeMeshFile(const std::string& path, const MeshData& mesh);
+
+// Widok na zmapowany plik - wskaźniki prowadzą prosto do stron pliku.
+class MeshFile
+{
+public:
+    explicit MeshFile(const std::string& path); // rzuca przy złym magic/wersji/rozmiarach
+
+    const MeshFileHeader& header() const { return *mHeader; }
+    VertexLayout layout() const;
+    QuantizationParameters quantization() const;
+
+    const uint8_t* vertexData() const { return mFile.data() + mHeader->vertexOffset; }
+    size_t vertexDataSize() const { return size_t(mHeader->vertexCount) * mHeader->vertexStride; }
+    const uint8_t* indexData() const { return mFile.data() + mHeader->indexOffset; }
+    size_t indexDataSize() const { return size_t(mHeader->indexCount) * mHeader->indexSize; }
+    const MeshLod* lods() const { return reinterpret_cast<const MeshLod*>(mFile.data() + mHeader->lodOffset); }
+
+private:
+    MappedFile mFile;
+    const MeshFileHeader* mHeader = nullptr;
+};
+
+#endif // MESHFILE_H
@@ -0,0 +1,401 @@
+#include "occlusion.h"
+#include "compute.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr uint32_t cullGroupSize = 64;   // local_size_x w cull.comp
+    constexpr uint32_t pyramidGroupSize = 8; // local_size_x/y w depthpyramid.comp
+    constexpr uint32_t minimumCapacity = 1024;
+
+    // układ std140 z cull.comp
+    struct CullUniforms
+    {
+        Matrix4 previousViewProjection;
+        Plane frustumPlanes[6];
+        Sphere boundingSphere;
+        float depthSize[2];
+        uint32_t instanceCount;
+        uint32_t occlusionEnabled;
+        uint32_t pyramidLevels;
+        alignas(16) uint32_t lodOffsets[maxMeshLodCount]; // uvec4[2] w shaderze
+    };
+
+    static_assert(sizeof(CullUniforms) == 240 && maxMeshLodCount == 8, "CullUniforms must match cull.comp");
+
+    struct PyramidConstants
+    {
+        int32_t sourceSize[2];
+        int32_t destinationSize[2];
+    };
+
+    VkDescriptorImageInfo imageInfo(VkSampler sampler, VkImageView view, VkImageLayout layout)
+    {
+        return {sampler, view, layout};
+    }
+}
+
+void OcclusionCuller::create(VkDevice device, MemoryAllocator& allocator, uint32_t frameSlots, uint32_t depthWidth, uint32_t depthHeight,
+                             const std::vector<uint32_t>& pyramidShaderCode, const std::vector<uint32_t>& cullShaderCode)
+{
+    mDevice = device;
+    mAllocator = &allocator;
+    mDepthWidth = depthWidth;
+    mDepthHeight = depthHeight;
+
+    createPyramid();
+    createPipelines(pyramidShaderCode, cullShaderCode);
+    createDescriptors(frameSlots);
+
+    mCommands = allocator.createBuffer(maxMeshLodCount * sizeof(VkDrawIndexedIndirectCommand),
+                                       VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void OcclusionCuller::createPyramid()
+{
+    // poziom 0 ma połowę rozdzielczości głębi, każdy kolejny połowę poprzedniego (w górę), aż do 1x1
+    VkExtent2D extent = {(mDepthWidth + 1) / 2, (mDepthHeight + 1) / 2};
+    mPyramidExtents.clear();
+    while(true)
+    {
+        mPyramidExtents.push_back(extent);
+        if(extent.width == 1 && extent.height == 1)
+        {
+            break;
+        }
+        extent = {(extent.width + 1) / 2, (extent.height + 1) / 2};
+    }
+    mPyramidLevels = mPyramidExtents.size();
+
+    VkImageCreateInfo imageCreateInfo {};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext = NULL;
+    imageCreateInfo.flags = 0;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageCreateInfo.extent = {mPyramidExtents[0].width, mPyramidExtents[0].height, 1};
+    imageCreateInfo.mipLevels = mPyramidLevels;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image = VK_NULL_HANDLE;
+    checkVkResult(vkCreateImage(mDevice, &imageCreateInfo, NULL, &image), "failed to create depth pyramid");
+    mPyramid = ImageHandle(mDevice, image);
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(mDevice, image, &memoryRequirements);
+    mPyramidMemory = mAllocator->allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vkBindImageMemory(mDevice, image, mPyramidMemory, 0);
+
+    VkImageViewCreateInfo viewCreateInfo {};
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = NULL;
+    viewCreateInfo.flags = 0;
+    viewCreateInfo.image = image;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+    viewCreateInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mPyramidLevels, 0, 1};
+
+    VkImageView view = VK_NULL_HANDLE;
+    checkVkResult(vkCreateImageView(mDevice, &viewCreateInfo, NULL, &view), "failed to create depth pyramid view");
+    mPyramidView = ImageViewHandle(mDevice, view);
+
+    mPyramidLevelViews.clear();
+    for(uint32_t level = 0; level < mPyramidLevels; level++)
+    {
+        viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+        checkVkResult(vkCreateImageView(mDevice, &viewCreateInfo, NULL, &view), "failed to create depth pyramid level view");
+        mPyramidLevelViews.emplace_back(mDevice, view);
+    }
+
+    // texelFetch nie filtruje, ale sampler jest wymagany przez combined image sampler
+    VkSamplerCreateInfo samplerCreateInfo {};
+    samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerCreateInfo.pNext = NULL;
+    samplerCreateInfo.flags = 0;
+    samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+    samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+    samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.minLod = 0.0f;
+    samplerCreateInfo.maxLod = float(mPyramidLevels);
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    checkVkResult(vkCreateSampler(mDevice, &samplerCreateInfo, NULL, &sampler), "failed to create depth pyramid sampler");
+    mSampler = SamplerHandle(mDevice, sampler);
+}
+
+void OcclusionCuller::createPipelines(const std::vector<uint32_t>& pyramidShaderCode, const std::vector<uint32_t>& cullShaderCode)
+{
+    mPyramidSetLayout = createComputeSetLayout(mDevice, {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE});
+    mCullSetLayout = createComputeSetLayout(mDevice, {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                               VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER});
+
+    mPyramidPipelineLayout = createComputePipelineLayout(mDevice, mPyramidSetLayout, sizeof(PyramidConstants));
+    mCullPipelineLayout = createComputePipelineLayout(mDevice, mCullSetLayout, 0);
+    mPyramidPipeline = createComputePipeline(mDevice, mPyramidPipelineLayout, pyramidShaderCode);
+    mCullPipeline = createComputePipeline(mDevice, mCullPipelineLayout, cullShaderCode);
+}
+
+void OcclusionCuller::createDescriptors(uint32_t frameSlots)
+{
+    const std::vector<VkDescriptorPoolSize> poolSizes =
+    {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameSlots * (mPyramidLevels + 1)},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, frameSlots * mPyramidLevels},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameSlots},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameSlots * 4},
+    };
+
+    VkDescriptorPoolCreateInfo poolCreateInfo {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = 0;
+    poolCreateInfo.maxSets = frameSlots * (mPyramidLevels + 1);
+    poolCreateInfo.poolSizeCount = poolSizes.size();
+    poolCreateInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    checkVkResult(vkCreateDescriptorPool(mDevice, &poolCreateInfo, NULL, &pool), "failed to create culling descriptor pool");
+    mDescriptorPool = DescriptorPoolHandle(mDevice, pool);
+
+    mSlots.resize(frameSlots);
+    for(Slot& slot : mSlots)
+    {
+        std::vector<VkDescriptorSetLayout> setLayouts(mPyramidLevels + 1, mPyramidSetLayout);
+        setLayouts.back() = mCullSetLayout;
+        std::vector<VkDescriptorSet> sets(setLayouts.size());
+
+        VkDescriptorSetAllocateInfo allocateInfo {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.pNext = NULL;
+        allocateInfo.descriptorPool = pool;
+        allocateInfo.descriptorSetCount = setLayouts.size();
+        allocateInfo.pSetLayouts = setLayouts.data();
+        checkVkResult(vkAllocateDescriptorSets(mDevice, &allocateInfo, sets.data()), "failed to allocate culling descriptor sets");
+
+        slot.cullSet = sets.back();
+        slot.pyramidSets.assign(sets.begin(), sets.end() - 1);
+        slot.uniforms = mAllocator->createBuffer(sizeof(CullUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        // poziomy 1.. czytają poprzedni poziom - to się nie zmienia; poziom 0 czyta głębię, ustawianą co ramkę
+        std::vector<VkDescriptorImageInfo> imageInfos;
+        imageInfos.reserve(mPyramidLevels * 2);
+        std::vector<VkWriteDescriptorSet> writes;
+        for(uint32_t level = 0; level < mPyramidLevels; level++)
+        {
+            if(level > 0)
+            {
+                imageInfos.push_back(imageInfo(mSampler, mPyramidLevelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL));
+                writes.push_back(writeDescriptor(slot.pyramidSets[level], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &imageInfos.back(), NULL));
+            }
+            imageInfos.push_back(imageInfo(VK_NULL_HANDLE, mPyramidLevelViews[level], VK_IMAGE_LAYOUT_GENERAL));
+            writes.push_back(writeDescriptor(slot.pyramidSets[level], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &imageInfos.back(), NULL));
+        }
+        vkUpdateDescriptorSets(mDevice, writes.size(), writes.data(), 0, NULL);
+    }
+}
+
+void OcclusionCuller::reserve(uint32_t instanceCount, uint32_t frameSlot, DeletionQueue& deletionQueue)
+{
+    Slot& slot = mSlots[frameSlot];
+    const VkDeviceSize lodsSize = VkDeviceSize(std::max(instanceCount, minimumCapacity)) * sizeof(uint32_t);
+    if(slot.lods.size < lodsSize)
+    {
+        if(slot.lods.buffer != VK_NULL_HANDLE)
+        {
+            deletionQueue.retire(frameSlot, std::move(slot.lods));
+        }
+        slot.lods = mAllocator->createBuffer(std::max(lodsSize, VkDeviceSize(mCapacity) * sizeof(uint32_t)), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+
+    if(instanceCount <= mCapacity)
+    {
+        return;
+    }
+
+    uint32_t capacity = std::max(mCapacity * 2, minimumCapacity);
+    while(capacity < instanceCount)
+    {
+        capacity *= 2;
+    }
+
+    // poprzednia ramka może jeszcze rysować ze starego bufora
+    if(mVisible.buffer != VK_NULL_HANDLE)
+    {
+        deletionQueue.retire(frameSlot, std::move(mVisible));
+    }
+    mVisible = mAllocator->createBuffer(VkDeviceSize(capacity) * sizeof(Matrix4), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    mCapacity = capacity;
+}
+
+void OcclusionCuller::record(VkCommandBuffer cmdBuff, uint32_t frameSlot, const CullInput& input, DeletionQueue& deletionQueue)
+{
+    if(input.instanceCount == 0)
+    {
+        mPreviousViewProjection = input.viewProjection;
+        return; // nic do rysowania, render() nie woła draw()
+    }
+
+    reserve(input.instanceCount, frameSlot, deletionQueue);
+    Slot& slot = mSlots[frameSlot];
+
+    CullUniforms uniforms {};
+    uniforms.previousViewProjection = mPreviousViewProjection;
+    extractFrustumPlanes(input.viewProjection, uniforms.frustumPlanes);
+    uniforms.boundingSphere = input.boundingSphere;
+    uniforms.depthSize[0] = float(mDepthWidth);
+    uniforms.depthSize[1] = float(mDepthHeight);
+    uniforms.instanceCount = input.instanceCount;
+    uniforms.occlusionEnabled = input.previousDepth != VK_NULL_HANDLE;
+    uniforms.pyramidLevels = mPyramidLevels;
+    std::memcpy(slot.lods.mapped, input.lods, size_t(input.instanceCount) * sizeof(uint32_t));
+    mAllocator->flush(slot.lods);
+    mPreviousViewProjection = input.viewProjection;
+
+    // każdy LOD dostaje w buforze widocznych instancji zakres o rozmiarze swojej liczby instancji;
+    // firstInstance w komendach zostaje 0 (bez drawIndirectFirstInstance), zakres wybiera offset bufora w draw()
+    std::array<VkDrawIndexedIndirectCommand, maxMeshLodCount> commands {};
+    mLodCount = input.meshLods->size();
+    uint32_t offset = 0;
+    for(uint32_t lod = 0; lod < mLodCount; lod++)
+    {
+        commands[lod].indexCount = (*input.meshLods)[lod].indexCount;
+        commands[lod].instanceCount = 0;
+        commands[lod].firstIndex = (*input.meshLods)[lod].firstIndex;
+        commands[lod].vertexOffset = 0;
+        commands[lod].firstInstance = 0;
+        mLodOffsets[lod] = offset;
+        mLodInstanceCounts[lod] = input.lodInstanceCounts[lod];
+        uniforms.lodOffsets[lod] = offset;
+        offset += input.lodInstanceCounts[lod];
+    }
+    std::memcpy(slot.uniforms.mapped, &uniforms, sizeof(uniforms));
+    mAllocator->flush(slot.uniforms);
+
+    // poprzednia ramka: rysowanie z bufora widocznych instancji i komend, zapis głębi, którą zaraz czytamy
+    VkMemoryBarrier previousFrame {};
+    previousFrame.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    previousFrame.pNext = NULL;
+    previousFrame.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    previousFrame.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &previousFrame, 0, NULL, 0, NULL);
+
+    vkCmdUpdateBuffer(cmdBuff, mCommands.buffer, 0, commands.size() * sizeof(VkDrawIndexedIndirectCommand), commands.data());
+
+    if(input.previousDepth != VK_NULL_HANDLE)
+    {
+        buildPyramid(cmdBuff, slot, input.previousDepth);
+    }
+
+    // pyramida, komendy i rekordy instancji (kopiowane przez InstanceBuffer) gotowe dla testu
+    const VkDescriptorBufferInfo uniformInfo {slot.uniforms.buffer, 0, sizeof(CullUniforms)};
+    const VkDescriptorBufferInfo instancesInfo {input.instances, 0, VK_WHOLE_SIZE};
+    const VkDescriptorBufferInfo lodsInfo {slot.lods.buffer, 0, VK_WHOLE_SIZE};
+    const VkDescriptorBufferInfo visibleInfo {mVisible.buffer, 0, VK_WHOLE_SIZE};
+    const VkDescriptorBufferInfo commandsInfo {mCommands.buffer, 0, VK_WHOLE_SIZE};
+    const VkDescriptorImageInfo pyramidInfo = imageInfo(mSampler, mPyramidView, VK_IMAGE_LAYOUT_GENERAL);
+    const std::vector<VkWriteDescriptorSet> writes =
+    {
+        writeDescriptor(slot.cullSet, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, NULL, &uniformInfo),
+        writeDescriptor(slot.cullSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &instancesInfo),
+        writeDescriptor(slot.cullSet, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &lodsInfo),
+        writeDescriptor(slot.cullSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &visibleInfo),
+        writeDescriptor(slot.cullSet, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &commandsInfo),
+        writeDescriptor(slot.cullSet, 5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &pyramidInfo, NULL),
+    };
+    vkUpdateDescriptorSets(mDevice, writes.size(), writes.data(), 0, NULL);
+
+    VkMemoryBarrier toCull {};
+    toCull.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    toCull.pNext = NULL;
+    toCull.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    toCull.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &toCull, 0, NULL, 0, NULL);
+
+    vkCmdBindPipeline(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline);
+    vkCmdBindDescriptorSets(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipelineLayout, 0, 1, &slot.cullSet, 0, NULL);
+    vkCmdDispatch(cmdBuff, groupCount(input.instanceCount, cullGroupSize), 1, 1);
+
+    VkMemoryBarrier toDraw {};
+    toDraw.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    toDraw.pNext = NULL;
+    toDraw.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    toDraw.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &toDraw, 0, NULL, 0, NULL);
+}
+
+void OcclusionCuller::buildPyramid(VkCommandBuffer cmdBuff, Slot& slot, VkImageView previousDepth)
+{
+    const VkDescriptorImageInfo depthInfo = imageInfo(mSampler, previousDepth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+    const VkWriteDescriptorSet depthWrite = writeDescriptor(slot.pyramidSets[0], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &depthInfo, NULL);
+    vkUpdateDescriptorSets(mDevice, 1, &depthWrite, 0, NULL);
+
+    // poprzednia zawartość niepotrzebna - cała piramida jest liczona od nowa
+    VkImageMemoryBarrier toGeneral {};
+    toGeneral.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toGeneral.pNext = NULL;
+    toGeneral.srcAccessMask = 0;
+    toGeneral.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    toGeneral.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toGeneral.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    toGeneral.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toGeneral.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toGeneral.image = mPyramid;
+    toGeneral.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mPyramidLevels, 0, 1};
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &toGeneral);
+
+    vkCmdBindPipeline(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, mPyramidPipeline);
+
+    VkMemoryBarrier levelBarrier {};
+    levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    levelBarrier.pNext = NULL;
+    levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    for(uint32_t level = 0; level < mPyramidLevels; level++)
+    {
+        const VkExtent2D source = level == 0 ? VkExtent2D{mDepthWidth, mDepthHeight} : mPyramidExtents[level - 1];
+        const VkExtent2D destination = mPyramidExtents[level];
+        const PyramidConstants constants = {{int32_t(source.width), int32_t(source.height)}, {int32_t(destination.width), int32_t(destination.height)}};
+
+        vkCmdBindDescriptorSets(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, mPyramidPipelineLayout, 0, 1, &slot.pyramidSets[level], 0, NULL);
+        vkCmdPushConstants(cmdBuff, mPyramidPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(cmdBuff, groupCount(destination.width, pyramidGroupSize), groupCount(destination.height, pyramidGroupSize), 1);
+
+        // następny poziom czyta ten
+        vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelBarrier, 0, NULL, 0, NULL);
+    }
+}
+
+void OcclusionCuller::draw(VkCommandBuffer cmdBuff, uint32_t instanceBinding) const
+{
+    for(uint32_t lod = 0; lod < mLodCount; lod++)
+    {
+        if(mLodInstanceCounts[lod] > 0) // pusty LOD na pewno nie ma widocznych instancji
+        {
+            const VkBuffer buffer = mVisible.buffer;
+            const VkDeviceSize offset = VkDeviceSize(mLodOffsets[lod]) * sizeof(Matrix4);
+            vkCmdBindVertexBuffers(cmdBuff, instanceBinding, 1, &buffer, &offset);
+            vkCmdDrawIndexedIndirect(cmdBuff, mCommands.buffer, lod * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+#include "deletionqueue.h"
+#include "mathlib.h"
+#include "memory.h"
+#include "meshfile.h"
+#include <cstdint>
+#include <vector>
+
+struct CullInput
+{
+    VkBuffer instances = VK_NULL_HANDLE; // rekordy InstanceData, w kolejności Scene::instances()
+    uint32_t instanceCount = 0;
+    const uint32_t* lods = nullptr;      // LOD każdej instancji (LodSelector)
+    const uint32_t* lodInstanceCounts = nullptr;
+    const std::vector<MeshLod>* meshLods = nullptr;
+    Sphere boundingSphere;
+    Matrix4 viewProjection;
+    VkImageView previousDepth = VK_NULL_HANDLE; // głębia poprzedniej ramki w DEPTH_STENCIL_READ_ONLY_OPTIMAL, albo brak
+};
+
+// Culling instancji na GPU przed renderpassem: piramida Hi-Z z głębi poprzedniej ramki i test sfer
+// instancji (frustum + okluzja). Widoczne instancje trafiają do własnego bufora, po jednej komendzie
+// indirect na LOD (bez drawIndirectFirstInstance), więc render() nie zna liczby widocznych instancji - rysuje przez draw().
+// Pierwsza ramka (i każda bez poprzedniej głębi) ma tylko frustum culling. Obiekt odsłonięty w tej
+// ramce może się pojawić z jedną ramką opóźnienia - test widzi tylko to, co było narysowane wcześniej.
+class OcclusionCuller
+{
+public:
+    void create(VkDevice device, MemoryAllocator& allocator, uint32_t frameSlots, uint32_t depthWidth, uint32_t depthHeight,
+                const std::vector<uint32_t>& pyramidShaderCode, const std::vector<uint32_t>& cullShaderCode);
+
+    // poza renderpassem, po uploadzie instancji (transfer) - bariery do compute i do draw indirect są w środku
+    void record(VkCommandBuffer cmdBuff, uint32_t frameSlot, const CullInput& input, DeletionQueue& deletionQueue);
+    // w renderpassie, z podpiętym pipeline'em, buforem wierzchołków i indeksów siatki;
+    // instanceBinding - binding vertex inputu z macierzami instancji
+    void draw(VkCommandBuffer cmdBuff, uint32_t instanceBinding) const;
+
+    uint32_t pyramidLevels() const { return mPyramidLevels; }
+
+private:
+    struct Slot
+    {
+        Buffer uniforms;
+        Buffer lods;
+        VkDescriptorSet cullSet = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> pyramidSets; // jeden na poziom
+    };
+
+    void createPyramid();
+    void createPipelines(const std::vector<uint32_t>& pyramidShaderCode, const std::vector<uint32_t>& cullShaderCode);
+    void createDescriptors(uint32_t frameSlots);
+    void reserve(uint32_t instanceCount, uint32_t frameSlot, DeletionQueue& deletionQueue);
+    void buildPyramid(VkCommandBuffer cmdBuff, Slot& slot, VkImageView previousDepth);
+
+    VkDevice mDevice = VK_NULL_HANDLE;
+    MemoryAllocator* mAllocator = nullptr;
+    uint32_t mDepthWidth = 0;
+    uint32_t mDepthHeight = 0;
+
+    ImageHandle mPyramid;
+    DeviceMemory mPyramidMemory;
+    ImageViewHandle mPyramidView; // wszystkie poziomy, do testu
+    std::vector<ImageViewHandle> mPyramidLevelViews;
+    std::vector<VkExtent2D> mPyramidExtents;
+    uint32_t mPyramidLevels = 0;
+    SamplerHandle mSampler;
+
+    DescriptorSetLayoutHandle mPyramidSetLayout;
+    DescriptorSetLayoutHandle mCullSetLayout;
+    DescriptorPoolHandle mDescriptorPool;
+    PipelineLayoutHandle mPyramidPipelineLayout;
+    PipelineLayoutHandle mCullPipelineLayout;
+    PipelineHandle mPyramidPipeline;
+    PipelineHandle mCullPipeline;
+
+    Buffer mVisible;  // skompaktowane macierze widocznych instancji, binding 1 w draw
+    Buffer mCommands; // VkDrawIndexedIndirectCommand na każdy LOD
+    uint32_t mCapacity = 0;
+    std::vector<Slot> mSlots;
+    Matrix4 mPreviousViewProjection;
+    uint32_t mLodCount = 0; // z ostatniego record()
+    uint32_t mLodOffsets[maxMeshLodCount] = {};
+    uint32_t mLodInstanceCounts[maxMeshLodCount] = {};
+};
+
+#endif // OCCLUSION_H
@@ -0,0 +1,61 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+#include "memory.h"
+#include "occlusion.h"
+#include "vkhandle.h"
+#include "window.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Jedno wyjście obrazu: okno, jego powierzchnia, swapchain i głębia. Urządzenie, kolejka, renderpass,
+// pipeline i command buffery są wspólne - wszystkie wyjścia idą jednym submitem i jednym vkQueuePresentKHR.
+// Kolejność pól = odwrotna kolejność niszczenia: swapchain przed powierzchnią, powierzchnia przed oknem.
+struct Output
+{
+    std::string name; // prefiks nazw obiektów w debug utils
+
+    /*---- surface and window -----*/
+    std::unique_ptr<Window> window;
+    SurfaceHandle surface;
+    VkSurfaceCapabilitiesKHR surfaceCapabilities = {};
+    VkColorSpaceKHR colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+
+    /*- swapchain and image views -*/
+    uint32_t swapchainImageCount = 0;
+    SwapchainHandle swapchain;
+    std::vector<VkImage> swapchainImages; // należą do swapchaina
+    std::vector<ImageViewHandle> imageViews;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool resized = false;  // Resize z okna albo SUBOPTIMAL/OUT_OF_DATE z present - swapchain do odtworzenia przed acquire
+    bool readable = false; // czy obrazy mają TRANSFER_SRC - nie każda powierzchnia na to pozwala
+
+    /*------- depth image/view -----*/
+    std::vector<DeviceMemory> depthMemory;
+    std::vector<ImageHandle> depthImages;
+    std::vector<ImageViewHandle> depthImageViews;
+
+    /*--- offscreen color (dynamic resolution) ---*/
+    // scena rysuje się do lewego górnego rogu w renderExtent, potem blit na cały obraz swapchaina
+    std::vector<DeviceMemory> colorMemory;
+    std::vector<ImageHandle> colorImages;
+    std::vector<ImageViewHandle> colorImageViews;
+    VkExtent2D renderExtent = {}; // ustawiane co ramkę; bez dynamicznej rozdzielczości = width x height
+
+    /*-------- framebuffer ---------*/
+    std::vector<FramebufferHandle> framebuffers;
+
+    /*------- per frame slot -------*/
+    std::vector<SemaphoreHandle> acquireSemaphores;
+    uint32_t imageIndex = 0; // obraz pobrany w bieżącej ramce
+    bool acquired = false;   // false - w tej ramce wyjście nie ma obrazu (zminimalizowane) i jest pomijane
+    std::vector<VkCommandBuffer> drawCommandBuffers; // wtórne z zawartością renderpassu (tryb cache), zwalniane z pulą
+    std::vector<uint64_t> drawVersions;              // wersja stanu, z którą każdy był nagrany
+
+    /*--------- occlusion ----------*/
+    OcclusionCuller occlusionCuller; // piramida jest z głębi tego wyjścia
+    uint32_t previousImageIndex = UINT32_MAX;
+};
+
+#endif // OUTPUT_H
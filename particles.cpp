@@ -0,0 +1,351 @@
+#include "particles.h"
+#include "compute.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+namespace
+{
+    constexpr float particleLifetime = 4.0f; // najdłuższy, w sekundach
+    constexpr float particleSize = 0.05f;    // połowa boku quada w jednostkach świata
+
+    // push constanty particles.comp
+    struct SimulationConstants
+    {
+        Vector4 emitter; // xyz - pozycja, w - prędkość rozrzutu w poziomie
+        Vector4 gravity; // xyz - przyspieszenie, w - najdłuższy czas życia
+        float deltaTime;
+        uint32_t particleCount;
+        uint32_t frame;
+        uint32_t initialize;
+    };
+
+    // push constanty particle.vert
+    struct ParticleDrawConstants
+    {
+        Matrix4 viewProjection;
+        Vector4 cameraRight; // w - połowa boku quada
+        Vector4 cameraUp;
+    };
+}
+
+void ParticleSystem::create(VkDevice device, MemoryAllocator& allocator, VkRenderPass renderPass, VkPipelineCache pipelineCache, uint32_t particleCount,
+                            uint32_t frameSlots, uint32_t timestampValidBits, float timestampPeriod, const std::vector<uint32_t>& simulationShaderCode,
+                            const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode)
+{
+    mDevice = device;
+    mRenderPass = renderPass;
+    mPipelineCache = pipelineCache;
+    mParticleCount = particleCount;
+
+    // TRANSFER_DST tylko dla vkCmdFillBuffer na starcie
+    mParticles = allocator.createBuffer(VkDeviceSize(particleCount) * sizeof(Particle),
+                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    createSimulationPipeline(simulationShaderCode);
+    createDrawPipeline(vertexShaderCode, fragmentShaderCode);
+
+    if(timestampValidBits > 0)
+    {
+        VkQueryPoolCreateInfo queryPoolCreateInfo {};
+        queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.pNext = NULL;
+        queryPoolCreateInfo.flags = 0;
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount = frameSlots * 2;
+
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        checkVkResult(vkCreateQueryPool(device, &queryPoolCreateInfo, NULL, &queryPool), "failed to create particle query pool");
+        mQueryPool = QueryPoolHandle(device, queryPool);
+        mTimestampMask = timestampValidBits >= 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+        mTimestampPeriod = timestampPeriod;
+    }
+    mQueriesWritten.assign(frameSlots, false);
+}
+
+void ParticleSystem::createSimulationPipeline(const std::vector<uint32_t>& shaderCode)
+{
+    mSetLayout = createComputeSetLayout(mDevice, {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER});
+    mSimulationPipelineLayout = createComputePipelineLayout(mDevice, mSetLayout, sizeof(SimulationConstants));
+    mSimulationPipeline = buildSimulationPipeline(shaderCode);
+
+    const VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
+    VkDescriptorPoolCreateInfo poolCreateInfo {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.pNext = NULL;
+    poolCreateInfo.flags = 0;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = 1;
+    poolCreateInfo.pPoolSizes = &poolSize;
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    checkVkResult(vkCreateDescriptorPool(mDevice, &poolCreateInfo, NULL, &pool), "failed to create particle descriptor pool");
+    mDescriptorPool = DescriptorPoolHandle(mDevice, pool);
+
+    const VkDescriptorSetLayout setLayout = mSetLayout;
+    VkDescriptorSetAllocateInfo allocateInfo {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext = NULL;
+    allocateInfo.descriptorPool = pool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &setLayout;
+    checkVkResult(vkAllocateDescriptorSets(mDevice, &allocateInfo, &mDescriptorSet), "failed to allocate particle descriptor set");
+
+    const VkDescriptorBufferInfo particlesInfo {mParticles.buffer, 0, VK_WHOLE_SIZE};
+    const VkWriteDescriptorSet write = writeDescriptor(mDescriptorSet, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &particlesInfo);
+    vkUpdateDescriptorSets(mDevice, 1, &write, 0, NULL);
+}
+
+PipelineHandle ParticleSystem::buildSimulationPipeline(const std::vector<uint32_t>& shaderCode) const
+{
+    return createComputePipeline(mDevice, mSimulationPipelineLayout, shaderCode, mPipelineCache);
+}
+
+void ParticleSystem::createDrawPipeline(const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode)
+{
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ParticleDrawConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = NULL;
+    pipelineLayoutCreateInfo.flags = 0;
+    pipelineLayoutCreateInfo.setLayoutCount = 0;
+    pipelineLayoutCreateInfo.pSetLayouts = NULL;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    checkVkResult(vkCreatePipelineLayout(mDevice, &pipelineLayoutCreateInfo, NULL, &pipelineLayout), "failed to create particle pipeline layout");
+    mDrawPipelineLayout = PipelineLayoutHandle(mDevice, pipelineLayout);
+    mDrawPipeline = buildDrawPipeline(vertexShaderCode, fragmentShaderCode);
+}
+
+PipelineHandle ParticleSystem::buildDrawPipeline(const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode) const
+{
+    const ShaderModuleHandle vertexShaderModule = createShaderModule(mDevice, vertexShaderCode);
+    const ShaderModuleHandle fragmentShaderModule = createShaderModule(mDevice, fragmentShaderCode);
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStageCreateInfos {};
+    for(VkPipelineShaderStageCreateInfo& stage : shaderStageCreateInfos)
+    {
+        stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stage.pNext = NULL;
+        stage.flags = 0;
+        stage.pName = "main";
+        stage.pSpecializationInfo = NULL;
+    }
+    shaderStageCreateInfos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStageCreateInfos[0].module = vertexShaderModule;
+    shaderStageCreateInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStageCreateInfos[1].module = fragmentShaderModule;
+
+    // bufor symulacji jako binding instancji - wierzchołki quada liczy shader z gl_VertexIndex
+    VkVertexInputBindingDescription bindingDescription {};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = sizeof(Particle);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions {};
+    attributeDescriptions[0] = {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Particle, positionLife)};
+    attributeDescriptions[1] = {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Particle, velocity)};
+
+    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo {};
+    vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputCreateInfo.pNext = NULL;
+    vertexInputCreateInfo.flags = 0;
+    vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
+    vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputCreateInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+    vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo {};
+    inputAssemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssemblyCreateInfo.pNext = NULL;
+    inputAssemblyCreateInfo.flags = 0;
+    inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineViewportStateCreateInfo viewportStateCreateInfo {};
+    viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportStateCreateInfo.pNext = NULL;
+    viewportStateCreateInfo.flags = 0;
+    viewportStateCreateInfo.viewportCount = 1;
+    viewportStateCreateInfo.scissorCount = 1;
+
+    const std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo {};
+    dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateCreateInfo.pNext = NULL;
+    dynamicStateCreateInfo.flags = 0;
+    dynamicStateCreateInfo.dynamicStateCount = dynamicStates.size();
+    dynamicStateCreateInfo.pDynamicStates = dynamicStates.data();
+
+    VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo {};
+    rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizationStateCreateInfo.pNext = NULL;
+    rasterizationStateCreateInfo.flags = 0;
+    rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
+    rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizationStateCreateInfo.lineWidth = 1;
+
+    VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo {};
+    multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampleStateCreateInfo.pNext = NULL;
+    multisampleStateCreateInfo.flags = 0;
+    multisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // test z głębią sceny, ale bez zapisu - addytywne cząsteczki nie zasłaniają się nawzajem, kolejność nie ma znaczenia
+    VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo {};
+    depthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilStateCreateInfo.pNext = NULL;
+    depthStencilStateCreateInfo.flags = 0;
+    depthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
+    depthStencilStateCreateInfo.depthWriteEnable = VK_FALSE;
+    depthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachmentState {};
+    colorBlendAttachmentState.blendEnable = VK_TRUE;
+    colorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo {};
+    colorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlendStateCreateInfo.pNext = NULL;
+    colorBlendStateCreateInfo.flags = 0;
+    colorBlendStateCreateInfo.logicOpEnable = VK_FALSE;
+    colorBlendStateCreateInfo.attachmentCount = 1;
+    colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
+
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo {};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.pNext = NULL;
+    pipelineCreateInfo.flags = 0;
+    pipelineCreateInfo.stageCount = shaderStageCreateInfos.size();
+    pipelineCreateInfo.pStages = shaderStageCreateInfos.data();
+    pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;
+    pipelineCreateInfo.pInputAssemblyState = &inputAssemblyCreateInfo;
+    pipelineCreateInfo.pTessellationState = NULL;
+    pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+    pipelineCreateInfo.pRasterizationState = &rasterizationStateCreateInfo;
+    pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
+    pipelineCreateInfo.pDepthStencilState = &depthStencilStateCreateInfo;
+    pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
+    pipelineCreateInfo.layout = mDrawPipelineLayout;
+    pipelineCreateInfo.renderPass = mRenderPass;
+    pipelineCreateInfo.subpass = 0;
+    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineCreateInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    checkVkResult(vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineCreateInfo, NULL, &pipeline), "failed to create particle pipeline");
+    return PipelineHandle(mDevice, pipeline);
+}
+
+void ParticleSystem::collect(uint32_t frameSlot)
+{
+    mSimulationMilliseconds = 0;
+    if(mQueryPool == VK_NULL_HANDLE || !mQueriesWritten[frameSlot])
+    {
+        return;
+    }
+
+    std::array<uint64_t, 4> results = {}; // para (wartość, dostępność) na znacznik
+    const VkResult res = vkGetQueryPoolResults(mDevice, mQueryPool, frameSlot * 2, 2, sizeof(results), results.data(), 2 * sizeof(uint64_t),
+                                               VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if((res == VK_SUCCESS || res == VK_NOT_READY) && results[1] != 0 && results[3] != 0)
+    {
+        const uint64_t ticks = (results[2] - results[0]) & mTimestampMask;
+        mSimulationMilliseconds = double(ticks) * mTimestampPeriod * 1e-6;
+    }
+}
+
+void ParticleSystem::record(VkCommandBuffer cmdBuff, uint32_t frameSlot, float deltaTime)
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+
+    VkMemoryBarrier toSimulation {};
+    toSimulation.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    toSimulation.pNext = NULL;
+    if(!mInitialized)
+    {
+        vkCmdFillBuffer(cmdBuff, mParticles.buffer, 0, VK_WHOLE_SIZE, 0);
+        toSimulation.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+    // poprzednia ramka jeszcze może czytać pozycje jako atrybuty - zapis musi poczekać na vertex input
+    toSimulation.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &toSimulation, 0, NULL, 0, NULL);
+
+    if(mQueryPool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(cmdBuff, mQueryPool, frameSlot * 2, 2);
+        vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, frameSlot * 2);
+    }
+
+    SimulationConstants constants {};
+    constants.emitter = {0.0f, 1.0f, 0.0f, 3.0f};
+    constants.gravity = {0.0f, -9.81f, 0.0f, particleLifetime};
+    constants.deltaTime = std::min(deltaTime, 0.1f); // po przycięciu okna albo pauzie w debuggerze nie wystrzelą w kosmos
+    constants.particleCount = mParticleCount;
+    constants.frame = mFrame++;
+    constants.initialize = mInitialized ? 0 : 1;
+    mInitialized = true;
+
+    vkCmdBindPipeline(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, mSimulationPipeline);
+    vkCmdBindDescriptorSets(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, mSimulationPipelineLayout, 0, 1, &mDescriptorSet, 0, NULL);
+    vkCmdPushConstants(cmdBuff, mSimulationPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(cmdBuff, groupCount(mParticleCount, groupSize), 1, 1);
+
+    if(mQueryPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, mQueryPool, frameSlot * 2 + 1);
+        mQueriesWritten[frameSlot] = true;
+    }
+
+    VkMemoryBarrier toDraw {};
+    toDraw.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    toDraw.pNext = NULL;
+    toDraw.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    toDraw.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &toDraw, 0, NULL, 0, NULL);
+}
+
+void ParticleSystem::draw(VkCommandBuffer cmdBuff, const Matrix4& viewProjection, const Camera& camera) const
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+
+    // quady zwrócone do kamery - te same osie co w lookAt
+    const Vector3 forward = normalize(camera.target - camera.position);
+    const Vector3 right = normalize(cross(forward, Vector3{0.0f, 1.0f, 0.0f}));
+    const Vector3 up = cross(right, forward);
+
+    ParticleDrawConstants constants;
+    constants.viewProjection = viewProjection;
+    constants.cameraRight = {right.x, right.y, right.z, particleSize};
+    constants.cameraUp = {up.x, up.y, up.z, 0.0f};
+
+    vkCmdBindPipeline(cmdBuff, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawPipeline);
+    vkCmdPushConstants(cmdBuff, mDrawPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+    const VkBuffer buffer = mParticles.buffer;
+    const VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(cmdBuff, 0, 1, &buffer, &offset);
+    vkCmdDraw(cmdBuff, 4, mParticleCount, 0, 0);
+}
@@ -0,0 +1,77 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+#include "mathlib.h"
+#include "memory.h"
+#include "scene.h"
+#include "vkhandle.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// układ std430 z particles.comp, a zarazem atrybuty instancji w particle.vert
+struct Particle
+{
+    Vector4 positionLife; // xyz - pozycja, w - pozostały czas życia w sekundach
+    Vector4 velocity;
+};
+
+static_assert(sizeof(Particle) == 32, "Particle must match particles.comp");
+
+// Cząsteczki żyją wyłącznie na GPU: compute przesuwa je w miejscu w jednym buforze, a ten sam bufor jest
+// podpięty jako vertex buffer instancji - jeden quad (triangle strip, 4 wierzchołki) na cząsteczkę.
+// CPU nie czyta ani nie pisze ich stanu; zero na starcie robi vkCmdFillBuffer, a shader rozrzuca je po emiterze.
+// Czas dispatchu mierzą znaczniki czasu, czytane po odczekaniu fence'a slotu.
+class ParticleSystem
+{
+public:
+    static constexpr uint32_t groupSize = 256; // local_size_x w particles.comp
+
+    // timestampValidBits == 0 - bez pomiaru czasu symulacji
+    void create(VkDevice device, MemoryAllocator& allocator, VkRenderPass renderPass, VkPipelineCache pipelineCache, uint32_t particleCount,
+                uint32_t frameSlots, uint32_t timestampValidBits, float timestampPeriod, const std::vector<uint32_t>& simulationShaderCode,
+                const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode);
+    bool isEnabled() const { return mParticleCount > 0; }
+    uint32_t particleCount() const { return mParticleCount; }
+
+    void collect(uint32_t frameSlot); // po vkWaitForFences slotu
+    void record(VkCommandBuffer cmdBuff, uint32_t frameSlot, float deltaTime); // przed renderpassem
+    void draw(VkCommandBuffer cmdBuff, const Matrix4& viewProjection, const Camera& camera) const; // w renderpassie, viewport ustawiony
+
+    // czas dispatchu ramki odebranej ostatnim collect(); 0 - brak wyniku
+    double simulationMilliseconds() const { return mSimulationMilliseconds; }
+
+    // przeładowanie shaderów: build* można wołać z dowolnego wątku (layouty się nie zmieniają),
+    // replace* tylko między ramkami na wątku renderu - zwracają stary pipeline do kolejki usuwania
+    PipelineHandle buildSimulationPipeline(const std::vector<uint32_t>& shaderCode) const;
+    PipelineHandle buildDrawPipeline(const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode) const;
+    PipelineHandle replaceSimulationPipeline(PipelineHandle pipeline) { return std::exchange(mSimulationPipeline, std::move(pipeline)); }
+    PipelineHandle replaceDrawPipeline(PipelineHandle pipeline) { return std::exchange(mDrawPipeline, std::move(pipeline)); }
+
+private:
+    void createSimulationPipeline(const std::vector<uint32_t>& shaderCode);
+    void createDrawPipeline(const std::vector<uint32_t>& vertexShaderCode, const std::vector<uint32_t>& fragmentShaderCode);
+
+    VkDevice mDevice = VK_NULL_HANDLE;
+    VkRenderPass mRenderPass = VK_NULL_HANDLE;
+    VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+    uint32_t mParticleCount = 0;
+    Buffer mParticles;
+    bool mInitialized = false; // pierwszy record() zeruje bufor i rozrzuca wiek cząsteczek
+    uint32_t mFrame = 0;       // ziarno losowania w shaderze
+
+    DescriptorSetLayoutHandle mSetLayout;
+    DescriptorPoolHandle mDescriptorPool;
+    VkDescriptorSet mDescriptorSet = VK_NULL_HANDLE; // bufor się nie zmienia, jeden zestaw dla wszystkich slotów
+    PipelineLayoutHandle mSimulationPipelineLayout;
+    PipelineHandle mSimulationPipeline;
+    PipelineLayoutHandle mDrawPipelineLayout;
+    PipelineHandle mDrawPipeline;
+
+    QueryPoolHandle mQueryPool; // para znaczników na slot
+    std::vector<bool> mQueriesWritten;
+    uint64_t mTimestampMask = 0;
+    double mTimestampPeriod = 1.0; // ns na tick
+    double mSimulationMilliseconds = 0;
+};
+
+#endif // PARTICLES_H
@@ -0,0 +1,189 @@
+#include "readback.h"
+
+namespace
+{
+    // rozmiar teksela formatów, które powierzchnie zgłaszają dla swapchaina; 0 - nieobsługiwany (np. skompresowany)
+    uint32_t formatSize(VkFormat format)
+    {
+        switch(format)
+        {
+        case VK_FORMAT_R4G4B4A4_UNORM_PACK16:
+        case VK_FORMAT_B4G4R4A4_UNORM_PACK16:
+        case VK_FORMAT_R5G6B5_UNORM_PACK16:
+        case VK_FORMAT_B5G6R5_UNORM_PACK16:
+        case VK_FORMAT_R5G5B5A1_UNORM_PACK16:
+        case VK_FORMAT_B5G5R5A1_UNORM_PACK16:
+        case VK_FORMAT_A1R5G5B5_UNORM_PACK16:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+        case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+        case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R16G16B16A16_SFLOAT: // swapchainy HDR
+            return 8;
+        default:
+            return 0;
+        }
+    }
+}
+
+bool FrameReadback::create(MemoryAllocator& allocator, uint32_t frameSlots, uint32_t width, uint32_t height, VkFormat format)
+{
+    if(!mSlots.empty())
+    {
+        return true; // bufory mogą być jeszcze w użyciu przez GPU
+    }
+    if(formatSize(format) == 0)
+    {
+        return false;
+    }
+
+    mAllocator = &allocator;
+    mWidth = width;
+    mHeight = height;
+    mFormat = format;
+    mBytesPerPixel = formatSize(format);
+
+    mSlots.resize(frameSlots);
+    createBuffers();
+    return true;
+}
+
+void FrameReadback::createBuffers()
+{
+    for(auto& slot : mSlots)
+    {
+        // HOST_CACHED, bo CPU czyta cały obraz - odczyt z pamięci write-combined jest wielokrotnie wolniejszy
+        slot.buffer = mAllocator->createBuffer(VkDeviceSize(mWidth) * mHeight * mBytesPerPixel, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    }
+}
+
+void FrameReadback::resize(uint32_t width, uint32_t height)
+{
+    if(mSlots.empty() || (width == mWidth && height == mHeight))
+    {
+        return;
+    }
+    flush(); // kopie w starym rozmiarze idą jeszcze do callbacku
+    mWidth = width;
+    mHeight = height;
+    createBuffers();
+}
+
+void FrameReadback::setCallback(ReadbackCallback callback, uint32_t interval)
+{
+    mCallback = std::move(callback);
+    mInterval = interval > 0 ? interval : 1;
+}
+
+bool FrameReadback::isEnabled() const
+{
+    return mCallback != nullptr && !mSlots.empty();
+}
+
+void FrameReadback::collect(uint32_t frameSlot)
+{
+    if(frameSlot < mSlots.size() && mSlots[frameSlot].pending)
+    {
+        deliver(mSlots[frameSlot]);
+    }
+}
+
+bool FrameReadback::record(VkCommandBuffer cmdBuff, uint32_t frameSlot, VkImage image, uint64_t frameNumber)
+{
+    if(!isEnabled() || frameNumber % mInterval != 0)
+    {
+        return false;
+    }
+
+    Slot& slot = mSlots[frameSlot];
+
+    VkImageMemoryBarrier toTransfer {};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.pNext = NULL;
+    toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT; // renderpass albo blit z dynamicznej rozdzielczości
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = image;
+    toTransfer.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &toTransfer);
+
+    VkBufferImageCopy region {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0; // ciasno upakowane
+    region.bufferImageHeight = 0;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {mWidth, mHeight, 1};
+
+    vkCmdCopyImageToBuffer(cmdBuff, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer.buffer, 1, &region);
+
+    VkImageMemoryBarrier toPresent = toTransfer;
+    toPresent.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toPresent.dstAccessMask = 0; // prezentacja jest zsynchronizowana semaforem
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkBufferMemoryBarrier toHost {};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.pNext = NULL;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = slot.buffer.buffer;
+    toHost.offset = 0;
+    toHost.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &toHost, 1, &toPresent);
+
+    slot.pending = true;
+    slot.frameNumber = frameNumber;
+    return true;
+}
+
+void FrameReadback::flush()
+{
+    for(auto& slot : mSlots)
+    {
+        if(slot.pending)
+        {
+            deliver(slot);
+        }
+    }
+}
+
+void FrameReadback::deliver(Slot& slot)
+{
+    slot.pending = false;
+    if(mCallback == nullptr)
+    {
+        return;
+    }
+
+    mAllocator->invalidate(slot.buffer);
+
+    ReadbackFrame frame;
+    frame.pixels = static_cast<const uint8_t*>(slot.buffer.mapped);
+    frame.width = mWidth;
+    frame.height = mHeight;
+    frame.rowPitch = mWidth * mBytesPerPixel;
+    frame.format = mFormat;
+    frame.frameNumber = slot.frameNumber;
+    mCallback(frame);
+}
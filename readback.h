@@ -0,0 +1,57 @@
+#ifndef READBACK_H
+#define READBACK_H
+#include "memory.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct ReadbackFrame
+{
+    const uint8_t* pixels = nullptr; // ważne tylko w trakcie callbacku - bufor wraca potem do pierścienia
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rowPitch = 0;           // w bajtach
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint64_t frameNumber = 0;
+};
+
+using ReadbackCallback = std::function<void(const ReadbackFrame&)>;
+
+// Kopiuje końcowy obraz swapchaina do pierścienia buforów host visible (jeden na slot ramki)
+// i oddaje je do callbacku, gdy fence slotu zostanie odczekany - render nigdy nie czeka na readback.
+class FrameReadback
+{
+public:
+    // false - format, którego rozmiaru piksela nie znamy; readback zostaje wyłączony
+    bool create(MemoryAllocator& allocator, uint32_t frameSlots, uint32_t width, uint32_t height, VkFormat format);
+    void setCallback(ReadbackCallback callback, uint32_t interval);
+    bool isEnabled() const;
+
+    void collect(uint32_t frameSlot); // po vkWaitForFences slotu
+    // po renderpassie, obraz w PRESENT_SRC_KHR; zwraca false, jeśli ta ramka nie jest kopiowana
+    bool record(VkCommandBuffer cmdBuff, uint32_t frameSlot, VkImage image, uint64_t frameNumber);
+    void flush(); // po vkDeviceWaitIdle - oddaje wszystko, co zostało w pierścieniu
+    void resize(uint32_t width, uint32_t height); // po vkDeviceWaitIdle, gdy swapchain zmienił rozmiar; no-op bez create()
+
+private:
+    struct Slot
+    {
+        Buffer buffer;
+        bool pending = false;
+        uint64_t frameNumber = 0;
+    };
+
+    void createBuffers(); // na mWidth x mHeight, dla każdego slotu
+    void deliver(Slot& slot);
+
+    MemoryAllocator* mAllocator = nullptr;
+    std::vector<Slot> mSlots;
+    ReadbackCallback mCallback;
+    uint32_t mInterval = 1; // co która ramka
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    VkFormat mFormat = VK_FORMAT_UNDEFINED;
+    uint32_t mBytesPerPixel = 0; // z mFormat
+};
+
+#endif // READBACK_H
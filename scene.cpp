@@ -0,0 +1,250 @@
+#include "scene.h"
+#include "commandlog.h"
+
+Matrix4 Camera::viewProjection(float aspect) const
+{
+    return multiply(perspective(fovY, aspect, nearPlane, farPlane), lookAt(position, target, {0.0f, 1.0f, 0.0f}));
+}
+
+Entity Scene::createNode(const LocalTransform& transform, Entity parent)
+{
+    const Entity entity = mRegistry.create(transform, WorldTransform{Matrix4::identity()}, SceneNode{});
+    attach(entity, parent);
+    if(mRecorder != nullptr)
+    {
+        mRecorder->createNode(entity, parent, transform);
+    }
+    return entity;
+}
+
+Entity Scene::createInstance(const LocalTransform& transform, Entity parent)
+{
+    const uint32_t instance = static_cast<uint32_t>(mInstances.size());
+    const Entity entity = mRegistry.create(transform, WorldTransform{Matrix4::identity()}, SceneNode{}, Renderable{instance});
+
+    mInstances.push_back(InstanceData{Matrix4::identity()});
+    mInstanceOwners.push_back(entity);
+    mInstanceChangeEpoch.push_back(0);
+    attach(entity, parent);
+    if(mRecorder != nullptr)
+    {
+        mRecorder->createInstance(entity, parent, transform);
+    }
+    return entity;
+}
+
+void Scene::destroy(Entity entity)
+{
+    if(mRecorder != nullptr)
+    {
+        mRecorder->destroy(entity);
+    }
+    unlink(entity);
+
+    mUpdateStack.clear();
+    mUpdateStack.push_back(entity);
+    while(!mUpdateStack.empty())
+    {
+        const Entity current = mUpdateStack.back();
+        mUpdateStack.pop_back();
+
+        for(Entity child = mRegistry.get<SceneNode>(current)->firstChild; child.valid(); child = mRegistry.get<SceneNode>(child)->nextSibling)
+        {
+            mUpdateStack.push_back(child);
+        }
+
+        if(const Renderable* renderable = mRegistry.get<Renderable>(current))
+        {
+            releaseInstance(renderable->instance);
+        }
+        mRegistry.destroy(current);
+    }
+}
+
+void Scene::setParent(Entity entity, Entity parent)
+{
+    if(mRecorder != nullptr)
+    {
+        mRecorder->setParent(entity, parent);
+    }
+    unlink(entity);
+    if(parent.valid())
+    {
+        link(entity, parent);
+    }
+    markDirty(entity);
+}
+
+void Scene::setLocalTransform(Entity entity, const LocalTransform& transform)
+{
+    *mRegistry.get<LocalTransform>(entity) = transform;
+    markDirty(entity);
+    if(mRecorder != nullptr)
+    {
+        mRecorder->setLocalTransform(entity, transform);
+    }
+}
+
+const LocalTransform& Scene::localTransform(Entity entity)
+{
+    return *mRegistry.get<LocalTransform>(entity);
+}
+
+const Matrix4& Scene::worldMatrix(Entity entity)
+{
+    return mRegistry.get<WorldTransform>(entity)->matrix;
+}
+
+void Scene::updateTransforms()
+{
+    mUpdatedNodeCount = 0;
+
+    for(const Entity entity : mDirtyNodes)
+    {
+        // usunięty, już przeliczony razem z przodkiem albo przodek jest dalej na liście i zrobi to sam
+        if(!mRegistry.alive(entity) || !mRegistry.get<SceneNode>(entity)->dirty || hasDirtyAncestor(entity))
+        {
+            continue;
+        }
+        updateSubtree(entity);
+    }
+    mDirtyNodes.clear();
+}
+
+void Scene::clearChanges()
+{
+    mChangedInstances.clear();
+    mChangeEpoch++;
+}
+
+void Scene::attach(Entity entity, Entity parent)
+{
+    if(parent.valid())
+    {
+        link(entity, parent);
+    }
+    markDirty(entity); // rekord instancji trafi na listę zmian przy pierwszym updateTransforms()
+}
+
+void Scene::markDirty(Entity entity)
+{
+    SceneNode* node = mRegistry.get<SceneNode>(entity);
+    if(!node->dirty)
+    {
+        node->dirty = true;
+        mDirtyNodes.push_back(entity);
+    }
+}
+
+void Scene::markInstanceChanged(uint32_t instance)
+{
+    if(mInstanceChangeEpoch[instance] != mChangeEpoch)
+    {
+        mInstanceChangeEpoch[instance] = mChangeEpoch;
+        mChangedInstances.push_back(instance);
+    }
+}
+
+void Scene::releaseInstance(uint32_t instance)
+{
+    // ostatni rekord wskakuje na zwolnione miejsce - bufor instancji zostaje ciągły
+    const uint32_t last = static_cast<uint32_t>(mInstances.size() - 1);
+    if(instance != last)
+    {
+        mInstances[instance] = mInstances[last];
+        mInstanceOwners[instance] = mInstanceOwners[last];
+        mRegistry.get<Renderable>(mInstanceOwners[instance])->instance = instance;
+        mInstanceChangeEpoch[instance] = 0;
+        markInstanceChanged(instance);
+    }
+
+    mInstances.pop_back();
+    mInstanceOwners.pop_back();
+    mInstanceChangeEpoch.pop_back();
+}
+
+void Scene::link(Entity entity, Entity parent)
+{
+    SceneNode* node = mRegistry.get<SceneNode>(entity);
+    SceneNode* parentNode = mRegistry.get<SceneNode>(parent);
+
+    node->parent = parent;
+    node->previousSibling = Entity{};
+    node->nextSibling = parentNode->firstChild;
+    if(parentNode->firstChild.valid())
+    {
+        mRegistry.get<SceneNode>(parentNode->firstChild)->previousSibling = entity;
+    }
+    parentNode->firstChild = entity;
+}
+
+void Scene::unlink(Entity entity)
+{
+    SceneNode* node = mRegistry.get<SceneNode>(entity);
+    if(!node->parent.valid())
+    {
+        return;
+    }
+
+    if(node->previousSibling.valid())
+    {
+        mRegistry.get<SceneNode>(node->previousSibling)->nextSibling = node->nextSibling;
+    }
+    else
+    {
+        mRegistry.get<SceneNode>(node->parent)->firstChild = node->nextSibling;
+    }
+    if(node->nextSibling.valid())
+    {
+        mRegistry.get<SceneNode>(node->nextSibling)->previousSibling = node->previousSibling;
+    }
+
+    node->parent = Entity{};
+    node->nextSibling = Entity{};
+    node->previousSibling = Entity{};
+}
+
+bool Scene::hasDirtyAncestor(Entity entity)
+{
+    for(Entity parent = mRegistry.get<SceneNode>(entity)->parent; parent.valid(); parent = mRegistry.get<SceneNode>(parent)->parent)
+    {
+        if(mRegistry.get<SceneNode>(parent)->dirty)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scene::updateSubtree(Entity root)
+{
+    mUpdateStack.clear();
+    mUpdateStack.push_back(root);
+
+    while(!mUpdateStack.empty())
+    {
+        const Entity entity = mUpdateStack.back();
+        mUpdateStack.pop_back();
+
+        SceneNode* node = mRegistry.get<SceneNode>(entity);
+        Matrix4& world = mRegistry.get<WorldTransform>(entity)->matrix;
+        const LocalTransform& transform = *mRegistry.get<LocalTransform>(entity);
+        const Matrix4 local = composeTransform(transform.position, transform.rotation, transform.scale);
+
+        // rodzic jest zawsze przeliczony wcześniej (DFS od korzenia) albo nie był brudny
+        world = node->parent.valid() ? multiply(mRegistry.get<WorldTransform>(node->parent)->matrix, local) : local;
+        node->dirty = false;
+        mUpdatedNodeCount++;
+
+        if(const Renderable* renderable = mRegistry.get<Renderable>(entity))
+        {
+            mInstances[renderable->instance].model = world;
+            markInstanceChanged(renderable->instance);
+        }
+
+        for(Entity child = node->firstChild; child.valid(); child = mRegistry.get<SceneNode>(child)->nextSibling)
+        {
+            mUpdateStack.push_back(child);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef SCENE_H
+#define SCENE_H
+#include "ecs.h"
+#include "mathlib.h"
+#include <cstdint>
+#include <vector>
+
+class CommandRecorder;
+
+/*--------- komponenty ---------*/
+struct LocalTransform
+{
+    Vector3 position {0.0f, 0.0f, 0.0f};
+    Quaternion rotation;
+    Vector3 scale {1.0f, 1.0f, 1.0f};
+};
+
+struct WorldTransform
+{
+    Matrix4 matrix;
+};
+
+struct SceneNode
+{
+    Entity parent;
+    Entity firstChild;
+    Entity nextSibling;
+    Entity previousSibling;
+    bool dirty = false;
+};
+
+struct Renderable
+{
+    uint32_t instance = 0; // indeks rekordu w Scene::instances() i w buforze instancji na GPU
+};
+
+// rekord instancji na GPU - binding 1 pipeline'u, VK_VERTEX_INPUT_RATE_INSTANCE
+struct InstanceData
+{
+    Matrix4 model;
+};
+
+struct Camera
+{
+    Vector3 position {0.0f, 0.0f, 5.0f};
+    Vector3 target {0.0f, 0.0f, 0.0f};
+    float fovY = 1.0472f; // 60 stopni
+    float nearPlane = 0.1f;
+    float farPlane = 1000.0f;
+
+    Matrix4 viewProjection(float aspect) const;
+};
+
+// Scena na ECS: hierarchia transformacji przeliczana tylko dla brudnych poddrzew
+// i lista zmienionych rekordów instancji, z której korzysta upload na GPU.
+class Scene
+{
+public:
+    Entity createNode(const LocalTransform& transform = LocalTransform{}, Entity parent = Entity{});
+    Entity createInstance(const LocalTransform& transform = LocalTransform{}, Entity parent = Entity{}); // węzeł + rekord instancji
+    void destroy(Entity entity); // razem z całym poddrzewem
+
+    void setParent(Entity entity, Entity parent);
+    void setLocalTransform(Entity entity, const LocalTransform& transform);
+    const LocalTransform& localTransform(Entity entity);
+    const Matrix4& worldMatrix(Entity entity); // aktualne dopiero po updateTransforms()
+
+    void updateTransforms(); // koszt proporcjonalny do liczby węzłów w brudnych poddrzewach
+    size_t lastUpdatedNodeCount() const { return mUpdatedNodeCount; }
+
+    size_t instanceCount() const { return mInstances.size(); }
+    const std::vector<InstanceData>& instances() const { return mInstances; }
+    // indeksy rekordów zmienionych od ostatniego clearChanges(), bez powtórzeń; mogą wskazywać poza instanceCount()
+    // po usunięciu instancji - takie należy pominąć
+    const std::vector<uint32_t>& changedInstances() const { return mChangedInstances; }
+    void clearChanges();
+
+    Camera& camera() { return mCamera; }
+    const Camera& camera() const { return mCamera; }
+    Registry& registry() { return mRegistry; }
+    void setRecorder(CommandRecorder* recorder) { mRecorder = recorder; } // operacje na scenie trafiają też do nagrania; nullptr - wyłącza
+
+private:
+    void attach(Entity entity, Entity parent);
+    void markDirty(Entity entity);
+    void markInstanceChanged(uint32_t instance);
+    void releaseInstance(uint32_t instance);
+    void link(Entity entity, Entity parent);
+    void unlink(Entity entity);
+    bool hasDirtyAncestor(Entity entity);
+    void updateSubtree(Entity root);
+
+    Registry mRegistry;
+    Camera mCamera;
+    CommandRecorder* mRecorder = nullptr;
+
+    std::vector<Entity> mDirtyNodes;  // korzenie do przeliczenia, mogą się powtarzać z poddrzewami - patrz hasDirtyAncestor
+    std::vector<Entity> mUpdateStack; // trzymany między klatkami, żeby nie alokować w updateTransforms
+    size_t mUpdatedNodeCount = 0;
+
+    std::vector<InstanceData> mInstances;
+    std::vector<Entity> mInstanceOwners;
+    std::vector<uint32_t> mInstanceChangeEpoch; // == mChangeEpoch -> rekord już jest na liście zmian
+    std::vector<uint32_t> mChangedInstances;
+    uint32_t mChangeEpoch = 1;
+};
+
+#endif // SCENE_H
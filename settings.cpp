@@ -0,0 +1,13 @@
+#include "settings.h"
+
+const char* profileName(Profile profile)
+{
+    switch(profile)
+    {
+    case Profile::Debug:
+        return "debug";
+    case Profile::Release:
+        return "release";
+    }
+    return "";
+}
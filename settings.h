@@ -0,0 +1,36 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+#include "vertexformat.h"
+#include <string>
+#include <vector>
+
+enum class Profile
+{
+    Debug,   // warstwa walidacji + messenger VK_EXT_debug_utils + nazwy obiektów
+    Release  // bez warstw i bez rozszerzeń debugowych
+};
+
+struct EngineSettings
+{
+#ifdef ENGINE_DEBUG
+    Profile profile = Profile::Debug;
+#else
+    Profile profile = Profile::Release;
+#endif
+    bool vsync = true; // false - MAILBOX/IMMEDIATE, jeśli powierzchnia je wspiera (np. do benchmarków)
+    VertexLayoutType vertexLayout = VertexLayoutType::Compact;
+    std::string meshPath; // plik z mesh_convertera; pusty - sześcian demo
+    bool occlusionCulling = true; // culling instancji na GPU (frustum + Hi-Z z głębi poprzedniej ramki)
+    uint32_t outputCount = 1; // okna renderujące scenę z jednego urządzenia, jednym submitem i presentem; pierwsze jest główne
+    bool cacheCommandBuffers = false; // nagrane bufory są wysyłane ponownie, dopóki scena i kamera stoją (np. dashboardy)
+    uint32_t memoryBudget = 0; // MiB na stertę DEVICE_LOCAL; 0 - tylko budżet sterownika
+    uint32_t particleCount = 0; // cząsteczki symulowane w compute i rysowane z tego samego bufora; 0 - wyłączone
+    std::vector<std::string> texturePaths; // pliki z texture_convertera, strumieniowane w tle
+    uint32_t textureUploadBudget = 8; // MiB wysyłane do tekstur w jednej ramce
+    bool watchShaders = false; // pliki .spv w shaders/ obserwowane w tle, zmienione pipeline'y przebudowywane bez restartu
+    float dynamicResolutionTarget = 0; // ms GPU na ramkę - scena w mniejszej rozdzielczości, gdy nie mieści się w budżecie; 0 - stała rozdzielczość
+};
+
+const char* profileName(Profile profile);
+
+#endif // SETTINGS_H
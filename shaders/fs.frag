@@ -1,8 +1,13 @@
 #version 450
 
+layout(location = 0) in vec4 inColor;
+layout(location = 1) in vec3 inNormal;
+
 layout(location = 0) out vec4 outColor;
 
 void main()
 {
-	outColor = vec4(1.0f, 0.0f, 0.0f, 1.0f);
+	const vec3 lightDirection = normalize(vec3(0.4f, 1.0f, 0.6f));
+	float diffuse = max(dot(normalize(inNormal), lightDirection), 0.0f);
+	outColor = vec4(inColor.rgb * (0.3f + 0.7f * diffuse), inColor.a);
 }
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in vec3 inColor;
+layout(location = 1) in vec2 inCorner;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	float falloff = max(1.0f - dot(inCorner, inCorner), 0.0f); // okrągła plamka zamiast kwadratu
+	outColor = vec4(inColor * falloff, 0.0f); // blending addytywny
+}
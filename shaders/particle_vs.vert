@@ -0,0 +1,29 @@
+#version 450
+
+// Quad zwrócony do kamery na każdą cząsteczkę: atrybuty instancji to wprost bufor symulacji,
+// rogi quada z gl_VertexIndex (triangle strip, 4 wierzchołki).
+
+layout(location = 0) in vec4 inPositionLife;
+layout(location = 1) in vec4 inVelocity;
+
+layout(push_constant) uniform ParticleDrawConstants
+{
+	mat4 viewProjection;
+	vec4 cameraRight; // w - połowa boku quada
+	vec4 cameraUp;
+} constants;
+
+layout(location = 0) out vec3 outColor;
+layout(location = 1) out vec2 outCorner;
+
+void main()
+{
+	vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1) * 2.0f - 1.0f;
+	vec3 offset = (constants.cameraRight.xyz * corner.x + constants.cameraUp.xyz * corner.y) * constants.cameraRight.w;
+	gl_Position = constants.viewProjection * vec4(inPositionLife.xyz + offset, 1.0f);
+
+	// szybkie jasne, wolne czerwone; gasną w ostatniej sekundzie życia
+	float heat = clamp(length(inVelocity.xyz) * 0.1f, 0.0f, 1.0f);
+	outColor = mix(vec3(0.8f, 0.15f, 0.02f), vec3(1.0f, 0.85f, 0.4f), heat) * clamp(inPositionLife.w, 0.0f, 1.0f) * 0.5f;
+	outCorner = corner;
+}
@@ -1,9 +1,33 @@
 #version 450
 
-layout(location = 0) in vec3 inPosition; //loc0 - 16B, in-input, vec3 - wektor, position - nazwa
-layout(location = 1) in vec4 inColor;
+layout(location = 0) in vec3 inPosition; // skwantyzowana - format z VertexLayout, dekodowana przez scale/offset
+layout(location = 1) in vec2 inNormal;   // octahedral
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in mat4 inModel;    // per instancja, zajmuje lokacje 3-6
+
+layout(push_constant) uniform DrawConstants
+{
+	mat4 viewProjection;
+	vec4 positionScale;
+	vec4 positionOffset;
+} constants;
+
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out vec3 outNormal;
+
+vec3 decodeNormal(vec2 e)
+{
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
 
 void main()
 {
-	gl_Position = vec4(inPosition, 1.0f);
+	vec3 position = inPosition * constants.positionScale.xyz + constants.positionOffset.xyz;
+	gl_Position = constants.viewProjection * inModel * vec4(position, 1.0f);
+	outNormal = mat3(inModel) * decodeNormal(inNormal); // skala instancji jednorodna - bez macierzy normalnych
+	outColor = inColor;
 }
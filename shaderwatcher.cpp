@@ -0,0 +1,151 @@
+#include "shaderwatcher.h"
+#include "log.h"
+#include "trace.h"
+#include <algorithm>
+
+#if(_WIN32)
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    bool isShaderFile(const std::string& fileName)
+    {
+        return fileName.size() > 4 && fileName.compare(fileName.size() - 4, 4, ".spv") == 0;
+    }
+}
+
+bool ShaderWatcher::start(const std::string& directory, Callback callback)
+{
+    stop();
+    mDirectory = directory;
+    mCallback = std::move(callback);
+
+#if(_WIN32)
+    std::error_code error;
+    mWriteTimes.clear();
+    for(const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        mWriteTimes[entry.path().filename().string()] = entry.last_write_time(error);
+    }
+    if(error)
+    {
+        logger::warning("cannot watch ", directory, ": ", error.message());
+        return false;
+    }
+#else
+    mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(mInotify < 0 || inotify_add_watch(mInotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        logger::warning("cannot watch ", directory, " with inotify");
+        if(mInotify >= 0)
+        {
+            close(mInotify);
+            mInotify = -1;
+        }
+        return false;
+    }
+#endif
+
+    mStopping = false;
+    mThread = std::thread(&ShaderWatcher::loop, this);
+    logger::info("watching ", directory, " for shader changes");
+    return true;
+}
+
+void ShaderWatcher::stop()
+{
+    if(mThread.joinable())
+    {
+        mStopping = true;
+        mThread.join();
+    }
+#if(_WIN32)
+#else
+    if(mInotify >= 0)
+    {
+        close(mInotify); // zamyka też wszystkie watch'e
+        mInotify = -1;
+    }
+#endif
+}
+
+void ShaderWatcher::loop()
+{
+    trace::setThreadName("shader watcher");
+    std::vector<std::string> fileNames;
+    while(!mStopping.load(std::memory_order_relaxed))
+    {
+        if(!waitForChanges(fileNames, pollInterval))
+        {
+            continue;
+        }
+        while(waitForChanges(fileNames, settleTime))
+        {
+            // zbieramy, dopóki kompilator jeszcze pisze
+        }
+
+        std::sort(fileNames.begin(), fileNames.end());
+        fileNames.erase(std::unique(fileNames.begin(), fileNames.end()), fileNames.end());
+        mCallback(fileNames);
+        fileNames.clear();
+    }
+}
+
+#if(_WIN32)
+
+bool ShaderWatcher::waitForChanges(std::vector<std::string>& fileNames, std::chrono::milliseconds timeout)
+{
+    std::this_thread::sleep_for(timeout);
+
+    bool changed = false;
+    std::error_code error;
+    for(const auto& entry : std::filesystem::directory_iterator(mDirectory, error))
+    {
+        const std::string fileName = entry.path().filename().string();
+        const auto writeTime = entry.last_write_time(error);
+        if(error || !isShaderFile(fileName))
+        {
+            continue;
+        }
+        auto [it, inserted] = mWriteTimes.try_emplace(fileName, writeTime);
+        if(inserted || it->second != writeTime)
+        {
+            it->second = writeTime;
+            fileNames.push_back(fileName);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+#else
+
+bool ShaderWatcher::waitForChanges(std::vector<std::string>& fileNames, std::chrono::milliseconds timeout)
+{
+    pollfd descriptor {mInotify, POLLIN, 0};
+    if(poll(&descriptor, 1, static_cast<int>(timeout.count())) <= 0)
+    {
+        return false;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    const ssize_t length = read(mInotify, buffer, sizeof(buffer));
+    bool changed = false;
+    for(ssize_t offset = 0; offset < length;)
+    {
+        const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+        offset += sizeof(inotify_event) + event->len;
+        if(event->len > 0 && isShaderFile(event->name))
+        {
+            fileNames.push_back(event->name);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+#endif // _WIN32
@@ -0,0 +1,44 @@
+#ifndef SHADERWATCHER_H
+#define SHADERWATCHER_H
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Obserwuje katalog ze skompilowanymi shaderami i w tle zgłasza zmienione pliki .spv. Linux - inotify
+// (IN_CLOSE_WRITE i IN_MOVED_TO, czyli plik już w całości zapisany, także przez rename), Windows - czasy modyfikacji
+// sprawdzane co pollInterval. Zmiany, które przyjdą w odstępach krótszych niż settleTime, idą jedną paczką -
+// kompilacja kilku shaderów naraz to jedna przebudowa.
+class ShaderWatcher
+{
+public:
+    using Callback = std::function<void(const std::vector<std::string>& fileNames)>; // na wątku watchera, nazwy bez katalogu
+
+    static constexpr std::chrono::milliseconds pollInterval {100};
+    static constexpr std::chrono::milliseconds settleTime {50};
+
+    ~ShaderWatcher() { stop(); }
+
+    bool start(const std::string& directory, Callback callback); // false - katalogu nie da się obserwować
+    void stop();
+
+private:
+    void loop();
+    bool waitForChanges(std::vector<std::string>& fileNames, std::chrono::milliseconds timeout); // true - coś doszło
+
+    std::string mDirectory;
+    Callback mCallback;
+    std::atomic<bool> mStopping {false};
+    std::thread mThread;
+#if(_WIN32)
+    std::unordered_map<std::string, std::filesystem::file_time_type> mWriteTimes;
+#else
+    int mInotify = -1;
+#endif
+};
+
+#endif // SHADERWATCHER_H
@@ -0,0 +1,67 @@
+#include "simulation.h"
+#include "trace.h"
+#include <utility>
+
+void Simulation::start(SimulationState initialState, SimulationTick tick, float tickRate)
+{
+    stop();
+    mState = std::move(initialState);
+    mTick = std::move(tick);
+    mTickInterval = 1.0f / tickRate;
+    mStopping = false;
+    mThread = std::thread(&Simulation::loop, this);
+}
+
+void Simulation::stop()
+{
+    if(mThread.joinable())
+    {
+        mStopping = true;
+        mThread.join();
+    }
+}
+
+const SimulationSnapshot* Simulation::latest()
+{
+    mHasSnapshot |= mSnapshots.update();
+    return mHasSnapshot ? &mSnapshots.front() : nullptr; // przed pierwszym publish() front to pusty slot
+}
+
+void Simulation::loop()
+{
+    trace::setThreadName("simulation");
+    const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(mTickInterval));
+    auto next = std::chrono::steady_clock::now();
+    uint64_t tick = 0;
+
+    while(!mStopping.load(std::memory_order_relaxed))
+    {
+        std::this_thread::sleep_until(next);
+        {
+            TRACE_SCOPE("simulation tick");
+            mPrevious = mState; // wektory mają już pojemność - bez alokacji po pierwszym ticku
+            mTick(mState, tick, mTickInterval);
+        }
+
+        // kopie do slotu producenta, potem jedna wymiana atomowa
+        SimulationSnapshot& snapshot = mSnapshots.back();
+        snapshot.tick = tick;
+        snapshot.time = next;
+        snapshot.previous = mPrevious;
+        snapshot.current = mState;
+        mSnapshots.publish();
+
+        tick++;
+        mTickCount.store(tick, std::memory_order_relaxed);
+        next += interval;
+
+        const auto lag = std::chrono::steady_clock::now() - next;
+        if(lag > interval * maxLagTicks)
+        {
+            // tick jest droższy niż jego krok - symulacja zwalnia zamiast zapychać rdzeń zaległościami
+            const uint64_t skipped = lag / interval;
+            mDroppedTicks.fetch_add(skipped, std::memory_order_relaxed);
+            next += interval * skipped;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+#include "scene.h"
+#include "triplebuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Stan symulacji - własność wątku symulacji, scena silnika dostaje tylko jego interpolowane kopie.
+struct SimulationState
+{
+    std::vector<LocalTransform> transforms; // w kolejności encji przekazanych do Engine::startSimulation
+    Camera camera;
+};
+
+// Dwa kolejne ticki, żeby render mógł interpolować bez własnej kopii poprzedniego stanu.
+struct SimulationSnapshot
+{
+    uint64_t tick = 0;
+    std::chrono::steady_clock::time_point time; // chwila, której odpowiada current
+    SimulationState previous;
+    SimulationState current;
+};
+
+using SimulationTick = std::function<void(SimulationState& state, uint64_t tick, float deltaTime)>;
+
+// Symulacja ze stałym krokiem na osobnym wątku. Po każdym ticku publikuje migawkę przez TripleBuffer,
+// więc ani tick nie czeka na ramkę, ani ramka na tick - każde tempo zależy tylko od własnego kosztu.
+// Render pokazuje stan o jeden tick wstecz, interpolując między previous i current.
+class Simulation
+{
+public:
+    static constexpr uint32_t maxLagTicks = 8; // dalej w tyle - ticki są pomijane, zamiast nadrabiać bez końca
+
+    ~Simulation() { stop(); }
+
+    void start(SimulationState initialState, SimulationTick tick, float tickRate);
+    void stop();
+    bool isRunning() const { return mThread.joinable(); }
+
+    // tylko wątek renderu; nullptr przed pierwszym tickiem. Ważne do następnego wywołania.
+    const SimulationSnapshot* latest();
+    float tickInterval() const { return mTickInterval; } // s
+    uint64_t tickCount() const { return mTickCount.load(std::memory_order_relaxed); }
+    uint64_t droppedTicks() const { return mDroppedTicks.load(std::memory_order_relaxed); }
+
+private:
+    void loop();
+
+    SimulationTick mTick;
+    SimulationState mState;    // tylko wątek symulacji
+    SimulationState mPrevious; // też
+    float mTickInterval = 1.0f / 60.0f;
+    TripleBuffer<SimulationSnapshot> mSnapshots;
+    bool mHasSnapshot = false; // wątek renderu
+
+    std::atomic<bool> mStopping {false};
+    std::atomic<uint64_t> mTickCount {0};
+    std::atomic<uint64_t> mDroppedTicks {0};
+    std::thread mThread;
+};
+
+#endif // SIMULATION_H
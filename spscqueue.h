@@ -0,0 +1,57 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Kolejka bez blokad dla dokładnie jednego producenta i jednego konsumenta (np. wątek okna -> wątek renderu).
+// Indeksy tylko rosną, slot to indeks & (Capacity - 1). Każda strona trzyma kopię indeksu drugiej strony
+// i czyta atomowy dopiero, gdy kopia mówi "pełna"/"pusta" - w zwykłym przypadku linia cache nie skacze między rdzeniami.
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    bool push(const T& value) // tylko wątek producenta; false - kolejka pełna
+    {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if(head - mCachedTail == Capacity)
+        {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if(head - mCachedTail == Capacity)
+            {
+                return false;
+            }
+        }
+        mItems[head & (Capacity - 1)] = value;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) // tylko wątek konsumenta; false - kolejka pusta
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        if(tail == mCachedHead)
+        {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if(tail == mCachedHead)
+            {
+                return false;
+            }
+        }
+        value = mItems[tail & (Capacity - 1)];
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // producent i konsument piszą do osobnych linii cache
+    alignas(64) std::atomic<size_t> mHead {0};
+    size_t mCachedTail = 0;
+    alignas(64) std::atomic<size_t> mTail {0};
+    size_t mCachedHead = 0;
+    alignas(64) std::array<T, Capacity> mItems {};
+};
+
+#endif // SPSCQUEUE_H
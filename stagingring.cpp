@@ -0,0 +1,49 @@
+#include "stagingring.h"
+
+void StagingRing::create(MemoryAllocator& allocator, VkDeviceSize size, uint32_t frameSlots)
+{
+    mAllocator = &allocator;
+    mBuffer = allocator.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    mSlotBytes.assign(frameSlots, 0);
+    mHead = 0;
+    mUsed = 0;
+}
+
+void StagingRing::collect(uint32_t frameSlot)
+{
+    mUsed -= mSlotBytes[frameSlot];
+    mSlotBytes[frameSlot] = 0;
+    mFrameSlot = frameSlot;
+}
+
+uint8_t* StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+    VkDeviceSize start = (mHead + alignment - 1) / alignment * alignment;
+    VkDeviceSize consumed = start - mHead + size;
+    if(start + size > mBuffer.size)
+    {
+        // nie mieści się przed końcem - reszta bufora idzie w odpad, zaczynamy od zera
+        start = 0;
+        consumed = mBuffer.size - mHead + size;
+    }
+    if(consumed > freeBytes())
+    {
+        return nullptr;
+    }
+
+    mHead = start + size;
+    mUsed += consumed;
+    mSlotBytes[mFrameSlot] += consumed;
+    mDirty = true;
+    offset = start;
+    return static_cast<uint8_t*>(mBuffer.mapped) + start;
+}
+
+void StagingRing::flush()
+{
+    if(mDirty)
+    {
+        mAllocator->flush(mBuffer);
+        mDirty = false;
+    }
+}
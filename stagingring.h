@@ -0,0 +1,33 @@
+#ifndef STAGINGRING_H
+#define STAGINGRING_H
+#include "memory.h"
+#include <cstdint>
+#include <vector>
+
+// Pierścień w jednym buforze host visible na dane wysyłane z ramką. Miejsce zajęte w ramce wraca do puli,
+// gdy fence jej slotu zostanie odczekany - ramki kończą się po kolei, więc zwalnia się zawsze najstarszy kawałek.
+class StagingRing
+{
+public:
+    void create(MemoryAllocator& allocator, VkDeviceSize size, uint32_t frameSlots);
+    void collect(uint32_t frameSlot); // po vkWaitForFences slotu - od teraz allocate() liczy się do tego slotu
+
+    // nullptr - pierścień pełny, trzeba poczekać na koniec starszych ramek
+    uint8_t* allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    void flush(); // po zapisach w tej ramce, no-op dla pamięci coherent
+
+    VkBuffer buffer() const { return mBuffer.buffer; }
+    VkDeviceSize size() const { return mBuffer.size; }
+    VkDeviceSize freeBytes() const { return mBuffer.size - mUsed; }
+
+private:
+    MemoryAllocator* mAllocator = nullptr;
+    Buffer mBuffer;
+    VkDeviceSize mHead = 0;  // następny wolny bajt
+    VkDeviceSize mUsed = 0;  // razem z odpadem na końcu przy zawinięciu
+    std::vector<VkDeviceSize> mSlotBytes; // zajęte przez ramkę w locie z danego slotu
+    uint32_t mFrameSlot = 0;
+    bool mDirty = false;
+};
+
+#endif // STAGINGRING_H
@@ -0,0 +1,117 @@
+#include "startup.h"
+#include "log.h"
+#include "trace.h"
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+void StartupGraph::addStep(std::string_view name, const std::vector<std::string_view>& dependencies, std::function<void()> task, bool mainThread)
+{
+    Step step;
+    step.name = name;
+    step.traceName = trace::intern(name);
+    step.task = std::move(task);
+    step.mainThread = mainThread;
+
+    for(const auto& dependency : dependencies)
+    {
+        bool found = false;
+        for(size_t i = 0; i < mSteps.size(); i++)
+        {
+            if(mSteps[i].name == dependency)
+            {
+                step.dependencies.push_back(i);
+                found = true;
+                break;
+            }
+        }
+        if(!found)
+        {
+            throw std::runtime_error("startup step depends on unknown step");
+        }
+    }
+
+    step.done = step.promise.get_future().share();
+    mSteps.push_back(std::move(step));
+}
+
+void StartupGraph::execute(Step& step)
+{
+    const auto waitStart = Clock::now();
+    try
+    {
+        for(size_t dependency : step.dependencies)
+        {
+            mSteps[dependency].done.get(); // jeśli zależność rzuciła, ten krok też kończy się jej wyjątkiem
+        }
+        step.start = Clock::now();
+        step.blocked = step.start - waitStart;
+        TRACE_SCOPE(step.traceName);
+        step.task();
+        step.end = Clock::now();
+        step.promise.set_value();
+    }
+    catch(...)
+    {
+        step.end = Clock::now();
+        step.promise.set_exception(std::current_exception());
+    }
+}
+
+void StartupGraph::run()
+{
+    mStart = Clock::now();
+
+    std::vector<std::thread> workers;
+    for(auto& step : mSteps)
+    {
+        if(!step.mainThread)
+        {
+            workers.emplace_back([this, &step]
+            {
+                trace::setThreadName("startup: " + step.name);
+                execute(step);
+            });
+        }
+    }
+
+    // kroki głównego wątku czekają tylko na wcześniejsze kroki, więc nie ma zakleszczenia
+    for(auto& step : mSteps)
+    {
+        if(step.mainThread)
+        {
+            execute(step);
+        }
+    }
+
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+    mEnd = Clock::now();
+
+    for(auto& step : mSteps)
+    {
+        step.done.get();
+    }
+}
+
+void StartupGraph::report() const
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    Clock::duration serial {};
+    for(const auto& step : mSteps)
+    {
+        const Clock::duration duration = step.end - step.start;
+        serial += duration;
+
+        logger::info("startup: ", std::left, std::setw(16), step.name, std::right, std::fixed, std::setprecision(2),
+                     std::setw(8), Milliseconds(duration).count(), " ms  (start +",
+                     Milliseconds(step.start - mStart).count(), " ms, waited ",
+                     Milliseconds(step.blocked).count(), " ms)");
+    }
+
+    logger::info("startup: total ", std::fixed, std::setprecision(2), Milliseconds(mEnd - mStart).count(),
+                 " ms, serial sum ", Milliseconds(serial).count(), " ms");
+}
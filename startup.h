@@ -0,0 +1,45 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Graf zależności kroków startu silnika. Kroki bez wzajemnych zależności wykonują się równolegle,
+// każdy mierzy swój czas, a report() wypisuje je po zakończeniu run().
+class StartupGraph
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // zależności muszą być dodane wcześniej - kolejność dodawania jest więc zawsze poprawną kolejnością topologiczną
+    void addStep(std::string_view name, const std::vector<std::string_view>& dependencies, std::function<void()> task, bool mainThread = false);
+    void run(); // rzuca pierwszy wyjątek (w kolejności dodania), ale dopiero gdy wszystkie wątki skończą
+    void report() const;
+
+private:
+    struct Step
+    {
+        std::string name;
+        const char* traceName = nullptr; // trwała kopia dla trace'u - zdarzenia są zapisywane już po zniszczeniu grafu
+        std::vector<size_t> dependencies;
+        std::function<void()> task;
+        bool mainThread = false; // dla kroków, które muszą żyć na wątku głównym (np. coś, co ma kolejkę wiadomości Win32)
+
+        std::promise<void> promise;
+        std::shared_future<void> done;
+        Clock::time_point start;
+        Clock::time_point end;
+        Clock::duration blocked {}; // czas czekania na zależności
+    };
+
+    void execute(Step& step);
+
+    std::vector<Step> mSteps;
+    Clock::time_point mStart;
+    Clock::time_point mEnd;
+};
+
+#endif // STARTUP_H
@@ -0,0 +1,113 @@
+#include "texturefile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + textureFileAlignment - 1) / textureFileAlignment * textureFileAlignment;
+    }
+}
+
+uint64_t textureMipSize(uint32_t width, uint32_t height, uint32_t blockWidth, uint32_t blockHeight, uint32_t blockSize)
+{
+    return uint64_t((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * blockSize;
+}
+
+void writeTextureFile(const std::string& path, const TextureData& texture)
+{
+    if(texture.mips.empty() || texture.mips.size() > maxTextureMipCount)
+    {
+        throw std::runtime_error("invalid mip count for " + path);
+    }
+
+    TextureFileHeader header {};
+    header.magic = textureFileMagic;
+    header.version = textureFileVersion;
+    header.format = texture.format;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.mipCount = static_cast<uint32_t>(texture.mips.size());
+    header.blockWidth = texture.blockWidth;
+    header.blockHeight = texture.blockHeight;
+    header.blockSize = texture.blockSize;
+    header.mipOffset = alignUp(sizeof(TextureFileHeader));
+
+    // dane od najmniejszego mipa - ogon łańcucha jest na początku
+    std::vector<TextureMip> mips(header.mipCount);
+    uint64_t offset = alignUp(header.mipOffset + mips.size() * sizeof(TextureMip));
+    for(uint32_t level = header.mipCount; level-- > 0;)
+    {
+        TextureMip& mip = mips[level];
+        mip.width = std::max(texture.width >> level, 1u);
+        mip.height = std::max(texture.height >> level, 1u);
+        mip.size = textureMipSize(mip.width, mip.height, texture.blockWidth, texture.blockHeight, texture.blockSize);
+        if(mip.size != texture.mips[level].size())
+        {
+            throw std::runtime_error("mip " + std::to_string(level) + " of " + path + " has " + std::to_string(texture.mips[level].size()) +
+                                     " bytes, expected " + std::to_string(mip.size));
+        }
+        mip.offset = offset;
+        offset = alignUp(offset + mip.size);
+    }
+    header.fileSize = offset;
+
+    std::vector<uint8_t> file(header.fileSize, 0);
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + header.mipOffset, mips.data(), mips.size() * sizeof(TextureMip));
+    for(uint32_t level = 0; level < header.mipCount; level++)
+    {
+        std::memcpy(file.data() + mips[level].offset, texture.mips[level].data(), mips[level].size);
+    }
+
+    std::ofstream output(path, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(file.data()), file.size());
+    if(!output)
+    {
+        throw std::runtime_error("failed to write " + path);
+    }
+}
+
+TextureFile::TextureFile(const std::string& path)
+    : mFile(path)
+{
+    if(mFile.size() < sizeof(TextureFileHeader))
+    {
+        throw std::runtime_error(path + " is not a texture file");
+    }
+    mHeader = reinterpret_cast<const TextureFileHeader*>(mFile.data());
+
+    if(mHeader->magic != textureFileMagic)
+    {
+        throw std::runtime_error(path + " is not a texture file");
+    }
+    if(mHeader->version != textureFileVersion)
+    {
+        throw std::runtime_error(path + " has texture file version " + std::to_string(mHeader->version) + ", expected " + std::to_string(textureFileVersion));
+    }
+    if(mHeader->mipCount == 0 || mHeader->mipCount > maxTextureMipCount || mHeader->width == 0 || mHeader->height == 0 ||
+       mHeader->blockWidth == 0 || mHeader->blockHeight == 0 || mHeader->blockSize == 0)
+    {
+        throw std::runtime_error(path + " has an invalid texture description");
+    }
+    if(mHeader->fileSize > mFile.size() || mHeader->mipOffset % textureFileAlignment != 0 ||
+       mHeader->mipOffset + uint64_t(mHeader->mipCount) * sizeof(TextureMip) > mHeader->fileSize)
+    {
+        throw std::runtime_error(path + " is truncated or corrupted");
+    }
+    mMips = reinterpret_cast<const TextureMip*>(mFile.data() + mHeader->mipOffset);
+
+    for(uint32_t level = 0; level < mHeader->mipCount; level++)
+    {
+        const TextureMip& mip = mMips[level];
+        const bool expectedSize = mip.width == std::max(mHeader->width >> level, 1u) && mip.height == std::max(mHeader->height >> level, 1u) &&
+                                  mip.size == textureMipSize(mip.width, mip.height, mHeader->blockWidth, mHeader->blockHeight, mHeader->blockSize);
+        if(!expectedSize || mip.offset % textureFileAlignment != 0 || mip.offset + mip.size > mHeader->fileSize)
+        {
+            throw std::runtime_error(path + " has an invalid mip " + std::to_string(level));
+        }
+    }
+}
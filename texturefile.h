@@ -0,0 +1,75 @@
+#ifndef TEXTUREFILE_H
+#define TEXTUREFILE_H
+#include "mappedfile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binarny format tekstur: nagłówek, tablica mipów i ich dane, już skompresowane blokowo (BCn, ASTC) - silnik
+// kopiuje je prosto ze zmapowanego pliku do stagingu. Dane mipów leżą od najmniejszego, więc ogon łańcucha,
+// wysyłany jako pierwszy, to jeden ciągły kawałek na początku pliku. Little endian.
+constexpr uint32_t textureFileMagic = 0x58455456; // "VTEX"
+constexpr uint32_t textureFileVersion = 1;
+constexpr uint32_t textureFileAlignment = 64;
+constexpr uint32_t maxTextureMipCount = 16;
+
+struct TextureFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;      // VkFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t blockWidth;  // w tekselach, 1 dla formatów nieskompresowanych
+    uint32_t blockHeight;
+    uint32_t blockSize;   // bajty na blok
+    uint32_t reserved;
+    uint64_t mipOffset;   // tablica TextureMip, mip 0 pierwszy
+    uint64_t fileSize;
+};
+
+static_assert(sizeof(TextureFileHeader) == 56, "texture file header layout changed - bump textureFileVersion");
+
+struct TextureMip
+{
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Tekstura przygotowana offline (texture_converter), gotowa do zapisu.
+struct TextureData
+{
+    uint32_t format = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t blockWidth = 1;
+    uint32_t blockHeight = 1;
+    uint32_t blockSize = 4;
+    std::vector<std::vector<uint8_t>> mips; // mip 0 pierwszy
+};
+
+uint64_t textureMipSize(uint32_t width, uint32_t height, uint32_t blockWidth, uint32_t blockHeight, uint32_t blockSize);
+void writeTextureFile(const std::string& path, const TextureData& texture); // rzuca, jeśli rozmiary mipów się nie zgadzają
+
+// Widok na zmapowany plik - wskaźniki prowadzą prosto do stron pliku.
+class TextureFile
+{
+public:
+    explicit TextureFile(const std::string& path); // rzuca przy złym magic/wersji/rozmiarach
+
+    const TextureFileHeader& header() const { return *mHeader; }
+    const TextureMip& mip(uint32_t level) const { return mMips[level]; }
+    const uint8_t* mipData(uint32_t level) const { return mFile.data() + mMips[level].offset; }
+    uint32_t blockRows(uint32_t level) const { return (mMips[level].height + mHeader->blockHeight - 1) / mHeader->blockHeight; }
+    uint64_t blockRowSize(uint32_t level) const { return uint64_t((mMips[level].width + mHeader->blockWidth - 1) / mHeader->blockWidth) * mHeader->blockSize; }
+
+private:
+    MappedFile mFile;
+    const TextureFileHeader* mHeader = nullptr;
+    const TextureMip* mMips = nullptr;
+};
+
+#endif // TEXTUREFILE_H
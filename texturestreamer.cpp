@@ -0,0 +1,554 @@
+#include "texturestreamer.h"
+#include "log.h"
+#include "trace.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr VkDeviceSize stagingAlignment = 16; // wielokrotność rozmiaru bloku (8/16 B) i 4 - wymóg vkCmdCopyBufferToImage
+    constexpr size_t pageSize = 4096;
+
+    uint32_t firstTailMip(const TextureFileHeader& header)
+    {
+        for(uint32_t level = 0; level < header.mipCount; level++)
+        {
+            if(std::max(header.width >> level, header.height >> level) <= TextureStreamer::tailSize)
+            {
+                return level;
+            }
+        }
+        return header.mipCount - 1; // łańcuch urwany przed tailSize - ogonem jest ostatni poziom
+    }
+
+    VkImageMemoryBarrier levelBarrier(VkImage image, uint32_t firstMip, uint32_t mipCount, VkImageLayout oldLayout, VkImageLayout newLayout)
+    {
+        VkImageMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext = NULL;
+        barrier.srcAccessMask = oldLayout == VK_IMAGE_LAYOUT_UNDEFINED ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, firstMip, mipCount, 0, 1};
+        return barrier;
+    }
+
+    void transition(VkCommandBuffer cmdBuff, VkImage image, uint32_t firstMip, uint32_t mipCount, VkImageLayout oldLayout, VkImageLayout newLayout)
+    {
+        const VkImageMemoryBarrier barrier = levelBarrier(image, firstMip, mipCount, oldLayout, newLayout);
+        const VkPipelineStageFlags srcStage = oldLayout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
+        const VkPipelineStageFlags dstStage = newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ? VK_PIPELINE_STAGE_TRANSFER_BIT
+                                                                                                 : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        vkCmdPipelineBarrier(cmdBuff, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mJobReady.notify_all();
+    for(auto& loader : mLoaders)
+    {
+        loader.join();
+    }
+}
+
+void TextureStreamer::create(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, DeletionQueue& deletionQueue,
+                             uint32_t frameSlots, VkDeviceSize uploadBudget, uint32_t loaderThreads)
+{
+    mPhysicalDevice = physicalDevice;
+    mDevice = device;
+    mAllocator = &allocator;
+    mDeletionQueue = &deletionQueue;
+    mUploadBudget = uploadBudget;
+
+    // każda ramka w locie może trzymać swój budżet, plus zapas na ogon większy niż budżet
+    mStaging.create(allocator, uploadBudget * (frameSlots + 1), frameSlots);
+
+    for(uint32_t i = 0; i < std::max(loaderThreads, 1u); i++)
+    {
+        mLoaders.emplace_back([this, i]
+        {
+            trace::setThreadName("texture loader " + std::to_string(i));
+            loaderLoop();
+        });
+    }
+}
+
+TextureId TextureStreamer::load(const std::string& path)
+{
+    const TextureId id = static_cast<TextureId>(mTextures.size());
+    mTextures.emplace_back();
+    mTextures.back().path = path;
+    mTextures.back().loadTime = std::chrono::steady_clock::now();
+    if(mAllUsableLogged && mAllCompleteLogged)
+    {
+        mFirstLoadTime = mTextures.back().loadTime; // początek nowej partii
+    }
+    mAllUsableLogged = false;
+    mAllCompleteLogged = false;
+
+    Job job;
+    job.id = id;
+    job.path = path;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mJobReady.notify_one();
+    return id;
+}
+
+void TextureStreamer::request(TextureId id, float screenSize)
+{
+    Texture& texture = mTextures[id];
+    texture.priority = screenSize;
+    if(texture.evictable != 0)
+    {
+        mAllocator->touch(texture.evictable);
+    }
+    if(texture.state != State::Ready)
+    {
+        return;
+    }
+
+    // mip, na którym jeden teksel wypada mniej więcej na jeden piksel
+    const TextureFileHeader& header = texture.file->header();
+    const float size = float(std::max(header.width, header.height));
+    const float level = screenSize > 0.0f ? std::floor(std::log2(size / screenSize)) : float(texture.tailMip);
+    texture.wantedMip = static_cast<uint32_t>(std::clamp(level, 0.0f, float(texture.tailMip)));
+}
+
+void TextureStreamer::collect(uint32_t frameSlot)
+{
+    mFrameSlot = frameSlot;
+    mStaging.collect(frameSlot);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReceived.swap(mCompletions);
+    }
+
+    for(Completion& completion : mReceived)
+    {
+        Texture& texture = mTextures[completion.id];
+        if(texture.state != State::Opening)
+        {
+            texture.prefetchPending = false;
+            texture.prefetchedMip = std::min(texture.prefetchedMip, completion.prefetchedMip);
+            continue;
+        }
+
+        if(completion.file == nullptr)
+        {
+            texture.state = State::Failed;
+            logger::warning("texture ", texture.path, ": ", completion.error);
+            continue;
+        }
+
+        const TextureFileHeader& header = completion.file->header();
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, static_cast<VkFormat>(header.format), &formatProperties);
+        if(!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+        {
+            texture.state = State::Failed;
+            logger::warning("texture ", texture.path, ": format ", header.format, " is not supported by the device");
+            continue;
+        }
+
+        texture.file = std::move(completion.file);
+        texture.state = State::Ready;
+        texture.format = static_cast<VkFormat>(header.format);
+        texture.mipCount = header.mipCount;
+        texture.tailMip = completion.prefetchedMip;
+        texture.prefetchedMip = completion.prefetchedMip;
+        texture.residentMip = texture.mipCount;
+        request(completion.id, texture.priority); // request() przed otwarciem zapamiętał tylko priorytet
+    }
+    mReceived.clear();
+}
+
+void TextureStreamer::record(VkCommandBuffer cmdBuff)
+{
+    if(mTextures.empty())
+    {
+        return;
+    }
+    TRACE_SCOPE("texture uploads");
+    VkDeviceSize budget = mUploadBudget;
+
+    // najpierw ogony wszystkich tekstur - po nich każda jest już używalna
+    for(TextureId id = 0; id < mTextures.size(); id++)
+    {
+        const Texture& texture = mTextures[id];
+        if(texture.state == State::Ready && texture.residentMip == texture.mipCount && !uploadTail(cmdBuff, id, budget))
+        {
+            break;
+        }
+    }
+
+    mCandidates.clear();
+    for(TextureId id = 0; id < mTextures.size(); id++)
+    {
+        const Texture& texture = mTextures[id];
+        if(texture.state == State::Ready && texture.residentMip < texture.mipCount && texture.residentMip > texture.wantedMip)
+        {
+            mCandidates.push_back(id);
+        }
+    }
+    std::sort(mCandidates.begin(), mCandidates.end(), [this](TextureId a, TextureId b){ return mTextures[a].priority > mTextures[b].priority; });
+
+    bool stagingFull = false;
+    for(TextureId id : mCandidates)
+    {
+        Texture& texture = mTextures[id];
+        while(!stagingFull && budget > 0 && texture.residentMip > texture.wantedMip && texture.prefetchedMip < texture.residentMip)
+        {
+            stagingFull = !uploadRows(cmdBuff, id, budget);
+        }
+
+        // strony następnego poziomu wczytuje wątek ładujący, zanim będą potrzebne - render nie czeka na dysk
+        const uint32_t lookahead = std::max(texture.wantedMip, texture.residentMip >= 2 ? texture.residentMip - 2 : 0u);
+        if(!texture.prefetchPending && texture.residentMip < texture.mipCount && texture.prefetchedMip > lookahead)
+        {
+            enqueuePrefetch(id, texture.prefetchedMip - 1, texture.prefetchedMip - 1);
+        }
+    }
+
+    mStaging.flush();
+    logProgress();
+}
+
+bool TextureStreamer::isBusy() const
+{
+    for(const Texture& texture : mTextures)
+    {
+        if(texture.state == State::Opening || (texture.state == State::Ready && texture.residentMip > texture.wantedMip))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+VkImageView TextureStreamer::view(TextureId id) const
+{
+    return mTextures[id].view;
+}
+
+uint32_t TextureStreamer::residentMip(TextureId id) const
+{
+    return mTextures[id].residentMip;
+}
+
+TextureStreamingStats TextureStreamer::stats() const
+{
+    TextureStreamingStats stats;
+    stats.textureCount = static_cast<uint32_t>(mTextures.size());
+    for(const Texture& texture : mTextures)
+    {
+        stats.failedCount += texture.state == State::Failed;
+        if(texture.state == State::Ready && texture.residentMip < texture.mipCount)
+        {
+            stats.usableCount++;
+            stats.completeCount += texture.residentMip <= texture.wantedMip;
+            VkMemoryRequirements memoryRequirements;
+            vkGetImageMemoryRequirements(mDevice, texture.image, &memoryRequirements);
+            stats.residentBytes += memoryRequirements.size;
+        }
+    }
+    stats.uploadedBytes = mUploadedBytes;
+    stats.evictionCount = mEvictionCount;
+    return stats;
+}
+
+bool TextureStreamer::uploadTail(VkCommandBuffer cmdBuff, TextureId id, VkDeviceSize& budget)
+{
+    Texture& texture = mTextures[id];
+    const TextureFile& file = *texture.file;
+
+    VkDeviceSize tailBytes = 0;
+    for(uint32_t level = texture.tailMip; level < texture.mipCount; level++)
+    {
+        tailBytes += (file.mip(level).size + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+    }
+    if(tailBytes > budget && budget < mUploadBudget)
+    {
+        return false; // pierwszy ogon w ramce idzie zawsze, nawet ponad budżet
+    }
+
+    VkDeviceSize stagingOffset = 0;
+    uint8_t* staging = mStaging.allocate(tailBytes, stagingAlignment, stagingOffset);
+    if(staging == nullptr)
+    {
+        return false;
+    }
+
+    // obraz od razu z całym łańcuchem - pamięć na większe mipy jest zajęta od początku, ale widok jej jeszcze nie obejmuje
+    const TextureFileHeader& header = file.header();
+    VkImageCreateInfo imageCreateInfo {};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext = NULL;
+    imageCreateInfo.flags = 0;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = texture.format;
+    imageCreateInfo.extent = {header.width, header.height, 1};
+    imageCreateInfo.mipLevels = texture.mipCount;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image = VK_NULL_HANDLE;
+    if(vkCreateImage(mDevice, &imageCreateInfo, NULL, &image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create texture image for " + texture.path);
+    }
+    texture.image = ImageHandle(mDevice, image);
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(mDevice, image, &memoryRequirements);
+    texture.memory = mAllocator->allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT); // może wyrzucić inne tekstury
+    vkBindImageMemory(mDevice, image, texture.memory, 0);
+    texture.evictable = mAllocator->registerEvictable(texture.memory, [this, id]{ evict(id); });
+
+    std::array<VkBufferImageCopy, maxTextureMipCount> regions = {};
+    uint32_t regionCount = 0;
+    VkDeviceSize offset = 0;
+    for(uint32_t level = texture.tailMip; level < texture.mipCount; level++)
+    {
+        const TextureMip& mip = file.mip(level);
+        std::memcpy(staging + offset, file.mipData(level), mip.size);
+
+        VkBufferImageCopy& region = regions[regionCount++];
+        region.bufferOffset = stagingOffset + offset;
+        region.bufferRowLength = 0; // dane ciasno upakowane
+        region.bufferImageHeight = 0;
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {mip.width, mip.height, 1};
+        offset += (mip.size + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+    }
+
+    const uint32_t tailCount = texture.mipCount - texture.tailMip;
+    transition(cmdBuff, image, texture.tailMip, tailCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vkCmdCopyBufferToImage(cmdBuff, mStaging.buffer(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regionCount, regions.data());
+    transition(cmdBuff, image, texture.tailMip, tailCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    texture.residentMip = texture.tailMip;
+    texture.uploadedRows = 0;
+    createView(texture, texture.tailMip);
+
+    budget -= std::min(budget, tailBytes);
+    mUploadedBytes += tailBytes;
+    return true;
+}
+
+bool TextureStreamer::uploadRows(VkCommandBuffer cmdBuff, TextureId id, VkDeviceSize& budget)
+{
+    Texture& texture = mTextures[id];
+    const TextureFile& file = *texture.file;
+    const uint32_t level = texture.residentMip - 1;
+    const TextureMip& mip = file.mip(level);
+    const uint32_t rows = file.blockRows(level);
+    const VkDeviceSize rowSize = file.blockRowSize(level);
+
+    uint32_t count = static_cast<uint32_t>(std::min<VkDeviceSize>(rows - texture.uploadedRows, budget / rowSize));
+    if(count == 0)
+    {
+        if(budget < mUploadBudget)
+        {
+            return false;
+        }
+        count = 1; // wiersz większy niż cały budżet - inaczej ten mip nie ruszyłby nigdy
+    }
+
+    const VkDeviceSize bytes = count * rowSize;
+    VkDeviceSize stagingOffset = 0;
+    uint8_t* staging = mStaging.allocate(bytes, stagingAlignment, stagingOffset);
+    if(staging == nullptr)
+    {
+        return false;
+    }
+    std::memcpy(staging, file.mipData(level) + texture.uploadedRows * rowSize, bytes);
+
+    // poziom w TRANSFER_DST między ramkami nie przeszkadza - widok zaczyna się od residentMip
+    if(texture.uploadedRows == 0)
+    {
+        transition(cmdBuff, texture.image, level, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    }
+
+    const uint32_t blockHeight = file.header().blockHeight;
+    const uint32_t y = texture.uploadedRows * blockHeight;
+    VkBufferImageCopy region {};
+    region.bufferOffset = stagingOffset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+    region.imageOffset = {0, static_cast<int32_t>(y), 0};
+    region.imageExtent = {mip.width, std::min(count * blockHeight, mip.height - y), 1};
+    vkCmdCopyBufferToImage(cmdBuff, mStaging.buffer(), texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    texture.uploadedRows += count;
+    budget -= std::min(budget, bytes);
+    mUploadedBytes += bytes;
+
+    if(texture.uploadedRows == rows)
+    {
+        transition(cmdBuff, texture.image, level, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        texture.uploadedRows = 0;
+        texture.residentMip = level;
+        createView(texture, level);
+    }
+    return true;
+}
+
+void TextureStreamer::createView(Texture& texture, uint32_t baseMip)
+{
+    VkImageViewCreateInfo viewCreateInfo {};
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = NULL;
+    viewCreateInfo.flags = 0;
+    viewCreateInfo.image = texture.image;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = texture.format;
+    viewCreateInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, baseMip, texture.mipCount - baseMip, 0, 1};
+
+    VkImageView view = VK_NULL_HANDLE;
+    if(vkCreateImageView(mDevice, &viewCreateInfo, NULL, &view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create texture view for " + texture.path);
+    }
+    if(texture.view != VK_NULL_HANDLE)
+    {
+        mDeletionQueue->retire(mFrameSlot, std::move(texture.view)); // ramki w locie mogą jeszcze z niego próbkować
+    }
+    texture.view = ImageViewHandle(mDevice, view);
+}
+
+void TextureStreamer::evict(TextureId id)
+{
+    // alokator już wyrejestrował wpis; obraz i pamięć żyją, dopóki GPU nie skończy ramek, które mogły ich używać
+    Texture& texture = mTextures[id];
+    mDeletionQueue->retire(mFrameSlot, std::move(texture.view));
+    mDeletionQueue->retire(mFrameSlot, std::move(texture.image));
+    mDeletionQueue->retire(mFrameSlot, std::move(texture.memory));
+    texture.evictable = 0;
+    texture.residentMip = texture.mipCount;
+    texture.uploadedRows = 0;
+    mEvictionCount++;
+}
+
+void TextureStreamer::logProgress()
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    if(!mAllUsableLogged)
+    {
+        bool allUsable = true;
+        for(const Texture& texture : mTextures)
+        {
+            allUsable &= texture.state == State::Failed || (texture.state == State::Ready && texture.residentMip < texture.mipCount);
+        }
+        if(allUsable)
+        {
+            mAllUsableLogged = true;
+            logger::info("textures: ", mTextures.size(), " usable after ", Milliseconds(std::chrono::steady_clock::now() - mFirstLoadTime).count(), " ms");
+        }
+    }
+    else if(!mAllCompleteLogged && !isBusy())
+    {
+        mAllCompleteLogged = true;
+        logger::info("textures: ", mTextures.size(), " complete after ", Milliseconds(std::chrono::steady_clock::now() - mFirstLoadTime).count(),
+                     " ms, ", mUploadedBytes >> 20, " MiB uploaded");
+    }
+}
+
+void TextureStreamer::enqueuePrefetch(TextureId id, uint32_t firstMip, uint32_t lastMip)
+{
+    Texture& texture = mTextures[id];
+    texture.prefetchPending = true;
+
+    Job job;
+    job.id = id;
+    job.file = texture.file.get();
+    job.firstMip = firstMip;
+    job.lastMip = lastMip;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mJobReady.notify_one();
+}
+
+void TextureStreamer::prefetch(const TextureFile& file, uint32_t firstMip, uint32_t lastMip)
+{
+    // odczyt po bajcie na stronę - system wczytuje je teraz, a nie przy memcpy na wątku renderu
+    TRACE_SCOPE("prefetch mips");
+    volatile uint8_t sink = 0;
+    for(uint32_t level = firstMip; level <= lastMip; level++)
+    {
+        const uint8_t* data = file.mipData(level);
+        const size_t size = file.mip(level).size;
+        for(size_t offset = 0; offset < size; offset += pageSize)
+        {
+            sink = sink + data[offset];
+        }
+    }
+}
+
+void TextureStreamer::loaderLoop()
+{
+    while(true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobReady.wait(lock, [this]{ return !mJobs.empty() || mStopping; });
+            if(mStopping)
+            {
+                return;
+            }
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        Completion completion;
+        completion.id = job.id;
+        if(job.file == nullptr)
+        {
+            TRACE_SCOPE("open texture");
+            try
+            {
+                completion.file = std::make_unique<TextureFile>(job.path);
+                completion.prefetchedMip = firstTailMip(completion.file->header());
+                prefetch(*completion.file, completion.prefetchedMip, completion.file->header().mipCount - 1);
+            }
+            catch(const std::exception& e)
+            {
+                completion.error = e.what();
+            }
+        }
+        else
+        {
+            prefetch(*job.file, job.firstMip, job.lastMip);
+            completion.prefetchedMip = job.firstMip;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCompletions.push_back(std::move(completion));
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+#include "deletionqueue.h"
+#include "memory.h"
+#include "stagingring.h"
+#include "texturefile.h"
+#include "vkhandle.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using TextureId = uint32_t;
+
+struct TextureStreamingStats
+{
+    uint32_t textureCount = 0;
+    uint32_t usableCount = 0;   // mają co najmniej ogon łańcucha mipów
+    uint32_t completeCount = 0; // mają wszystkie mipy, o które proszono
+    uint32_t failedCount = 0;
+    VkDeviceSize uploadedBytes = 0;
+    VkDeviceSize residentBytes = 0; // pamięć obrazów
+    uint32_t evictionCount = 0;
+};
+
+// Strumieniowanie tekstur bez zatrzymywania ramek. Wątki ładujące otwierają i mapują pliki .tex i z wyprzedzeniem
+// wczytują strony kolejnych mipów; wątek renderu tylko kopiuje gotowe dane do pierścienia stagingowego i nagrywa
+// kopie do command buffera ramki, w granicach budżetu bajtów na ramkę. Najpierw ogon łańcucha (mipy do
+// tailSize tekseli) każdej tekstury - wtedy jest już używalna - a potem większe mipy według priorytetu, czyli
+// rozmiaru na ekranie. Duży mip idzie po kawałku, wierszami bloków. Obrazy są wyrzucane przez alokator (LRU),
+// gdy brakuje pamięci, i wracają od ogona przy następnym request().
+class TextureStreamer
+{
+public:
+    static constexpr uint32_t tailSize = 64;
+
+    TextureStreamer() = default;
+    ~TextureStreamer(); // zatrzymuje wątki ładujące - przed urządzeniem
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    void create(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, DeletionQueue& deletionQueue,
+                uint32_t frameSlots, VkDeviceSize uploadBudget, uint32_t loaderThreads);
+
+    TextureId load(const std::string& path); // wraca od razu, plik otwiera wątek ładujący
+    // screenSize - dłuższy bok tekstury na ekranie w pikselach; wyznacza najmniejszy potrzebny mip i kolejność
+    void request(TextureId id, float screenSize);
+
+    void collect(uint32_t frameSlot); // po vkWaitForFences slotu: zwalnia staging ramki, odbiera wyniki wątków
+    void record(VkCommandBuffer cmdBuff); // przed renderpassem
+    bool isBusy() const; // coś jeszcze czeka na wysłanie - nagrane command buffery nie wystarczą
+
+    VkImageView view(TextureId id) const; // VK_NULL_HANDLE, dopóki nie ma ogona; zmienia się, gdy dochodzą mipy
+    uint32_t residentMip(TextureId id) const; // najmniejszy poziom w widoku, mipCount - nic
+    TextureStreamingStats stats() const;
+
+private:
+    enum class State
+    {
+        Opening,  // czeka na wątek ładujący
+        Ready,    // plik otwarty
+        Failed
+    };
+
+    struct Texture
+    {
+        std::string path;
+        State state = State::Opening;
+        std::unique_ptr<TextureFile> file; // zostaje zmapowany - po wyrzuceniu obraz wraca z tego samego pliku
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t mipCount = 0;
+        uint32_t tailMip = 0;       // pierwszy poziom ogona
+
+        ImageHandle image;
+        DeviceMemory memory;
+        ImageViewHandle view;
+        EvictableId evictable = 0;
+        uint32_t residentMip = 0;   // mipCount - obraz nie istnieje
+        uint32_t uploadedRows = 0;  // wiersze bloków poziomu residentMip - 1 wysłane w poprzednich ramkach
+        uint32_t prefetchedMip = 0; // poziomy od tego w górę są już w pamięci; mipCount - nic
+        bool prefetchPending = false;
+
+        uint32_t wantedMip = 0;
+        float priority = 0.0f;
+        std::chrono::steady_clock::time_point loadTime;
+    };
+
+    struct Job
+    {
+        TextureId id = 0;
+        std::string path;              // Open
+        const TextureFile* file = nullptr; // Prefetch
+        uint32_t firstMip = 0;
+        uint32_t lastMip = 0;          // włącznie
+    };
+
+    struct Completion
+    {
+        TextureId id = 0;
+        std::unique_ptr<TextureFile> file; // Open; null przy błędzie
+        std::string error;
+        uint32_t prefetchedMip = 0;
+    };
+
+    void loaderLoop();
+    static void prefetch(const TextureFile& file, uint32_t firstMip, uint32_t lastMip);
+    void enqueuePrefetch(TextureId id, uint32_t firstMip, uint32_t lastMip);
+
+    bool uploadTail(VkCommandBuffer cmdBuff, TextureId id, VkDeviceSize& budget);
+    bool uploadRows(VkCommandBuffer cmdBuff, TextureId id, VkDeviceSize& budget); // false - brak miejsca albo budżetu
+    void createView(Texture& texture, uint32_t baseMip);
+    void evict(TextureId id);
+    void logProgress();
+
+    VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+    VkDevice mDevice = VK_NULL_HANDLE;
+    MemoryAllocator* mAllocator = nullptr;
+    DeletionQueue* mDeletionQueue = nullptr;
+    uint32_t mFrameSlot = 0;
+    VkDeviceSize mUploadBudget = 0;
+    StagingRing mStaging;
+
+    std::vector<Texture> mTextures;     // tylko wątek renderu
+    std::vector<TextureId> mCandidates; // wielokrotnie używany w record()
+    VkDeviceSize mUploadedBytes = 0;
+    uint32_t mEvictionCount = 0;
+    bool mAllUsableLogged = true;
+    bool mAllCompleteLogged = true;
+    std::chrono::steady_clock::time_point mFirstLoadTime;
+
+    std::vector<std::thread> mLoaders;
+    std::mutex mMutex; // kolejka zadań i wyników
+    std::condition_variable mJobReady;
+    std::deque<Job> mJobs;
+    std::vector<Completion> mCompletions;
+    std::vector<Completion> mReceived; // zamieniany z mCompletions pod blokadą
+    bool mStopping = false;
+};
+
+#endif // TEXTURESTREAMER_H
@@ -0,0 +1,371 @@
+#include "../log.h"
+#include "../meshfile.h"
+#include "meshoptimize.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Konwerter OBJ -> .mesh. Cała praca, której nie chcemy robić przy starcie silnika (parsowanie tekstu,
+// deduplikacja wierzchołków, kwantyzacja), dzieje się tutaj, a silnik tylko mapuje gotowy plik.
+
+namespace
+{
+    struct ObjMesh
+    {
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indices;
+        bool hasNormals = false;
+    };
+
+    // indeks OBJ: 1-based, ujemny liczony od końca, 0 = brak
+    int resolveIndex(int index, size_t count)
+    {
+        if(index < 0)
+        {
+            return static_cast<int>(count) + index;
+        }
+        return index - 1;
+    }
+
+    ObjMesh loadObj(const std::string& path)
+    {
+        std::ifstream input(path);
+        if(!input)
+        {
+            throw std::runtime_error("failed to open " + path);
+        }
+
+        std::vector<Vector3> positions;
+        std::vector<Vector4> colors;
+        std::vector<Vector3> normals;
+        std::unordered_map<uint64_t, uint32_t> vertexMap; // (pozycja, normalna) -> wierzchołek wyjściowy
+        ObjMesh mesh;
+        mesh.hasNormals = true;
+
+        std::string line;
+        std::vector<uint32_t> face;
+        while(std::getline(input, line))
+        {
+            std::istringstream stream(line);
+            std::string keyword;
+            stream >> keyword;
+
+            if(keyword == "v")
+            {
+                Vector3 position;
+                Vector4 color {1.0f, 1.0f, 1.0f, 1.0f};
+                stream >> position.x >> position.y >> position.z;
+                float r, g, b;
+                if(stream >> r >> g >> b) // rozszerzenie "v x y z r g b"
+                {
+                    color = {r, g, b, 1.0f};
+                }
+                positions.push_back(position);
+                colors.push_back(color);
+            }
+            else if(keyword == "vn")
+            {
+                Vector3 normal;
+                stream >> normal.x >> normal.y >> normal.z;
+                normals.push_back(normal);
+            }
+            else if(keyword == "f")
+            {
+                face.clear();
+                std::string corner;
+                while(stream >> corner)
+                {
+                    // v, v/vt, v//vn, v/vt/vn - tekstury nie są używane
+                    int positionIndex = 0;
+                    int normalIndex = 0;
+                    const size_t firstSlash = corner.find('/');
+                    positionIndex = resolveIndex(std::stoi(corner.substr(0, firstSlash)), positions.size());
+                    if(firstSlash != std::string::npos)
+                    {
+                        const size_t secondSlash = corner.find('/', firstSlash + 1);
+                        if(secondSlash != std::string::npos && secondSlash + 1 < corner.size())
+                        {
+                            normalIndex = resolveIndex(std::stoi(corner.substr(secondSlash + 1)), normals.size()) + 1;
+                        }
+                    }
+                    if(positionIndex < 0 || size_t(positionIndex) >= positions.size() || size_t(normalIndex) > normals.size())
+                    {
+                        throw std::runtime_error(path + ": face index out of range");
+                    }
+                    mesh.hasNormals = mesh.hasNormals && normalIndex > 0;
+
+                    const uint64_t key = (uint64_t(positionIndex) << 32) | uint32_t(normalIndex);
+                    const auto found = vertexMap.find(key);
+                    if(found != vertexMap.end())
+                    {
+                        face.push_back(found->second);
+                        continue;
+                    }
+
+                    MeshVertex vertex;
+                    vertex.position = positions[positionIndex];
+                    vertex.color = colors[positionIndex];
+                    if(normalIndex > 0)
+                    {
+                        vertex.normal = normalize(normals[normalIndex - 1]);
+                    }
+                    const uint32_t index = static_cast<uint32_t>(mesh.vertices.size());
+                    mesh.vertices.push_back(vertex);
+                    vertexMap.emplace(key, index);
+                    face.push_back(index);
+                }
+
+                // wielokąty wypukłe - wachlarz trójkątów
+                for(size_t i = 2; i < face.size(); i++)
+                {
+                    mesh.indices.push_back(face[0]);
+                    mesh.indices.push_back(face[i - 1]);
+                    mesh.indices.push_back(face[i]);
+                }
+            }
+        }
+
+        if(mesh.indices.empty())
+        {
+            throw std::runtime_error(path + " has no faces");
+        }
+        return mesh;
+    }
+
+    // normalne ważone polem trójkątów, gdy OBJ ich nie ma
+    void computeNormals(ObjMesh& mesh)
+    {
+        std::vector<Vector3> accumulated(mesh.vertices.size());
+        for(size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            const Vector3& a = mesh.vertices[mesh.indices[i]].position;
+            const Vector3& b = mesh.vertices[mesh.indices[i + 1]].position;
+            const Vector3& c = mesh.vertices[mesh.indices[i + 2]].position;
+            const Vector3 normal = cross(b - a, c - a);
+            for(size_t corner = 0; corner < 3; corner++)
+            {
+                accumulated[mesh.indices[i + corner]] = accumulated[mesh.indices[i + corner]] + normal;
+            }
+        }
+        for(size_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            const float len = length(accumulated[i]);
+            mesh.vertices[i].normal = len > 0.0f ? accumulated[i] * (1.0f / len) : Vector3 {0.0f, 0.0f, 1.0f};
+        }
+    }
+
+    void computeBounds(const std::vector<MeshVertex>& vertices, MeshData& mesh)
+    {
+        Vector3 boundsMin = vertices[0].position;
+        Vector3 boundsMax = vertices[0].position;
+        for(const MeshVertex& vertex : vertices)
+        {
+            for(int axis = 0; axis < 3; axis++)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], vertex.position[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], vertex.position[axis]);
+            }
+        }
+
+        // sfera wokół środka AABB - nie minimalna, ale wystarcza do cullingu i wyboru LOD
+        const Vector3 center = (boundsMin + boundsMax) * 0.5f;
+        float radius = 0.0f;
+        for(const MeshVertex& vertex : vertices)
+        {
+            radius = std::max(radius, length(vertex.position - center));
+        }
+
+        mesh.boundsMin = boundsMin;
+        mesh.boundsMax = boundsMax;
+        mesh.boundingSphere = Vector4(center, radius);
+    }
+
+    struct LodIndices
+    {
+        std::vector<uint32_t> indices;
+        float error; // względem promienia sfery otaczającej
+    };
+
+    // każdy LOD upraszczany z pełnej siatki, z celem o połowę mniejszym od poprzedniego;
+    // koniec, gdy kolejny poziom prawie nic nie upraszcza
+    std::vector<LodIndices> generateLods(const ObjMesh& mesh, uint32_t lodCount, float radius)
+    {
+        std::vector<LodIndices> lods;
+        lods.push_back({mesh.indices, 0.0f});
+        while(lods.size() < lodCount)
+        {
+            const size_t previousCount = lods.back().indices.size();
+            float error = 0.0f;
+            std::vector<uint32_t> indices = simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(),
+                                                         previousCount / 6 * 3, error);
+            if(indices.empty() || indices.size() * 10 > previousCount * 9)
+            {
+                break;
+            }
+            lods.push_back({std::move(indices), radius > 0.0f ? error / radius : 0.0f});
+        }
+        return lods;
+    }
+
+    // cache wierzchołków -> overdraw, osobno dla każdego LOD-u; ACMR/ATVR LOD-u 0 dla FIFO o 16 wpisach
+    void optimizeLods(const ObjMesh& mesh, std::vector<LodIndices>& lods)
+    {
+        const VertexCacheStatistics before = analyzeVertexCache(lods[0].indices.data(), lods[0].indices.size(), mesh.vertices.size());
+        VertexCacheStatistics cacheOptimized;
+
+        for(size_t lod = 0; lod < lods.size(); lod++)
+        {
+            std::vector<uint32_t>& indices = lods[lod].indices;
+            optimizeVertexCache(indices.data(), indices.size(), mesh.vertices.size());
+            if(lod == 0)
+            {
+                cacheOptimized = analyzeVertexCache(indices.data(), indices.size(), mesh.vertices.size());
+            }
+            optimizeOverdraw(indices.data(), indices.size(), mesh.vertices.data(), mesh.vertices.size());
+        }
+
+        const VertexCacheStatistics after = analyzeVertexCache(lods[0].indices.data(), lods[0].indices.size(), mesh.vertices.size());
+        logger::info("ACMR ", before.acmr, " -> ", after.acmr, " (cache only: ", cacheOptimized.acmr, "), ATVR ", before.atvr, " -> ", after.atvr);
+    }
+
+    // tak samo ściśle jak flagi silnika w main.cpp: cały tekst to liczba, bez minusa (strtoull go zawija) i w zakresie uint32_t
+    bool parseUnsigned(const char* text, uint32_t& value)
+    {
+        char* end = nullptr;
+        errno = 0;
+        const unsigned long long parsed = std::strtoull(text, &end, 10);
+        if(end == text || *end != '\0' || std::strchr(text, '-') != nullptr || errno == ERANGE || parsed > UINT32_MAX)
+        {
+            return false;
+        }
+        value = static_cast<uint32_t>(parsed);
+        return true;
+    }
+
+    void printUsage()
+    {
+        logger::info("usage: mesh_converter <input.obj> <output.mesh> [--layout full|compact|half] [--no-optimize] [--lods <n>]");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const std::string inputPath = argv[1];
+    const std::string outputPath = argv[2];
+    VertexLayoutType layoutType = VertexLayoutType::Compact;
+    bool optimize = true;
+    uint32_t lodCount = 4;
+
+    for(int i = 3; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+
+        if(std::strcmp(argv[i], "--layout") == 0 && hasValue)
+        {
+            const char* value = argv[++i];
+            if(std::strcmp(value, "full") == 0)
+            {
+                layoutType = VertexLayoutType::Full;
+            }
+            else if(std::strcmp(value, "compact") == 0)
+            {
+                layoutType = VertexLayoutType::Compact;
+            }
+            else if(std::strcmp(value, "half") == 0)
+            {
+                layoutType = VertexLayoutType::CompactHalf;
+            }
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "--lods") == 0 && hasValue)
+        {
+            const char* value = argv[++i];
+            if(!parseUnsigned(value, lodCount))
+            {
+                logger::error("invalid value for --lods: ", value);
+                printUsage();
+                return 1;
+            }
+            lodCount = std::min<uint32_t>(std::max<uint32_t>(lodCount, 1), maxMeshLodCount);
+        }
+        else if(std::strcmp(argv[i], "--no-optimize") == 0)
+        {
+            optimize = false;
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        ObjMesh obj = loadObj(inputPath);
+        if(!obj.hasNormals)
+        {
+            computeNormals(obj);
+        }
+
+        MeshData mesh;
+        computeBounds(obj.vertices, mesh);
+        std::vector<LodIndices> lods = generateLods(obj, lodCount, mesh.boundingSphere.w);
+        if(optimize)
+        {
+            optimizeLods(obj, lods);
+        }
+
+        // wszystkie LOD-y w jednym buforze indeksów, wierzchołki wspólne
+        obj.indices.clear();
+        for(size_t lod = 0; lod < lods.size(); lod++)
+        {
+            mesh.lods.push_back({static_cast<uint32_t>(obj.indices.size()), static_cast<uint32_t>(lods[lod].indices.size()), lods[lod].error, 0});
+            obj.indices.insert(obj.indices.end(), lods[lod].indices.begin(), lods[lod].indices.end());
+            logger::info("LOD ", lod, ": ", lods[lod].indices.size() / 3, " triangles, error ", lods[lod].error);
+        }
+        if(optimize)
+        {
+            optimizeVertexFetch(obj.vertices, obj.indices.data(), obj.indices.size());
+        }
+
+        mesh.layout = VertexLayout::create(layoutType);
+        mesh.quantization = computeQuantization(mesh.layout, obj.vertices.data(), obj.vertices.size());
+        mesh.vertexCount = static_cast<uint32_t>(obj.vertices.size());
+        mesh.vertices.resize(obj.vertices.size() * mesh.layout.stride);
+        encodeVertices(mesh.layout, mesh.quantization, obj.vertices.data(), obj.vertices.size(), mesh.vertices.data());
+        mesh.indices = std::move(obj.indices);
+
+        writeMeshFile(outputPath, mesh);
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        logger::info(inputPath, " -> ", outputPath, ": ", mesh.vertexCount, " vertices (", vertexLayoutName(layoutType), ", ",
+                     mesh.layout.stride, " B), ", mesh.lods[0].indexCount / 3, " triangles, ", mesh.lods.size(), " LODs, ", mesh.vertexCount <= 0x10000 ? 16 : 32, "-bit indices, ", ms, " ms");
+    }
+    catch(const std::exception& e)
+    {
+        logger::error(e.what());
+        return 1;
+    }
+    return 0;
+}
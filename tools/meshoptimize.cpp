@@ -0,0 +1,554 @@
+#include "meshoptimize.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t invalidIndex = ~0u;
+
+    /*------ vertex cache (Forsyth) ------*/
+    constexpr int cacheSize = 32;
+    constexpr float lastTriangleScore = 0.75f;
+    constexpr float cacheDecayPower = 1.5f;
+    constexpr float valenceBoostScale = 2.0f;
+    constexpr float valenceBoostPower = 0.5f;
+
+    float vertexScore(int cachePosition, uint32_t remainingTriangles)
+    {
+        if(remainingTriangles == 0)
+        {
+            return -1.0f; // nikt już nie używa tego wierzchołka
+        }
+
+        float score = 0.0f;
+        if(cachePosition >= 0)
+        {
+            // trzy wierzchołki ostatniego trójkąta dostają stałą ocenę, żeby nie faworyzować strip-ów
+            if(cachePosition < 3)
+            {
+                score = lastTriangleScore;
+            }
+            else
+            {
+                const float scale = 1.0f / (cacheSize - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scale, cacheDecayPower);
+            }
+        }
+        // wierzchołki z małą liczbą pozostałych trójkątów warto skończyć szybko
+        score += valenceBoostScale * std::pow(float(remainingTriangles), -valenceBoostPower);
+        return score;
+    }
+
+    /*------------ overdraw ------------*/
+    // granice "twarde" - trójkąty, przy których symulowany cache nie trafia w żaden wierzchołek,
+    // czyli miejsca, w których optymalizator cache'u zaczął nowy region
+    std::vector<uint32_t> findHardBoundaries(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+    {
+        std::vector<uint32_t> clusters;
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+
+        for(size_t triangle = 0; triangle < indexCount / 3; triangle++)
+        {
+            uint32_t misses = 0;
+            for(size_t corner = 0; corner < 3; corner++)
+            {
+                const uint32_t vertex = indices[triangle * 3 + corner];
+                if(time - timestamps[vertex] > cacheSize)
+                {
+                    timestamps[vertex] = time++;
+                    misses++;
+                }
+            }
+            if(triangle == 0 || misses == 3)
+            {
+                clusters.push_back(static_cast<uint32_t>(triangle));
+            }
+        }
+        return clusters;
+    }
+
+    // granice "miękkie" - w środku twardego klastra dzielimy, kiedy ACMR bieżącego kawałka
+    // jest nie gorszy niż ACMR całego klastra * threshold
+    std::vector<uint32_t> findSoftBoundaries(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                             const std::vector<uint32_t>& hardClusters, float threshold)
+    {
+        std::vector<uint32_t> clusters;
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        uint32_t time = 0;
+        const size_t triangleCount = indexCount / 3;
+
+        for(size_t cluster = 0; cluster < hardClusters.size(); cluster++)
+        {
+            const size_t start = hardClusters[cluster];
+            const size_t end = cluster + 1 < hardClusters.size() ? hardClusters[cluster + 1] : triangleCount;
+
+            // najpierw ACMR całego klastra, przy zimnym cache'u
+            time += cacheSize + 1;
+            uint32_t clusterMisses = 0;
+            for(size_t i = start * 3; i < end * 3; i++)
+            {
+                if(time - timestamps[indices[i]] > cacheSize)
+                {
+                    timestamps[indices[i]] = time++;
+                    clusterMisses++;
+                }
+            }
+            const float limit = threshold * float(clusterMisses) / float(end - start);
+
+            // potem to samo jeszcze raz, zaczynając nowy kawałek (znowu z zimnym cache'em) za każdym razem, gdy mieści się w limicie
+            time += cacheSize + 1;
+            clusters.push_back(static_cast<uint32_t>(start));
+            uint32_t misses = 0;
+            size_t triangles = 0;
+            for(size_t triangle = start; triangle < end; triangle++)
+            {
+                for(size_t corner = 0; corner < 3; corner++)
+                {
+                    const uint32_t vertex = indices[triangle * 3 + corner];
+                    if(time - timestamps[vertex] > cacheSize)
+                    {
+                        timestamps[vertex] = time++;
+                        misses++;
+                    }
+                }
+                triangles++;
+
+                if(triangle + 1 < end && float(misses) / float(triangles) <= limit)
+                {
+                    clusters.push_back(static_cast<uint32_t>(triangle + 1));
+                    time += cacheSize + 1;
+                    misses = 0;
+                    triangles = 0;
+                }
+            }
+        }
+        return clusters;
+    }
+
+    /*---------- simplification ----------*/
+    // symetryczna macierz 4x4 kwadryki płaszczyzny (a, b, c, d): Q = p * p^T, zapisana jako 10 elementów
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+        void add(const Quadric& q)
+        {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+            bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        }
+
+        double error(const Vector3& p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                 + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                 + c2 * z * z + 2 * cd * z
+                 + d2;
+        }
+    };
+
+    Quadric planeQuadric(const Vector3& normal, float d, float weight)
+    {
+        Quadric q;
+        q.a2 = weight * normal.x * normal.x; q.ab = weight * normal.x * normal.y; q.ac = weight * normal.x * normal.z; q.ad = weight * normal.x * d;
+        q.b2 = weight * normal.y * normal.y; q.bc = weight * normal.y * normal.z; q.bd = weight * normal.y * d;
+        q.c2 = weight * normal.z * normal.z; q.cd = weight * normal.z * d;
+        q.d2 = weight * d * d;
+        return q;
+    }
+
+    // jedna rozdzielczość siatki: indeksy po zwinięciu komórek, bez zdegenerowanych i powtórzonych trójkątów
+    std::vector<uint32_t> clusterVertices(const uint32_t* indices, size_t indexCount, const MeshVertex* vertices, size_t vertexCount,
+                                          const std::vector<Quadric>& quadrics, const Vector3& boundsMin, float extent,
+                                          uint32_t gridSize, float& error)
+    {
+        const float cellScale = float(gridSize) / extent;
+        std::vector<uint32_t> cells(vertexCount);
+        for(size_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            uint32_t cell = 0;
+            for(int axis = 2; axis >= 0; axis--)
+            {
+                const float coordinate = (vertices[vertex].position[axis] - boundsMin[axis]) * cellScale;
+                const uint32_t index = std::min(uint32_t(std::max(coordinate, 0.0f)), gridSize - 1);
+                cell = cell * gridSize + index;
+            }
+            cells[vertex] = cell;
+        }
+
+        // kwadryka komórki = suma kwadryk jej wierzchołków, reprezentant minimalizuje jej błąd
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return cells[a] < cells[b]; });
+
+        std::vector<uint32_t> remap(vertexCount);
+        float maxDistance2 = 0.0f;
+        for(size_t begin = 0; begin < vertexCount;)
+        {
+            size_t end = begin;
+            Quadric cellQuadric;
+            while(end < vertexCount && cells[order[end]] == cells[order[begin]])
+            {
+                cellQuadric.add(quadrics[order[end]]);
+                end++;
+            }
+
+            uint32_t representative = order[begin];
+            double bestError = cellQuadric.error(vertices[representative].position);
+            for(size_t i = begin + 1; i < end; i++)
+            {
+                const double candidateError = cellQuadric.error(vertices[order[i]].position);
+                if(candidateError < bestError)
+                {
+                    bestError = candidateError;
+                    representative = order[i];
+                }
+            }
+            for(size_t i = begin; i < end; i++)
+            {
+                remap[order[i]] = representative;
+                const Vector3 offset = vertices[order[i]].position - vertices[representative].position;
+                maxDistance2 = std::max(maxDistance2, dot(offset, offset));
+            }
+            begin = end;
+        }
+        error = std::sqrt(maxDistance2);
+
+        // trójkąt obrócony tak, żeby najmniejszy indeks był pierwszy - zachowuje nawinięcie i pozwala wykryć duplikaty
+        std::vector<std::array<uint32_t, 3>> triangles;
+        triangles.reserve(indexCount / 3);
+        for(size_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            std::array<uint32_t, 3> triangle = {remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]]};
+            if(triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2])
+            {
+                continue;
+            }
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+
+        std::vector<uint32_t> result;
+        result.reserve(triangles.size() * 3);
+        for(const std::array<uint32_t, 3>& triangle : triangles)
+        {
+            result.insert(result.end(), triangle.begin(), triangle.end());
+        }
+        return result;
+    }
+}
+
+VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t fifoSize)
+{
+    VertexCacheStatistics statistics;
+    if(indexCount < 3)
+    {
+        return statistics;
+    }
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint32_t time = fifoSize + 1;
+    size_t misses = 0;
+    size_t uniqueVertices = 0;
+
+    for(size_t i = 0; i < indexCount; i++)
+    {
+        const uint32_t vertex = indices[i];
+        // FIFO: trafienie nie odświeża pozycji w kolejce, więc wystarczy czas wstawienia
+        if(time - timestamps[vertex] > fifoSize)
+        {
+            timestamps[vertex] = time++;
+            misses++;
+        }
+        if(!used[vertex])
+        {
+            used[vertex] = true;
+            uniqueVertices++;
+        }
+    }
+
+    statistics.acmr = float(misses) / float(indexCount / 3);
+    statistics.atvr = float(misses) / float(uniqueVertices);
+    return statistics;
+}
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    const size_t triangleCount = indexCount / 3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    // trójkąty każdego wierzchołka: adjacency[offsets[v] .. offsets[v] + remaining[v]), wyemitowane są wyrzucane na koniec zakresu
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for(size_t i = 0; i < indexCount; i++)
+    {
+        remaining[indices[i]]++;
+    }
+    std::vector<uint32_t> offsets(vertexCount, 0);
+    std::exclusive_scan(remaining.begin(), remaining.end(), offsets.begin(), 0u);
+    std::vector<uint32_t> adjacency(indexCount);
+    {
+        std::vector<uint32_t> cursor = offsets;
+        for(size_t i = 0; i < indexCount; i++)
+        {
+            adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for(size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        vertexScores[vertex] = vertexScore(-1, remaining[vertex]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t bestTriangle = 0;
+    for(size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+        if(triangleScores[triangle] > triangleScores[bestTriangle])
+        {
+            bestTriangle = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(cacheSize + 3);
+    newCache.reserve(cacheSize + 3);
+    size_t scanCursor = 0;
+
+    while(result.size() < indexCount)
+    {
+        if(bestTriangle == invalidIndex)
+        {
+            // ślepy zaułek - nic w cache'u nie ma już trójkątów, bierzemy następny niewyemitowany
+            while(emitted[scanCursor])
+            {
+                scanCursor++;
+            }
+            bestTriangle = static_cast<uint32_t>(scanCursor);
+        }
+
+        emitted[bestTriangle] = true;
+        newCache.clear();
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t vertex = indices[bestTriangle * 3 + corner];
+            result.push_back(vertex);
+            newCache.push_back(vertex);
+
+            uint32_t* begin = adjacency.data() + offsets[vertex];
+            uint32_t* end = begin + remaining[vertex];
+            std::iter_swap(std::find(begin, end, bestTriangle), end - 1);
+            remaining[vertex]--;
+        }
+        for(uint32_t vertex : cache)
+        {
+            if(vertex != newCache[0] && vertex != newCache[1] && vertex != newCache[2])
+            {
+                newCache.push_back(vertex);
+            }
+        }
+
+        // nowe pozycje w LRU (wypchnięte poza cacheSize tracą bonus) i przeliczenie ocen sąsiednich trójkątów
+        for(size_t position = 0; position < newCache.size(); position++)
+        {
+            const uint32_t vertex = newCache[position];
+            cachePositions[vertex] = position < size_t(cacheSize) ? int(position) : -1;
+            const float score = vertexScore(cachePositions[vertex], remaining[vertex]);
+            const float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            for(uint32_t i = 0; i < remaining[vertex]; i++)
+            {
+                triangleScores[adjacency[offsets[vertex] + i]] += delta;
+            }
+        }
+
+        bestTriangle = invalidIndex;
+        float bestScore = -1.0f;
+        newCache.resize(std::min(newCache.size(), size_t(cacheSize)));
+        for(uint32_t vertex : newCache)
+        {
+            for(uint32_t i = 0; i < remaining[vertex]; i++)
+            {
+                const uint32_t triangle = adjacency[offsets[vertex] + i];
+                if(triangleScores[triangle] > bestScore)
+                {
+                    bestScore = triangleScores[triangle];
+                    bestTriangle = triangle;
+                }
+            }
+        }
+        std::swap(cache, newCache);
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void optimizeOverdraw(uint32_t* indices, size_t indexCount, const MeshVertex* vertices, size_t vertexCount, float threshold)
+{
+    const size_t triangleCount = indexCount / 3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    const std::vector<uint32_t> hardClusters = findHardBoundaries(indices, indexCount, vertexCount);
+    const std::vector<uint32_t> clusters = findSoftBoundaries(indices, indexCount, vertexCount, hardClusters, threshold);
+
+    // środek siatki ważony polem trójkątów
+    Vector3 meshCentroid;
+    float meshArea = 0.0f;
+    for(size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        const Vector3& a = vertices[indices[triangle * 3]].position;
+        const Vector3& b = vertices[indices[triangle * 3 + 1]].position;
+        const Vector3& c = vertices[indices[triangle * 3 + 2]].position;
+        const float area = length(cross(b - a, c - a));
+        meshCentroid = meshCentroid + (a + b + c) * (area / 3.0f);
+        meshArea += area;
+    }
+    meshCentroid = meshCentroid * (meshArea > 0.0f ? 1.0f / meshArea : 0.0f);
+
+    // klaster skierowany na zewnątrz (normalna zgodna z kierunkiem od środka) zasłania resztę - rysujemy go wcześniej
+    std::vector<float> sortKeys(clusters.size());
+    for(size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        const size_t start = clusters[cluster];
+        const size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+
+        Vector3 centroid;
+        Vector3 normal;
+        float area = 0.0f;
+        for(size_t triangle = start; triangle < end; triangle++)
+        {
+            const Vector3& a = vertices[indices[triangle * 3]].position;
+            const Vector3& b = vertices[indices[triangle * 3 + 1]].position;
+            const Vector3& c = vertices[indices[triangle * 3 + 2]].position;
+            const Vector3 triangleNormal = cross(b - a, c - a);
+            const float triangleArea = length(triangleNormal);
+            centroid = centroid + (a + b + c) * (triangleArea / 3.0f);
+            normal = normal + triangleNormal;
+            area += triangleArea;
+        }
+        centroid = centroid * (area > 0.0f ? 1.0f / area : 0.0f);
+        const float normalLength = length(normal);
+        normal = normal * (normalLength > 0.0f ? 1.0f / normalLength : 0.0f);
+
+        sortKeys[cluster] = dot(centroid - meshCentroid, normal);
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    for(uint32_t cluster : order)
+    {
+        const size_t start = clusters[cluster];
+        const size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+        result.insert(result.end(), indices + start * 3, indices + end * 3);
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void optimizeVertexFetch(std::vector<MeshVertex>& vertices, uint32_t* indices, size_t indexCount)
+{
+    std::vector<uint32_t> remap(vertices.size(), invalidIndex);
+    std::vector<MeshVertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for(size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t& target = remap[indices[i]];
+        if(target == invalidIndex)
+        {
+            target = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[indices[i]]);
+        }
+        indices[i] = target;
+    }
+    vertices = std::move(reordered);
+}
+
+std::vector<uint32_t> simplifyMesh(const uint32_t* indices, size_t indexCount, const MeshVertex* vertices, size_t vertexCount,
+                                   size_t targetIndexCount, float& error)
+{
+    error = 0.0f;
+    if(indexCount <= targetIndexCount || vertexCount == 0)
+    {
+        return std::vector<uint32_t>(indices, indices + indexCount);
+    }
+
+    // kwadryki wierzchołków z płaszczyzn sąsiednich trójkątów, ważone polem
+    std::vector<Quadric> quadrics(vertexCount);
+    for(size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        const Vector3& a = vertices[indices[i]].position;
+        const Vector3& b = vertices[indices[i + 1]].position;
+        const Vector3& c = vertices[indices[i + 2]].position;
+        const Vector3 normal = cross(b - a, c - a);
+        const float area = length(normal);
+        if(area <= 0.0f)
+        {
+            continue;
+        }
+        const Vector3 unitNormal = normal * (1.0f / area);
+        const Quadric q = planeQuadric(unitNormal, -dot(unitNormal, a), area);
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            quadrics[indices[i + corner]].add(q);
+        }
+    }
+
+    Vector3 boundsMin = vertices[0].position;
+    Vector3 boundsMax = vertices[0].position;
+    for(size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        for(int axis = 0; axis < 3; axis++)
+        {
+            boundsMin[axis] = std::min(boundsMin[axis], vertices[vertex].position[axis]);
+            boundsMax[axis] = std::max(boundsMax[axis], vertices[vertex].position[axis]);
+        }
+    }
+    const float extent = std::max(std::max(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y), std::max(boundsMax.z - boundsMin.z, 1e-6f));
+
+    // liczba trójkątów rośnie (prawie) monotonicznie z rozdzielczością - wyszukiwanie binarne największej, która się mieści
+    std::vector<uint32_t> best;
+    float bestError = 0.0f;
+    uint32_t low = 1;
+    uint32_t high = 1024; // 1024^3 komórek mieści się jeszcze w uint32_t
+    while(low <= high)
+    {
+        const uint32_t gridSize = (low + high) / 2;
+        float gridError = 0.0f;
+        std::vector<uint32_t> result = clusterVertices(indices, indexCount, vertices, vertexCount, quadrics, boundsMin, extent, gridSize, gridError);
+        if(result.size() <= targetIndexCount)
+        {
+            best = std::move(result);
+            bestError = gridError;
+            low = gridSize + 1;
+        }
+        else
+        {
+            high = gridSize - 1;
+        }
+    }
+
+    error = bestError;
+    return best;
+}
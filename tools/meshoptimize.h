@@ -0,0 +1,37 @@
+#ifndef MESHOPTIMIZE_H
+#define MESHOPTIMIZE_H
+#include "../vertexformat.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Optymalizacje kolejności indeksów/wierzchołków dla konwertera. Wszystko działa na liście trójkątów
+// i nie zmienia geometrii - tylko kolejność rysowania i pobierania wierzchołków.
+
+struct VertexCacheStatistics
+{
+    float acmr = 0.0f; // średnia liczba chybień cache'u na trójkąt (0.5 - ideał dla dużych siatek, 3 - brak reużycia)
+    float atvr = 0.0f; // chybienia na unikalny wierzchołek (1 - ideał)
+};
+
+// symulacja FIFO cache'u post-transform o podanym rozmiarze
+VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16);
+
+// kolejność trójkątów pod cache wierzchołków (Forsyth, LRU o 32 wpisach)
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Dzieli wynik optimizeVertexCache na klastry i sortuje je tak, żeby zewnętrzne powierzchnie szły pierwsze
+// (mniej overdraw przy teście głębokości). threshold - o ile może się pogorszyć ACMR w zamian za mniejsze klastry.
+void optimizeOverdraw(uint32_t* indices, size_t indexCount, const MeshVertex* vertices, size_t vertexCount, float threshold = 1.05f);
+
+// Układa wierzchołki w kolejności pierwszego użycia i przepisuje indeksy. Nieużywane wierzchołki wypadają.
+void optimizeVertexFetch(std::vector<MeshVertex>& vertices, uint32_t* indices, size_t indexCount);
+
+// Uproszczenie przez klastrowanie wierzchołków na siatce 3D: każda komórka zwija się do jednego istniejącego
+// wierzchołka (tego z najmniejszym błędem kwadryk komórki), więc LOD-y dzielą bufor wierzchołków i różnią się
+// tylko indeksami. Rozdzielczość siatki dobierana tak, żeby nie przekroczyć targetIndexCount.
+// error - największe przesunięcie wierzchołka w jednostkach modelu.
+std::vector<uint32_t> simplifyMesh(const uint32_t* indices, size_t indexCount, const MeshVertex* vertices, size_t vertexCount,
+                                   size_t targetIndexCount, float& error);
+
+#endif // MESHOPTIMIZE_H
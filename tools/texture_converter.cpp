@@ -0,0 +1,234 @@
+#include "../log.h"
+#include "../texturefile.h"
+#include <vulkan.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Konwerter DDS -> .tex. Kompresję blokową (BCn) robi zewnętrzne narzędzie (texconv, compressonator),
+// tutaj tylko przepakowujemy gotowe bloki i mipy tak, żeby silnik mógł je strumieniować prosto z pliku.
+
+namespace
+{
+    constexpr uint32_t ddsMagic = 0x20534444; // "DDS "
+    constexpr uint32_t ddsFlagMipCount = 0x20000;
+    constexpr uint32_t ddsPixelFormatFourCC = 0x4;
+
+    constexpr uint32_t fourCC(char a, char b, char c, char d)
+    {
+        return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+    }
+
+    struct DdsPixelFormat
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t masks[4];
+    };
+
+    struct DdsHeader
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DdsPixelFormat pixelFormat;
+        uint32_t caps[4];
+        uint32_t reserved2;
+    };
+
+    struct DdsHeaderDx10
+    {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    static_assert(sizeof(DdsHeader) == 124 && sizeof(DdsHeaderDx10) == 20, "DDS header layout");
+
+    struct FormatInfo
+    {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t blockWidth = 4;
+        uint32_t blockHeight = 4;
+        uint32_t blockSize = 16;
+    };
+
+    FormatInfo dxgiFormatInfo(uint32_t dxgiFormat)
+    {
+        switch(dxgiFormat)
+        {
+            case 28: return {VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4};
+            case 29: return {VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 4};
+            case 71: return {VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8};
+            case 72: return {VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 4, 8};
+            case 77: return {VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16};
+            case 78: return {VK_FORMAT_BC3_SRGB_BLOCK, 4, 4, 16};
+            case 80: return {VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8};
+            case 83: return {VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16};
+            case 98: return {VK_FORMAT_BC7_UNORM_BLOCK, 4, 4, 16};
+            case 99: return {VK_FORMAT_BC7_SRGB_BLOCK, 4, 4, 16};
+            default: throw std::runtime_error("unsupported DXGI format " + std::to_string(dxgiFormat));
+        }
+    }
+
+    FormatInfo fourCCFormatInfo(uint32_t code)
+    {
+        if(code == fourCC('D', 'X', 'T', '1')) return {VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8};
+        if(code == fourCC('D', 'X', 'T', '5')) return {VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16};
+        if(code == fourCC('A', 'T', 'I', '1') || code == fourCC('B', 'C', '4', 'U')) return {VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8};
+        if(code == fourCC('A', 'T', 'I', '2') || code == fourCC('B', 'C', '5', 'U')) return {VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16};
+        throw std::runtime_error("unsupported DDS fourCC");
+    }
+
+    // sRGB jest w DDS tylko w nagłówku DX10 - dla starych plików trzeba to powiedzieć z linii poleceń
+    VkFormat toSrgb(VkFormat format)
+    {
+        switch(format)
+        {
+            case VK_FORMAT_R8G8B8A8_UNORM: return VK_FORMAT_R8G8B8A8_SRGB;
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+            case VK_FORMAT_BC3_UNORM_BLOCK: return VK_FORMAT_BC3_SRGB_BLOCK;
+            case VK_FORMAT_BC7_UNORM_BLOCK: return VK_FORMAT_BC7_SRGB_BLOCK;
+            default: return format; // BC4/BC5 to dane, nie kolor
+        }
+    }
+
+    TextureData loadDds(const std::string& path, bool srgb)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if(!input)
+        {
+            throw std::runtime_error("failed to open " + path);
+        }
+        const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+        uint32_t magic = 0;
+        DdsHeader header {};
+        if(bytes.size() < sizeof(magic) + sizeof(header))
+        {
+            throw std::runtime_error(path + " is too small for a DDS file");
+        }
+        std::memcpy(&magic, bytes.data(), sizeof(magic));
+        std::memcpy(&header, bytes.data() + sizeof(magic), sizeof(header));
+        if(magic != ddsMagic || header.size != sizeof(DdsHeader))
+        {
+            throw std::runtime_error(path + " is not a DDS file");
+        }
+
+        size_t offset = sizeof(magic) + sizeof(header);
+        FormatInfo info;
+        if((header.pixelFormat.flags & ddsPixelFormatFourCC) && header.pixelFormat.fourCC == fourCC('D', 'X', '1', '0'))
+        {
+            DdsHeaderDx10 dx10 {};
+            if(bytes.size() < offset + sizeof(dx10))
+            {
+                throw std::runtime_error(path + ": truncated DX10 header");
+            }
+            std::memcpy(&dx10, bytes.data() + offset, sizeof(dx10));
+            offset += sizeof(dx10);
+            if(dx10.arraySize > 1 || dx10.resourceDimension != 3) // 3 - TEXTURE2D
+            {
+                throw std::runtime_error(path + ": only single 2D textures are supported");
+            }
+            info = dxgiFormatInfo(dx10.dxgiFormat);
+        }
+        else if(header.pixelFormat.flags & ddsPixelFormatFourCC)
+        {
+            info = fourCCFormatInfo(header.pixelFormat.fourCC);
+        }
+        else
+        {
+            throw std::runtime_error(path + ": uncompressed DDS without a DX10 header is not supported");
+        }
+
+        TextureData texture;
+        texture.format = srgb ? toSrgb(info.format) : info.format;
+        texture.width = header.width;
+        texture.height = header.height;
+        texture.blockWidth = info.blockWidth;
+        texture.blockHeight = info.blockHeight;
+        texture.blockSize = info.blockSize;
+
+        const uint32_t mipCount = std::clamp<uint32_t>((header.flags & ddsFlagMipCount) ? header.mipMapCount : 1, 1, maxTextureMipCount);
+        for(uint32_t level = 0; level < mipCount; level++)
+        {
+            const uint32_t width = std::max(header.width >> level, 1u);
+            const uint32_t height = std::max(header.height >> level, 1u);
+            const uint64_t size = textureMipSize(width, height, info.blockWidth, info.blockHeight, info.blockSize);
+            if(bytes.size() < offset + size)
+            {
+                throw std::runtime_error(path + ": truncated mip " + std::to_string(level));
+            }
+            texture.mips.emplace_back(bytes.begin() + offset, bytes.begin() + offset + size);
+            offset += size;
+        }
+        return texture;
+    }
+
+    void printUsage()
+    {
+        logger::info("usage: texture_converter <input.dds> <output.tex> [--srgb]");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const std::string inputPath = argv[1];
+    const std::string outputPath = argv[2];
+    bool srgb = false;
+
+    for(int i = 3; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--srgb") == 0)
+        {
+            srgb = true;
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const TextureData texture = loadDds(inputPath, srgb);
+        writeTextureFile(outputPath, texture);
+
+        uint64_t size = 0;
+        for(const auto& mip : texture.mips)
+        {
+            size += mip.size();
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        logger::info(inputPath, " -> ", outputPath, ": ", texture.width, "x", texture.height, ", format ", texture.format, ", ",
+                     texture.mips.size(), " mips, ", size >> 10, " KiB, ", ms, " ms");
+    }
+    catch(const std::exception& e)
+    {
+        logger::error(e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "trace.h"
+#include "log.h"
+#include "spscqueue.h"
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+std::atomic<bool> trace::detail::enabled {false};
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name = nullptr;
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        bool gpu = false;
+    };
+
+    // jeden na wątek, żyje do końca procesu - wątek może się skończyć, zanim wątek zapisu przepisze jego zdarzenia
+    struct ThreadBuffer
+    {
+        uint32_t id = 0;
+        std::string name; // pod registryMutex
+        SpscQueue<TraceEvent, 4096> events;  // producent - właściciel, konsument - wątek zapisu
+        std::atomic<uint64_t> dropped {0};   // zdarzenia, dla których bufor był pełny
+    };
+
+    constexpr uint32_t gpuTrackId = 0; // wątki dostają id od 1
+
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+    std::unordered_set<std::string> internedNames; // węzły się nie przesuwają, więc c_str() jest trwałe
+
+    // stan zapisu - start()/stop() z jednego wątku
+    std::FILE* file = nullptr;
+    bool firstEvent = true;
+
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+
+    ThreadBuffer& currentThreadBuffer()
+    {
+        if(threadBuffer == nullptr)
+        {
+            // pierwsze zdarzenie wątku - jedyna alokacja i jedyna blokada po stronie producenta
+            std::lock_guard<std::mutex> lock(registryMutex);
+            threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+            threadBuffers.back()->id = static_cast<uint32_t>(threadBuffers.size());
+            threadBuffer = threadBuffers.back().get();
+        }
+        return *threadBuffer;
+    }
+
+    void push(const TraceEvent& event)
+    {
+        ThreadBuffer& buffer = currentThreadBuffer();
+        if(!buffer.events.push(event))
+        {
+            buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    void writeEscaped(const char* text)
+    {
+        for(const char* c = text; *c != '\0'; c++)
+        {
+            if(*c == '"' || *c == '\\')
+            {
+                std::fputc('\\', file);
+            }
+            if(static_cast<unsigned char>(*c) >= 0x20)
+            {
+                std::fputc(*c, file);
+            }
+        }
+    }
+
+    void beginRecord()
+    {
+        std::fputs(firstEvent ? "\n" : ",\n", file);
+        firstEvent = false;
+    }
+
+    void writeThreadName(uint32_t threadId, const char* name)
+    {
+        beginRecord();
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", threadId);
+        writeEscaped(name);
+        std::fputs("\"}}", file);
+    }
+
+#if defined(ENGINE_TRACING)
+    // wątek zapisu - bez ENGINE_TRACING start() nigdy go nie uruchamia
+    constexpr auto flushInterval = std::chrono::milliseconds(5);
+    uint64_t startTime = 0; // zdarzenia zapisywane względem startu
+    std::thread writer;
+    std::mutex writerMutex;
+    std::condition_variable writerWake;
+    bool writerStopping = false;
+
+    void writeEvent(const TraceEvent& event, uint32_t threadId)
+    {
+        // ts i dur w mikrosekundach; czasy GPU po kalibracji mogą wypaść odrobinę przed startem
+        const double timestamp = (double(int64_t(event.begin - startTime))) / 1000.0;
+        const double duration = event.end > event.begin ? double(event.end - event.begin) / 1000.0 : 0.0;
+        beginRecord();
+        std::fputs("{\"name\":\"", file);
+        writeEscaped(event.name);
+        std::fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     event.gpu ? "gpu" : "cpu", event.gpu ? gpuTrackId : threadId, timestamp, duration);
+    }
+
+    void drain()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        TraceEvent event;
+        for(const auto& buffer : threadBuffers)
+        {
+            while(buffer->events.pop(event))
+            {
+                writeEvent(event, buffer->id);
+            }
+        }
+    }
+
+    void writerLoop()
+    {
+        std::unique_lock<std::mutex> lock(writerMutex);
+        while(!writerStopping)
+        {
+            writerWake.wait_for(lock, flushInterval);
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+#endif
+}
+
+bool trace::start(const std::string& path)
+{
+#if defined(ENGINE_TRACING)
+    if(file != nullptr)
+    {
+        logger::warning("trace: already writing, ignoring ", path);
+        return false;
+    }
+    file = std::fopen(path.c_str(), "w");
+    if(file == nullptr)
+    {
+        logger::error("trace: failed to open ", path);
+        return false;
+    }
+
+    // stare zdarzenia z buforów (poprzedni zapis) nie mają tu czego szukać
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        TraceEvent event;
+        for(const auto& buffer : threadBuffers)
+        {
+            while(buffer->events.pop(event)) {}
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    startTime = now();
+    firstEvent = true;
+    writerStopping = false;
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    writer = std::thread(writerLoop);
+    detail::enabled.store(true, std::memory_order_relaxed);
+    logger::info("trace: writing ", path);
+    return true;
+#else
+    logger::warning("trace: built without ENGINE_TRACING, ", path, " will not be written");
+    return false;
+#endif
+}
+
+void trace::stop()
+{
+    if(file == nullptr)
+    {
+        return;
+    }
+    detail::enabled.store(false, std::memory_order_relaxed);
+
+#if defined(ENGINE_TRACING)
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        writerStopping = true;
+    }
+    writerWake.notify_one();
+    writer.join();
+    drain(); // zdarzenia dopisane między ostatnim przebiegiem wątku a wyłączeniem
+#endif
+
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        writeThreadName(gpuTrackId, "GPU");
+        for(const auto& buffer : threadBuffers)
+        {
+            const std::string name = buffer->name.empty() ? "thread " + std::to_string(buffer->id) : buffer->name;
+            writeThreadName(buffer->id, name.c_str());
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    std::fputs("\n]}\n", file);
+    std::fclose(file);
+    file = nullptr;
+
+    if(dropped > 0)
+    {
+        logger::warning("trace: ", dropped, " events dropped - ring buffers were full");
+    }
+}
+
+void trace::setThreadName(std::string_view name)
+{
+    if(!isEnabled())
+    {
+        return; // bez śledzenia wątek nie dostaje bufora
+    }
+    ThreadBuffer& buffer = currentThreadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.name = name;
+}
+
+const char* trace::intern(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return internedNames.emplace(name).first->c_str();
+}
+
+void trace::complete(const char* name, uint64_t begin, uint64_t end)
+{
+    if(isEnabled())
+    {
+        push({name, begin, end, false});
+    }
+}
+
+void trace::gpuComplete(const char* name, uint64_t begin, uint64_t end)
+{
+    if(isEnabled())
+    {
+        push({name, begin, end, true});
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Śledzenie zakresów CPU do pliku Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+// TRACE_SCOPE("nazwa") na końcu zakresu wrzuca jedno zdarzenie do bufora pierścieniowego swojego wątku - bez blokad
+// i bez alokacji, osobny wątek co kilka ms przepisuje bufory do pliku. Nazwa musi żyć do trace::stop(), więc
+// literał albo trace::intern(). Bez ENGINE_TRACING makra znikają, a start() tylko ostrzega.
+namespace trace
+{
+    namespace detail
+    {
+        extern std::atomic<bool> enabled;
+    }
+
+    bool start(const std::string& path); // false - tracing wyłączony przy kompilacji albo plik się nie otworzył
+    void stop();                          // opróżnia bufory i domyka JSON; zdarzenia po stop() są gubione
+
+    inline bool isEnabled()
+    {
+#if defined(ENGINE_TRACING)
+        return detail::enabled.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+
+    inline uint64_t now() // ns, ten sam zegar co eventTimestamp() i pomiary ramek
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void setThreadName(std::string_view name); // podpis toru wątku w podglądzie; no-op, jeśli śledzenie nie jest włączone
+    const char* intern(std::string_view name); // trwała kopia nazwy zbudowanej w locie - pod blokadą, nie na gorącą ścieżkę
+
+    void complete(const char* name, uint64_t begin, uint64_t end);    // zakres z gotowymi czasami, na tor bieżącego wątku
+    void gpuComplete(const char* name, uint64_t begin, uint64_t end); // na tor GPU, czasy już przeliczone na zegar now()
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) : mName(name), mBegin(isEnabled() ? now() : 0) {}
+        ~Scope()
+        {
+            if(mBegin != 0)
+            {
+                complete(mName, mBegin, now());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* mName;
+        uint64_t mBegin; // 0 - zakres zaczął się przy wyłączonym śledzeniu
+    };
+}
+
+#if defined(ENGINE_TRACING)
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif // TRACE_H
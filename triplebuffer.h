@@ -0,0 +1,44 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Trzy sloty bez blokad dla jednego producenta i jednego konsumenta: producent pisze do swojego slotu i zamienia go
+// ze środkowym, konsument zabiera środkowy tylko, gdy jest nowszy od jego własnego. Żadna strona nigdy nie czeka,
+// konsument zawsze widzi ostatnią kompletną wersję, a pośrednie po prostu przepadają.
+template<typename T>
+class TripleBuffer
+{
+public:
+    T& back() { return mSlots[mBack]; } // tylko wątek producenta
+
+    void publish() // tylko wątek producenta - back() staje się najnowszą wersją
+    {
+        mBack = mMiddle.exchange(mBack | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    bool update() // tylko wątek konsumenta; true - front() zmienił się na nowszy
+    {
+        if((mMiddle.load(std::memory_order_relaxed) & freshBit) == 0)
+        {
+            return false;
+        }
+        mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& front() const { return mSlots[mFront]; } // tylko wątek konsumenta
+
+private:
+    static constexpr uint8_t indexMask = 3;
+    static constexpr uint8_t freshBit = 4; // środkowy slot ma wersję, której konsument jeszcze nie wziął
+
+    std::array<T, 3> mSlots {};
+    // każda strona pisze tylko do swojej linii cache, wspólny jest tylko indeks środkowego slotu
+    alignas(64) std::atomic<uint8_t> mMiddle {1};
+    alignas(64) uint8_t mBack = 0;
+    alignas(64) uint8_t mFront = 2;
+};
+
+#endif // TRIPLEBUFFER_H
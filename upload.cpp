@@ -0,0 +1,110 @@
+#include "upload.h"
+#include <cstring>
+
+namespace
+{
+    constexpr VkDeviceSize stagingAlignment = 16; // wystarcza dla optimalBufferCopyOffsetAlignment na typowych kartach
+}
+
+StagingUploader::StagingUploader(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex, MemoryAllocator& allocator, VkDeviceSize stagingSize)
+    : mDevice(device), mQueue(queue), mAllocator(allocator)
+{
+    mStaging = allocator.createBuffer(stagingSize > 0 ? stagingSize : stagingAlignment, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo {};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.pNext = NULL;
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    if(vkCreateCommandPool(device, &commandPoolCreateInfo, NULL, &commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upload command pool");
+    }
+    mCommandPool = CommandPoolHandle(device, commandPool);
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo {};
+    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.pNext = NULL;
+    commandBufferAllocateInfo.commandPool = commandPool;
+    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandBufferCount = 1;
+    if(vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &mCommandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate upload command buffer");
+    }
+
+    VkFenceCreateInfo fenceCreateInfo {};
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.pNext = NULL;
+    fenceCreateInfo.flags = 0;
+
+    VkFence fence = VK_NULL_HANDLE;
+    if(vkCreateFence(device, &fenceCreateInfo, NULL, &fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upload fence");
+    }
+    mFence = FenceHandle(device, fence);
+
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pNext = NULL;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = NULL;
+    vkBeginCommandBuffer(mCommandBuffer, &beginInfo);
+}
+
+uint8_t* StagingUploader::stage(VkDeviceSize size, VkDeviceSize& stagingOffset)
+{
+    stagingOffset = (mStagingUsed + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+    if(stagingOffset + size > mStaging.size)
+    {
+        throw std::runtime_error("staging buffer too small");
+    }
+    mStagingUsed = stagingOffset + size;
+    return static_cast<uint8_t*>(mStaging.mapped) + stagingOffset;
+}
+
+void StagingUploader::copy(VkDeviceSize stagingOffset, VkBuffer destination, VkDeviceSize destinationOffset, VkDeviceSize size)
+{
+    const VkBufferCopy region {stagingOffset, destinationOffset, size};
+    vkCmdCopyBuffer(mCommandBuffer, mStaging.buffer, destination, 1, &region);
+}
+
+Buffer StagingUploader::upload(const void* data, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    Buffer buffer = mAllocator.createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkDeviceSize stagingOffset = 0;
+    std::memcpy(stage(size, stagingOffset), data, size);
+    copy(stagingOffset, buffer.buffer, 0, size);
+    return buffer;
+}
+
+void StagingUploader::submit()
+{
+    // kopie muszą być widoczne dla wszystkiego, co przyjdzie w kolejnych submitach
+    VkMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    vkCmdPipelineBarrier(mCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+    vkEndCommandBuffer(mCommandBuffer);
+    mAllocator.flush(mStaging);
+
+    VkSubmitInfo submitInfo {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = NULL;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &mCommandBuffer;
+
+    if(vkQueueSubmit(mQueue, 1, &submitInfo, mFence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to submit upload");
+    }
+    vkWaitForFences(mDevice, 1, mFence.ptr(), VK_TRUE, UINT64_MAX);
+}
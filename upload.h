@@ -0,0 +1,31 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+#include "memory.h"
+
+// Jednorazowe ładowanie danych do pamięci device local: dane trafiają do jednego bufora stagingowego,
+// kopie są nagrywane do własnego command buffera, a submit() czeka na ich zakończenie.
+// Używa kolejki silnika, więc nie wolno go wołać równolegle z innym vkQueueSubmit na tej kolejce.
+class StagingUploader
+{
+public:
+    StagingUploader(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex, MemoryAllocator& allocator, VkDeviceSize stagingSize);
+
+    uint8_t* stage(VkDeviceSize size, VkDeviceSize& stagingOffset); // miejsce w stagingu do wypełnienia przez wołającego
+    void copy(VkDeviceSize stagingOffset, VkBuffer destination, VkDeviceSize destinationOffset, VkDeviceSize size);
+
+    // nowy bufor device local z podanymi danymi - dane kopiowane tylko raz, prosto do stagingu
+    Buffer upload(const void* data, VkDeviceSize size, VkBufferUsageFlags usage);
+    void submit();
+
+private:
+    VkDevice mDevice;
+    VkQueue mQueue;
+    MemoryAllocator& mAllocator;
+    Buffer mStaging;
+    VkDeviceSize mStagingUsed = 0;
+    CommandPoolHandle mCommandPool;
+    VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+    FenceHandle mFence;
+};
+
+#endif // UPLOAD_H
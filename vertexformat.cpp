@@ -0,0 +1,313 @@
+#include "vertexformat.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    int16_t toSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    uint8_t toUnorm8(float value)
+    {
+        return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+
+    template<typename T, size_t N>
+    void store(uint8_t* destination, const std::array<T, N>& values)
+    {
+        std::memcpy(destination, values.data(), sizeof(T) * N);
+    }
+}
+
+const char* vertexLayoutName(VertexLayoutType type)
+{
+    switch(type)
+    {
+        case VertexLayoutType::Full: return "full";
+        case VertexLayoutType::Compact: return "compact";
+        case VertexLayoutType::CompactHalf: return "compact half";
+    }
+    return "unknown";
+}
+
+VertexLayout VertexLayout::create(VertexLayoutType type)
+{
+    VertexLayout layout;
+    layout.type = type;
+
+    switch(type)
+    {
+        case VertexLayoutType::Full:
+            layout.elements = {{VertexAttribute::Position, AttributeEncoding::Float32x3, 0},
+                               {VertexAttribute::Normal, AttributeEncoding::Float32x2, 0},
+                               {VertexAttribute::Color, AttributeEncoding::Float32x4, 0}};
+            break;
+        case VertexLayoutType::Compact:
+            layout.elements = {{VertexAttribute::Position, AttributeEncoding::Snorm16x4, 0},
+                               {VertexAttribute::Normal, AttributeEncoding::Snorm16x2, 0},
+                               {VertexAttribute::Color, AttributeEncoding::Unorm8x4, 0}};
+            break;
+        case VertexLayoutType::CompactHalf:
+            layout.elements = {{VertexAttribute::Position, AttributeEncoding::Half16x4, 0},
+                               {VertexAttribute::Normal, AttributeEncoding::Snorm16x2, 0},
+                               {VertexAttribute::Color, AttributeEncoding::Unorm8x4, 0}};
+            break;
+    }
+
+    for(auto& element : layout.elements) // ciasno upakowane - wszystkie rozmiary są wielokrotnością 4
+    {
+        element.offset = layout.stride;
+        layout.stride += attributeSize(element.encoding);
+    }
+    return layout;
+}
+
+uint32_t attributeLocation(VertexAttribute attribute)
+{
+    return static_cast<uint32_t>(attribute);
+}
+
+VkFormat attributeFormat(AttributeEncoding encoding)
+{
+    switch(encoding)
+    {
+        case AttributeEncoding::Float32x2: return VK_FORMAT_R32G32_SFLOAT;
+        case AttributeEncoding::Float32x3: return VK_FORMAT_R32G32B32_SFLOAT;
+        case AttributeEncoding::Float32x4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+        case AttributeEncoding::Half16x4: return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case AttributeEncoding::Snorm16x2: return VK_FORMAT_R16G16_SNORM;
+        case AttributeEncoding::Snorm16x4: return VK_FORMAT_R16G16B16A16_SNORM;
+        case AttributeEncoding::Unorm8x4: return VK_FORMAT_R8G8B8A8_UNORM;
+    }
+    throw std::runtime_error("unknown attribute encoding");
+}
+
+uint32_t attributeSize(AttributeEncoding encoding)
+{
+    switch(encoding)
+    {
+        case AttributeEncoding::Float32x2: return 8;
+        case AttributeEncoding::Float32x3: return 12;
+        case AttributeEncoding::Float32x4: return 16;
+        case AttributeEncoding::Half16x4: return 8;
+        case AttributeEncoding::Snorm16x2: return 4;
+        case AttributeEncoding::Snorm16x4: return 8;
+        case AttributeEncoding::Unorm8x4: return 4;
+    }
+    throw std::runtime_error("unknown attribute encoding");
+}
+
+void describeVertexInput(const VertexLayout& layout, uint32_t binding, std::vector<VkVertexInputBindingDescription>& bindings,
+                         std::vector<VkVertexInputAttributeDescription>& attributes)
+{
+    VkVertexInputBindingDescription bindingDescription {};
+    bindingDescription.binding = binding;
+    bindingDescription.stride = layout.stride;
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    bindings.push_back(bindingDescription);
+
+    for(const auto& element : layout.elements)
+    {
+        VkVertexInputAttributeDescription attributeDescription {};
+        attributeDescription.location = attributeLocation(element.attribute);
+        attributeDescription.binding = binding;
+        attributeDescription.format = attributeFormat(element.encoding);
+        attributeDescription.offset = element.offset;
+        attributes.push_back(attributeDescription);
+    }
+}
+
+QuantizationParameters computeQuantization(const VertexLayout& layout, const MeshVertex* vertices, size_t count)
+{
+    QuantizationParameters quantization;
+    const bool quantized = std::any_of(layout.elements.begin(), layout.elements.end(), [](const VertexLayout::Element& element)
+    {
+        return element.attribute == VertexAttribute::Position && element.encoding != AttributeEncoding::Float32x3;
+    });
+    if(!quantized || count == 0)
+    {
+        return quantization;
+    }
+
+    Vector3 minimum = vertices[0].position;
+    Vector3 maximum = vertices[0].position;
+    for(size_t i = 1; i < count; i++)
+    {
+        for(int axis = 0; axis < 3; axis++)
+        {
+            minimum[axis] = std::min(minimum[axis], vertices[i].position[axis]);
+            maximum[axis] = std::max(maximum[axis], vertices[i].position[axis]);
+        }
+    }
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const float halfExtent = (maximum[axis] - minimum[axis]) * 0.5f;
+        quantization.offset[axis] = (maximum[axis] + minimum[axis]) * 0.5f;
+        quantization.scale[axis] = halfExtent > 0.0f ? halfExtent : 1.0f; // płaska siatka - oś bez zakresu
+    }
+    return quantization;
+}
+
+void encodeVertices(const VertexLayout& layout, const QuantizationParameters& quantization, const MeshVertex* vertices, size_t count, uint8_t* destination)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        const MeshVertex& vertex = vertices[i];
+        uint8_t* out = destination + i * layout.stride;
+
+        for(const auto& element : layout.elements)
+        {
+            uint8_t* field = out + element.offset;
+
+            if(element.attribute == VertexAttribute::Position)
+            {
+                Vector3 p = vertex.position;
+                if(element.encoding != AttributeEncoding::Float32x3)
+                {
+                    for(int axis = 0; axis < 3; axis++)
+                    {
+                        p[axis] = (p[axis] - quantization.offset[axis]) / quantization.scale[axis];
+                    }
+                }
+
+                switch(element.encoding)
+                {
+                    case AttributeEncoding::Float32x3: store(field, std::array<float, 3>{p.x, p.y, p.z}); break;
+                    case AttributeEncoding::Snorm16x4: store(field, std::array<int16_t, 4>{toSnorm16(p.x), toSnorm16(p.y), toSnorm16(p.z), 32767}); break;
+                    case AttributeEncoding::Half16x4: store(field, std::array<uint16_t, 4>{floatToHalf(p.x), floatToHalf(p.y), floatToHalf(p.z), floatToHalf(1.0f)}); break;
+                    default: throw std::runtime_error("unsupported position encoding");
+                }
+            }
+            else if(element.attribute == VertexAttribute::Normal)
+            {
+                const std::array<float, 2> n = octahedralEncode(vertex.normal);
+                switch(element.encoding)
+                {
+                    case AttributeEncoding::Float32x2: store(field, n); break;
+                    case AttributeEncoding::Snorm16x2: store(field, std::array<int16_t, 2>{toSnorm16(n[0]), toSnorm16(n[1])}); break;
+                    default: throw std::runtime_error("unsupported normal encoding");
+                }
+            }
+            else
+            {
+                const Vector4& c = vertex.color;
+                switch(element.encoding)
+                {
+                    case AttributeEncoding::Float32x4: store(field, std::array<float, 4>{c.x, c.y, c.z, c.w}); break;
+                    case AttributeEncoding::Unorm8x4: store(field, std::array<uint8_t, 4>{toUnorm8(c.x), toUnorm8(c.y), toUnorm8(c.z), toUnorm8(c.w)}); break;
+                    default: throw std::runtime_error("unsupported color encoding");
+                }
+            }
+        }
+    }
+}
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if(((bits >> 23) & 0xff) == 0xff) // inf / NaN
+    {
+        return uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    if(exponent >= 31) // za duże - inf
+    {
+        return uint16_t(sign | 0x7c00);
+    }
+    if(exponent <= 0) // subnormalne albo zero
+    {
+        if(exponent < -10)
+        {
+            return uint16_t(sign);
+        }
+        mantissa |= 0x800000;
+        const uint32_t shift = uint32_t(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (half & 1))) // round to nearest even
+        {
+            half++;
+        }
+        return uint16_t(sign | half);
+    }
+
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1fff;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        half++; // przeniesienie do wykładnika daje poprawnie inf przy przepełnieniu
+    }
+    return uint16_t(half);
+}
+
+float halfToFloat(uint16_t value)
+{
+    const uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+
+    if(exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if(exponent == 0)
+    {
+        if(mantissa == 0)
+        {
+            bits = sign;
+        }
+        else // subnormalna - normalizujemy
+        {
+            exponent = 127 - 15 + 1;
+            while((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+std::array<float, 2> octahedralEncode(const Vector3& normal)
+{
+    const float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    float x = normal.x / sum;
+    float y = normal.y / sum;
+    if(normal.z < 0.0f) // dolna półkula zawinięta na rogi kwadratu
+    {
+        const float wrappedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float wrappedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = wrappedX;
+        y = wrappedY;
+    }
+    return {x, y};
+}
+
+Vector3 octahedralDecode(float x, float y) // to samo co decodeNormal w vs.vert
+{
+    Vector3 n {x, y, 1.0f - std::fabs(x) - std::fabs(y)};
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
@@ -0,0 +1,83 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+#include "mathlib.h"
+#include <vulkan.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+enum class VertexAttribute
+{
+    Position, // zawsze w lokacji 0, dekodowana w shaderze jako q * scale + offset
+    Normal,   // lokacja 1, zawsze octahedral (2 składowe), dekodowana w shaderze
+    Color     // lokacja 2
+};
+
+enum class AttributeEncoding
+{
+    Float32x2,
+    Float32x3,
+    Float32x4,
+    Half16x4,  // pozycja względem środka bounding boxa, w = 1
+    Snorm16x2, // normalna octahedral
+    Snorm16x4, // pozycja znormalizowana do bounding boxa, w = 1
+    Unorm8x4   // kolor
+};
+
+enum class VertexLayoutType
+{
+    Full,       // float32 - 36 B na wierzchołek
+    Compact,    // snorm16 pozycja, snorm16 octahedral normalna, unorm8 kolor - 16 B
+    CompactHalf // jak Compact, ale pozycja w half float - lepsza precyzja przy dużym zakresie
+};
+
+const char* vertexLayoutName(VertexLayoutType type);
+
+struct VertexLayout
+{
+    struct Element
+    {
+        VertexAttribute attribute;
+        AttributeEncoding encoding;
+        uint32_t offset;
+    };
+
+    static VertexLayout create(VertexLayoutType type);
+
+    VertexLayoutType type = VertexLayoutType::Full;
+    std::vector<Element> elements;
+    uint32_t stride = 0;
+};
+
+uint32_t attributeLocation(VertexAttribute attribute);
+VkFormat attributeFormat(AttributeEncoding encoding);
+uint32_t attributeSize(AttributeEncoding encoding);
+
+// opis wejścia dla jednego bindingu (VK_VERTEX_INPUT_RATE_VERTEX) wygenerowany z layoutu - dopisywany do podanych wektorów
+void describeVertexInput(const VertexLayout& layout, uint32_t binding, std::vector<VkVertexInputBindingDescription>& bindings,
+                         std::vector<VkVertexInputAttributeDescription>& attributes);
+
+// wierzchołek źródłowy, z którego powstają wszystkie layouty
+struct MeshVertex
+{
+    Vector3 position;
+    Vector3 normal {0.0f, 0.0f, 1.0f};
+    Vector4 color {1.0f, 1.0f, 1.0f, 1.0f};
+};
+
+// pozycja = zakodowana * scale + offset, per siatka (push constant)
+struct QuantizationParameters
+{
+    Vector4 scale {1.0f, 1.0f, 1.0f, 0.0f};
+    Vector4 offset {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+QuantizationParameters computeQuantization(const VertexLayout& layout, const MeshVertex* vertices, size_t count);
+void encodeVertices(const VertexLayout& layout, const QuantizationParameters& quantization, const MeshVertex* vertices, size_t count, uint8_t* destination);
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+std::array<float, 2> octahedralEncode(const Vector3& normal); // wynik w [-1, 1]
+Vector3 octahedralDecode(float x, float y);
+
+#endif // VERTEXFORMAT_H
@@ -0,0 +1,128 @@
+#ifndef VKHANDLE_H
+#define VKHANDLE_H
+#include "window.h"
+#include <vulkan.h>
+#include <utility>
+
+// Uchwyt bez rodzica (instancja, urządzenie) - Destroy(handle, allocator).
+template<typename T, auto Destroy>
+class Handle
+{
+public:
+    Handle() = default;
+    explicit Handle(T handle) : mHandle(handle) {}
+    ~Handle() { reset(); }
+
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+    Handle(Handle&& other) noexcept : mHandle(other.release()) {}
+    Handle& operator=(Handle&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset();
+            mHandle = other.release();
+        }
+        return *this;
+    }
+
+    operator T() const { return mHandle; }
+    T get() const { return mHandle; }
+    const T* ptr() const { return &mHandle; }
+
+    T release()
+    {
+        T handle = mHandle;
+        mHandle = VK_NULL_HANDLE;
+        return handle;
+    }
+
+    void reset()
+    {
+        if(mHandle != VK_NULL_HANDLE)
+        {
+            Destroy(mHandle, NULL);
+            mHandle = VK_NULL_HANDLE;
+        }
+    }
+
+private:
+    T mHandle = VK_NULL_HANDLE;
+};
+
+// Uchwyt należący do instancji albo urządzenia - Destroy(owner, handle, allocator).
+template<typename Owner, typename T, auto Destroy>
+class OwnedHandle
+{
+public:
+    OwnedHandle() = default;
+    OwnedHandle(Owner owner, T handle) : mOwner(owner), mHandle(handle) {}
+    ~OwnedHandle() { reset(); }
+
+    OwnedHandle(const OwnedHandle&) = delete;
+    OwnedHandle& operator=(const OwnedHandle&) = delete;
+    OwnedHandle(OwnedHandle&& other) noexcept : mOwner(other.mOwner), mHandle(other.release()) {}
+    OwnedHandle& operator=(OwnedHandle&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset();
+            mOwner = other.mOwner;
+            mHandle = other.release();
+        }
+        return *this;
+    }
+
+    operator T() const { return mHandle; }
+    T get() const { return mHandle; }
+    const T* ptr() const { return &mHandle; } // do pól typu pSwapchains/pWaitSemaphores
+    Owner owner() const { return mOwner; }
+
+    T release()
+    {
+        T handle = mHandle;
+        mHandle = VK_NULL_HANDLE;
+        return handle;
+    }
+
+    void reset()
+    {
+        if(mHandle != VK_NULL_HANDLE)
+        {
+            Destroy(mOwner, mHandle, NULL);
+            mHandle = VK_NULL_HANDLE;
+        }
+    }
+
+private:
+    Owner mOwner = VK_NULL_HANDLE;
+    T mHandle = VK_NULL_HANDLE;
+};
+
+template<typename T, auto Destroy>
+using DeviceChild = OwnedHandle<VkDevice, T, Destroy>;
+
+using InstanceHandle = Handle<VkInstance, vkDestroyInstance>;
+using DeviceHandle = Handle<VkDevice, vkDestroyDevice>;
+using SurfaceHandle = OwnedHandle<VkInstance, VkSurfaceKHR, vkDestroySurfaceKHR>;
+
+using SwapchainHandle = DeviceChild<VkSwapchainKHR, vkDestroySwapchainKHR>;
+using ImageHandle = DeviceChild<VkImage, vkDestroyImage>;
+using ImageViewHandle = DeviceChild<VkImageView, vkDestroyImageView>;
+using BufferHandle = DeviceChild<VkBuffer, vkDestroyBuffer>;
+using MemoryHandle = DeviceChild<VkDeviceMemory, vkFreeMemory>;
+using CommandPoolHandle = DeviceChild<VkCommandPool, vkDestroyCommandPool>;
+using FenceHandle = DeviceChild<VkFence, vkDestroyFence>;
+using SemaphoreHandle = DeviceChild<VkSemaphore, vkDestroySemaphore>;
+using RenderPassHandle = DeviceChild<VkRenderPass, vkDestroyRenderPass>;
+using FramebufferHandle = DeviceChild<VkFramebuffer, vkDestroyFramebuffer>;
+using ShaderModuleHandle = DeviceChild<VkShaderModule, vkDestroyShaderModule>;
+using PipelineLayoutHandle = DeviceChild<VkPipelineLayout, vkDestroyPipelineLayout>;
+using PipelineHandle = DeviceChild<VkPipeline, vkDestroyPipeline>;
+using DescriptorSetLayoutHandle = DeviceChild<VkDescriptorSetLayout, vkDestroyDescriptorSetLayout>;
+using DescriptorPoolHandle = DeviceChild<VkDescriptorPool, vkDestroyDescriptorPool>;
+using SamplerHandle = DeviceChild<VkSampler, vkDestroySampler>;
+using QueryPoolHandle = DeviceChild<VkQueryPool, vkDestroyQueryPool>;
+using PipelineCacheHandle = DeviceChild<VkPipelineCache, vkDestroyPipelineCache>;
+
+#endif // VKHANDLE_H
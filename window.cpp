@@ -1,33 +1,98 @@
 #include "window.h"
+#include <exception>
+#include <future>
+#include <mutex>
 #include <stdexcept>
+#include <stdlib.h>
 #include <string.h>
-#include "engine.h"
 
 #if(_WIN32)
-namespace global
+LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+// funkcja wywoływana za każdym razem gdy pojawiają się dane wejściowe (uMsg). wParam posiada informację jaki klawisz został wciśnięty
 {
-    static Window* windowPointer = nullptr;
+    // okien może być kilka, każde z własnym wątkiem i kolejką - Window* siedzi w danych samego HWND
+    if(uMsg == WM_NCCREATE)
+    {
+        const auto* createStruct = reinterpret_cast<const CREATESTRUCT*>(lParam);
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(createStruct->lpCreateParams));
+    }
+    Window* window = reinterpret_cast<Window*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    if(window == nullptr) // wiadomości sprzed WM_NCCREATE
+    {
+        return DefWindowProc(hwnd, uMsg, wParam, lParam);
+    }
+    return window->myWindowProc(hwnd, uMsg, wParam, lParam);
 }
 
-LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
-// funkcja wywoływana za każdym razem gdy pojawiają się dane wejściowe (uMsg). wParam posiada informację jaki klawisz został wciśnięty
+namespace
 {
-    return global::windowPointer->myWindowProc(hwnd, uMsg, wParam, lParam);
+    constexpr UINT WM_APP_DESTROY = WM_APP + 1; // DestroyWindow działa tylko z wątku, który stworzył okno
+    constexpr const char* windowClassName = "Vulkan Project";
+
+    void registerWindowClass(HINSTANCE hinstance)
+    {
+        // klasa jest wspólna dla wszystkich okien; wyrejestrowuje ją system przy końcu procesu
+        static std::once_flag registered;
+        std::call_once(registered, [hinstance]
+        {
+            WNDCLASS windowClass {};
+            windowClass.lpfnWndProc = WindowProc;
+            windowClass.hInstance = hinstance;
+            windowClass.lpszClassName = windowClassName;
+            windowClass.hbrBackground = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));
+            if(RegisterClass(&windowClass) == 0)
+            {
+                throw std::runtime_error("failed to register window class");
+            }
+        });
+    }
+
+    Key translateKey(WPARAM virtualKey)
+    {
+        switch(virtualKey)
+        {
+        case VK_ESCAPE: return Key::Escape;
+        case VK_SPACE: return Key::Space;
+        case VK_RETURN: return Key::Enter;
+        default: return Key::Unknown;
+        }
+    }
 }
 
-Window::Window(Engine* enginePointer, uint16_t windowWidth, uint16_t windowHeight)
+Window::Window(uint16_t windowWidth, uint16_t windowHeight)
 {
-    mEnginePointer = enginePointer;
-    global::windowPointer = this;
+    registerWindowClass(mHinstance);
+
+    std::promise<void> created;
+    std::future<void> createdFuture = created.get_future();
+    mPumpThread = std::thread([this, windowWidth, windowHeight, &created]
+    {
+        try
+        {
+            createWindow(windowWidth, windowHeight);
+        }
+        catch(...)
+        {
+            created.set_exception(std::current_exception());
+            return;
+        }
+        created.set_value();
+        pumpMessages();
+    });
 
-    /*--- register window class ---*/
-    WNDCLASS windowClass {};
-    windowClass.lpfnWndProc = WindowProc;
-    windowClass.hInstance = mHinstance;
-    windowClass.lpszClassName = mClassName;
-    windowClass.hbrBackground = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));
-    RegisterClass(&windowClass);
+    try
+    {
+        createdFuture.get(); // wyjątek z wątku okna leci dalej stąd
+    }
+    catch(...)
+    {
+        mPumpThread.join();
+        throw;
+    }
+}
 
+void Window::createWindow(uint16_t windowWidth, uint16_t windowHeight)
+{
     /*-------- resolution ---------*/
     HDC hdc = GetDC(NULL); // get screen DC
     uint32_t displayWidth = GetDeviceCaps(hdc, HORZRES);
@@ -35,7 +100,7 @@ Window::Window(Engine* enginePointer, uint16_t windowWidth, uint16_t windowHeigh
     ReleaseDC(NULL, hdc);
 
     /*------ create window --------*/
-    mHwnd = CreateWindowEx(0, mClassName, "", WS_POPUP | WS_CLIPCHILDREN, (displayWidth - windowWidth)/2, (displayHeight - windowHeight)/2, windowWidth, windowHeight, NULL, NULL, mHinstance, NULL);
+    mHwnd = CreateWindowEx(0, windowClassName, "", WS_POPUP | WS_CLIPCHILDREN, (displayWidth - windowWidth)/2, (displayHeight - windowHeight)/2, windowWidth, windowHeight, NULL, NULL, mHinstance, this);
 
     if(mHwnd == NULL) //jeśli createwindow zwróci null - okno nie zostało stworzone
     {
@@ -47,8 +112,8 @@ Window::Window(Engine* enginePointer, uint16_t windowWidth, uint16_t windowHeigh
 
 Window::~Window()
 {
-    DestroyWindow(mHwnd);
-    UnregisterClass(mClassName, mHinstance);
+    PostMessage(mHwnd, WM_APP_DESTROY, 0, 0);
+    mPumpThread.join();
 }
 
 HINSTANCE Window::getHinstance() const
@@ -63,40 +128,102 @@ HWND Window::getHwnd() const
 
 LRESULT Window::myWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
+    // wątek okna - tylko tłumaczy wiadomości na zdarzenia, nic tu nie dotyka silnika
+    Event event;
     switch(uMsg)
     {
+    case WM_APP_DESTROY:
+        DestroyWindow(hwnd);
+        return 0;
     case WM_DESTROY:
-    {
-        PostQuitMessage(0);
+        PostQuitMessage(0); // kończy pumpMessages()
+        return 0;
+    case WM_CLOSE:
+        event.type = EventType::Close;
+        post(event);
         return 0;
-    }
     case WM_KEYDOWN:
-        if(wParam == VK_ESCAPE) //przyrównujemy do wParam, bo ma informację o tym jaki klawisz jest wciśnięty
-        {
-            mEnginePointer->stop();
-        }
+    case WM_KEYUP:
+        event.type = uMsg == WM_KEYDOWN ? EventType::KeyDown : EventType::KeyUp;
+        event.key = translateKey(wParam); //przyrównujemy do wParam, bo ma informację o tym jaki klawisz jest wciśnięty
+        event.code = static_cast<uint32_t>(wParam);
+        post(event);
+        return 0;
+    case WM_MOUSEMOVE:
+        event.type = EventType::MouseMove;
+        event.x = static_cast<int16_t>(LOWORD(lParam)); // ze znakiem - poza oknem współrzędne bywają ujemne
+        event.y = static_cast<int16_t>(HIWORD(lParam));
+        post(event);
+        return 0;
+    case WM_LBUTTONDOWN:
+    case WM_MBUTTONDOWN:
+    case WM_RBUTTONDOWN:
+    case WM_LBUTTONUP:
+    case WM_MBUTTONUP:
+    case WM_RBUTTONUP:
+        event.type = (uMsg == WM_LBUTTONDOWN || uMsg == WM_MBUTTONDOWN || uMsg == WM_RBUTTONDOWN) ? EventType::MouseButtonDown : EventType::MouseButtonUp;
+        event.button = (uMsg == WM_LBUTTONDOWN || uMsg == WM_LBUTTONUP) ? 1 : (uMsg == WM_MBUTTONDOWN || uMsg == WM_MBUTTONUP) ? 2 : 3;
+        event.x = static_cast<int16_t>(LOWORD(lParam));
+        event.y = static_cast<int16_t>(HIWORD(lParam));
+        post(event);
+        return 0;
+    case WM_SIZE:
+        event.type = EventType::Resize;
+        event.x = LOWORD(lParam);
+        event.y = HIWORD(lParam);
+        post(event);
         return 0;
     default:
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
     }
 }
 
-void Window::handleEvents()
+void Window::pumpMessages()
 {
+    // blokujące GetMessage jest tu w porządku - czeka tylko wątek okna
     MSG msg {};
-    GetMessage(&msg, NULL, 0, 0);
-    TranslateMessage(&msg);
-    DispatchMessage(&msg);
+    while(GetMessage(&msg, NULL, 0, 0) > 0)
+    {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
 }
 #elif(__linux__)
 
-Window::Window(Engine* enginePointer, uint16_t windowWidth, uint16_t windowHeight)
+namespace
+{
+    xcb_atom_t internAtom(xcb_connection_t* connection, const char* name)
+    {
+        xcb_intern_atom_cookie_t cookie = xcb_intern_atom(connection, 0, static_cast<uint16_t>(strlen(name)), name);
+        xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(connection, cookie, NULL);
+        if(reply == NULL)
+        {
+            throw std::runtime_error("failed to intern xcb atom");
+        }
+        const xcb_atom_t atom = reply->atom;
+        free(reply);
+        return atom;
+    }
+
+    Key translateKey(xcb_keycode_t keycode)
+    {
+        // keycode'y X.org z evdev - bez xcb-keysyms, do sterowania silnikiem wystarczy kilka klawiszy
+        switch(keycode)
+        {
+        case 9: return Key::Escape;
+        case 65: return Key::Space;
+        case 36: return Key::Enter;
+        default: return Key::Unknown;
+        }
+    }
+}
+
+Window::Window(uint16_t windowWidth, uint16_t windowHeight)
 {
     uint16_t x = 0;
     uint16_t y = 0;
     uint16_t borderWidth = 10;
 
-    mEnginePointer = enginePointer;
     xcb_screen_t* screen;
 
     mConnection = xcb_connect(NULL, NULL);
@@ -108,20 +235,136 @@ Window::Window(Engine* enginePointer, uint16_t windowWidth, uint16_t windowHeigh
 
     screen = xcb_setup_roots_iterator(xcb_get_setup(mConnection)).data;
     mWindowId = xcb_generate_id(mConnection);
+    mWidth = windowWidth;
+    mHeight = windowHeight;
 
-    xcb_create_window(mConnection, XCB_COPY_FROM_PARENT, mWindowId, screen->root, x, y, windowWidth, windowHeight, borderWidth, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, 0, NULL);
+    const uint32_t eventMask = XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE | XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+                               XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    xcb_create_window(mConnection, XCB_COPY_FROM_PARENT, mWindowId, screen->root, x, y, windowWidth, windowHeight, borderWidth, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, XCB_CW_EVENT_MASK, &eventMask);
+
+    try
+    {
+        // bez WM_DELETE_WINDOW menedżer okien po prostu zabija połączenie zamiast wysłać Close
+        mProtocolsAtom = internAtom(mConnection, "WM_PROTOCOLS");
+        mDeleteWindowAtom = internAtom(mConnection, "WM_DELETE_WINDOW");
+        mWakeAtom = internAtom(mConnection, "VULKAN_PROJECT_WAKE");
+    }
+    catch(const std::runtime_error&)
+    {
+        xcb_disconnect(mConnection);
+        throw;
+    }
+    xcb_change_property(mConnection, XCB_PROP_MODE_REPLACE, mWindowId, mProtocolsAtom, XCB_ATOM_ATOM, 32, 1, &mDeleteWindowAtom);
 
     xcb_map_window(mConnection, mWindowId);
     xcb_flush(mConnection);
+
+    mPumpThread = std::thread([this]{ pumpMessages(); });
 }
 
 Window::~Window()
 {
+    // xcb_wait_for_event nie ma timeoutu - budzimy wątek własnym ClientMessage; pusta maska = do twórcy okna, czyli do nas
+    xcb_client_message_event_t wake {};
+    wake.response_type = XCB_CLIENT_MESSAGE;
+    wake.format = 32;
+    wake.window = mWindowId;
+    wake.type = mWakeAtom;
+    xcb_send_event(mConnection, 0, mWindowId, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char*>(&wake));
+    xcb_flush(mConnection);
+    mPumpThread.join();
+
+    xcb_destroy_window(mConnection, mWindowId);
     xcb_disconnect(mConnection);
 }
 
-void Window::handleEvents()
+void Window::pumpMessages()
 {
+    while(xcb_generic_event_t* genericEvent = xcb_wait_for_event(mConnection)) // NULL - zerwane połączenie
+    {
+        Event event;
+        bool stop = false;
 
+        switch(genericEvent->response_type & ~0x80) // najwyższy bit - zdarzenie z xcb_send_event
+        {
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE:
+        {
+            const auto* key = reinterpret_cast<const xcb_key_press_event_t*>(genericEvent);
+            event.type = (genericEvent->response_type & ~0x80) == XCB_KEY_PRESS ? EventType::KeyDown : EventType::KeyUp;
+            event.key = translateKey(key->detail);
+            event.code = key->detail;
+            post(event);
+            break;
+        }
+        case XCB_MOTION_NOTIFY:
+        {
+            const auto* motion = reinterpret_cast<const xcb_motion_notify_event_t*>(genericEvent);
+            event.type = EventType::MouseMove;
+            event.x = motion->event_x;
+            event.y = motion->event_y;
+            post(event);
+            break;
+        }
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE:
+        {
+            const auto* button = reinterpret_cast<const xcb_button_press_event_t*>(genericEvent);
+            event.type = (genericEvent->response_type & ~0x80) == XCB_BUTTON_PRESS ? EventType::MouseButtonDown : EventType::MouseButtonUp;
+            event.button = button->detail;
+            event.x = button->event_x;
+            event.y = button->event_y;
+            post(event);
+            break;
+        }
+        case XCB_CONFIGURE_NOTIFY:
+        {
+            // przychodzi też przy samym przesunięciu okna
+            const auto* configure = reinterpret_cast<const xcb_configure_notify_event_t*>(genericEvent);
+            if(configure->width != mWidth || configure->height != mHeight)
+            {
+                mWidth = configure->width;
+                mHeight = configure->height;
+                event.type = EventType::Resize;
+                event.x = mWidth;
+                event.y = mHeight;
+                post(event);
+            }
+            break;
+        }
+        case XCB_CLIENT_MESSAGE:
+        {
+            const auto* message = reinterpret_cast<const xcb_client_message_event_t*>(genericEvent);
+            if(message->type == mWakeAtom)
+            {
+                stop = true;
+            }
+            else if(message->type == mProtocolsAtom && message->data.data32[0] == mDeleteWindowAtom)
+            {
+                event.type = EventType::Close;
+                post(event);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        free(genericEvent);
+        if(stop)
+        {
+            break;
+        }
+    }
 }
 #endif
+
+void Window::post(Event event)
+{
+    event.timestamp = eventTimestamp();
+    if(!mEvents.push(event))
+    {
+        // render stoi dłużej niż 1024 zdarzenia - starsze są ważniejsze (np. Close), więc ginie najnowsze
+        mDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+}
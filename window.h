@@ -1,7 +1,11 @@
 #ifndef WINDOW_H
 #define WINDOW_H
+#include "events.h"
+#include <atomic>
+#include <thread>
 
-class Engine;
+// Okno ma własny wątek z pompą wiadomości - render nigdy nie czeka na system, a system na render.
+// Zdarzenia trafiają do kolejki SPSC, silnik opróżnia ją raz na ramkę.
 
 #if(_WIN32)
 #include <windows.h>
@@ -12,17 +16,23 @@ class Engine;
 class Window
 {
 public:
-    Window(Engine* enginePointer, uint16_t windowWidth, uint16_t windowHeight);
+    Window(uint16_t windowWidth, uint16_t windowHeight); // wraca, gdy wątek okna je stworzy
     ~Window();
     HINSTANCE getHinstance() const;
     HWND getHwnd() const;
     LRESULT CALLBACK myWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
-    void handleEvents();
+    EventQueue& events() { return mEvents; } // konsumentem może być tylko jeden wątek
+    uint64_t droppedEvents() const { return mDroppedEvents.load(std::memory_order_relaxed); }
 private:
-    const char* mClassName = "Vulkan Project";
+    void createWindow(uint16_t windowWidth, uint16_t windowHeight); // na wątku okna - kolejka wiadomości należy do wątku, który je stworzył
+    void pumpMessages();
+    void post(Event event);
+
     HINSTANCE mHinstance = GetModuleHandle(NULL);
     HWND mHwnd = NULL;
-    Engine* mEnginePointer = nullptr;
+    EventQueue mEvents;
+    std::atomic<uint64_t> mDroppedEvents {0};
+    std::thread mPumpThread;
 };
 #elif(__linux__)
 #include <xcb/xcb.h>
@@ -31,17 +41,27 @@ private:
 class Window
 {
 public:
-    Window(Engine* enginePointer, uint16_t width, uint16_t height);
+    Window(uint16_t width, uint16_t height);
     ~Window();
 
     xcb_connection_t* mConnection;
     xcb_window_t mWindowId;
 
-    //TODO:
-    void handleEvents();
+    EventQueue& events() { return mEvents; } // konsumentem może być tylko jeden wątek
+    uint64_t droppedEvents() const { return mDroppedEvents.load(std::memory_order_relaxed); }
 
 private:
-    Engine* mEnginePointer = nullptr;
+    void pumpMessages(); // xcb jest thread-safe, więc wątek okna może czekać na zdarzenia blokująco
+    void post(Event event);
+
+    xcb_atom_t mProtocolsAtom = XCB_ATOM_NONE;
+    xcb_atom_t mDeleteWindowAtom = XCB_ATOM_NONE; // zamknięcie okna przez menedżera okien
+    xcb_atom_t mWakeAtom = XCB_ATOM_NONE;         // destruktor budzi nim wątek okna
+    uint16_t mWidth = 0;
+    uint16_t mHeight = 0;
+    EventQueue mEvents;
+    std::atomic<uint64_t> mDroppedEvents {0};
+    std::thread mPumpThread;
 };
 #endif // _WIN32
 #endif // WINDOW_H